@@ -0,0 +1,211 @@
+#include "analysis.h"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "fusion.h"
+#include "utils.h"
+
+using namespace std;
+
+// The known bit of a register in AnalysisPath::known
+#define KNOWN(reg) (1u << (reg))
+#define ALL_KNOWN 0xFFFFu
+
+// One path through the program being interpreted
+struct AnalysisPath {
+	uint pc;		 // The index of the next instruction
+	uint executed;	 // The number of instructions executed to get here
+	Registers regs;	 // The register values (only meaningful where known)
+	uint known;		 // Which registers have known values
+	bool flagsKnown;
+};
+
+// Forgets the value of the register
+static void forget(AnalysisPath& path, uint reg) {
+	if (reg <= R15) {
+		path.known &= ~KNOWN(reg);
+	}
+}
+
+static bool isKnown(const AnalysisPath& path, uint reg) { return reg <= R15 && (path.known & KNOWN(reg)); }
+
+CostKind analyzeProgram(const Instruction* instructions, uint length, uint& cost) {
+	vector<AnalysisPath> paths;
+	AnalysisPath start;
+	uint steps = 0, longest = 0;
+	bool forked = false;
+
+	cost = length == 0 ? 0 : length - 1;
+
+	memset(&start.regs, 0, sizeof(Registers));	// Processes start with zeroed registers (see spawn)
+	start.pc = 0;
+	start.executed = 0;
+	start.known = ALL_KNOWN;
+	start.flagsKnown = true;
+	paths.push_back(start);
+
+	while (!paths.empty()) {
+		AnalysisPath path = paths.back();
+		paths.pop_back();
+
+		while (true) {
+			if (path.pc >= length || ++steps > ANALYSIS_STEP_LIMIT) {  // Ran off the program, or it's taking too long to tell
+				return COST_UNKNOWN;
+			}
+
+			const Instruction& instruction = instructions[path.pc];
+			uint* op1 = instruction.operand1 <= R15 ? getRegister(path.regs, (Regs)instruction.operand1) : nullptr;
+			uint* op2 = instruction.operand2 <= R15 ? getRegister(path.regs, (Regs)instruction.operand2) : nullptr;
+
+			if (instruction.opcode == Opcode::EXIT) {
+				if (path.executed > longest) {
+					longest = path.executed;
+				}
+				break;
+			}
+
+			path.executed++;
+			path.pc++;
+
+			switch (instruction.opcode) {
+				case Opcode::LOAD:
+					if (op2 != nullptr) {
+						*op2 = instruction.operand1;
+						path.known |= KNOWN(instruction.operand2);
+					}
+					break;
+				case Opcode::MOVE:
+					if (op1 != nullptr && op2 != nullptr) {
+						*op2 = *op1;
+						path.known = isKnown(path, instruction.operand1) ? path.known | KNOWN(instruction.operand2)
+																		 : path.known & ~KNOWN(instruction.operand2);
+					}
+					break;
+				case Opcode::INC:
+					if (op1 != nullptr) {
+						(*op1)++;
+					}
+					break;
+				case Opcode::CMP:
+					path.flagsKnown = isKnown(path, instruction.operand1) && isKnown(path, instruction.operand2);
+					if (path.flagsKnown) {
+						path.regs.flags &= (~FLAG_CY & ~FLAG_ZF);
+						if (*op1 == *op2) {
+							path.regs.flags |= (FLAG_CY | FLAG_ZF);
+						} else if (*op1 < *op2) {
+							path.regs.flags |= FLAG_CY;
+						}
+					}
+					break;
+				case Opcode::ADD:
+				case Opcode::SUB:
+					// The flags they set are only used by the jumps, so an ADD/SUB on unknown values makes the flags unknown too
+					path.flagsKnown = isKnown(path, instruction.operand1) && isKnown(path, instruction.operand2);
+					if (path.flagsKnown) {
+						uint src = *op1, dest = *op2;
+
+						path.regs.flags &= (~FLAG_CY & ~FLAG_ZF);
+						if (instruction.opcode == Opcode::ADD) {
+							if (dest > numeric_limits<uint>::max() - src) {
+								if (src != 0 && dest == numeric_limits<uint>::max() - src + 1) {
+									path.regs.flags |= FLAG_ZF;
+								}
+
+								path.regs.flags |= FLAG_CY;
+							}
+							*op2 = dest + src;
+						} else {
+							if (dest >= src) {
+								if (dest == src) {
+									path.regs.flags |= FLAG_ZF;
+								}
+
+								path.regs.flags |= FLAG_CY;
+							}
+							*op2 = dest - src;
+						}
+					} else {
+						forget(path, instruction.operand2);
+					}
+					break;
+				case Opcode::IO:
+					path.regs.rdi = instruction.operand1;
+					path.regs.rsi = instruction.operand2;
+					path.known |= KNOWN(RDI) | KNOWN(RSI);
+					break;
+				case Opcode::ALLOC:	 // The address goes into the register named by %rsi, and the size (or 0) into %rax
+					if (isKnown(path, RSI)) {
+						forget(path, path.regs.rsi);
+					} else {
+						path.known = 0;
+					}
+					forget(path, RAX);
+					break;
+				case Opcode::FREE:
+					forget(path, RAX);
+					break;
+				case Opcode::AIO:
+				case Opcode::AIOBATCH:
+					path.regs.rdi = instruction.operand1;
+					path.regs.rsi = instruction.opcode == Opcode::AIO ? 1 : instruction.operand2;
+					path.known |= KNOWN(RDI) | KNOWN(RSI);
+					forget(path, RAX);	// The handle
+					break;
+				case Opcode::AIOPOLL:
+				case Opcode::AIOWAIT:
+					if (op1 != nullptr) {
+						path.regs.rdi = *op1;
+					}
+					path.known = isKnown(path, instruction.operand1) ? path.known | KNOWN(RDI) : path.known & ~KNOWN(RDI);
+					path.regs.rax = 0;	// AIOWAIT always returns 0
+					path.known = instruction.opcode == Opcode::AIOWAIT ? path.known | KNOWN(RAX) : path.known & ~KNOWN(RAX);
+					break;
+				case Opcode::SEMINIT:
+					path.regs.rsi = instruction.operand2;
+					path.known |= KNOWN(RSI);
+					// fall through
+				case Opcode::LOCK:
+				case Opcode::UNLOCK:
+				case Opcode::SEMWAIT:
+				case Opcode::SEMPOST:
+					path.regs.rdi = instruction.operand1;
+					path.known |= KNOWN(RDI);
+					forget(path, RAX);	// 0, or -1 if misused
+					break;
+				case Opcode::JL:
+				case Opcode::JLE:
+				case Opcode::JE:
+				case Opcode::JGE:
+				case Opcode::JG: {
+					int offset = (int)instruction.operand1;
+					long target = (long)path.pc - 1 + offset / (int)sizeof(Instruction);
+
+					if (offset % (int)sizeof(Instruction) != 0 || target < 0 || target >= (long)length) {  // Jumps out of the program
+						if (!path.flagsKnown || jumpTaken(instruction.opcode, path.regs.flags)) {
+							return COST_UNKNOWN;
+						}
+						break;
+					}
+
+					if (!path.flagsKnown) {	 // Could go either way, so follow both
+						AnalysisPath taken = path;
+
+						taken.pc = target;
+						paths.push_back(taken);
+						forked = true;
+					} else if (jumpTaken(instruction.opcode, path.regs.flags)) {
+						path.pc = target;
+					}
+					break;
+				}
+				default:  // NOP, WORK and SW don't change registers
+					break;
+			}
+		}
+	}
+
+	cost = longest;
+	return forked ? COST_BOUNDED : COST_EXACT;
+}
@@ -0,0 +1,19 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "decls.h"
+
+// The most instructions the analysis of one program will interpret (over all paths) before giving up
+#define ANALYSIS_STEP_LIMIT (1 << 20)
+
+// Works out how many instructions a process running the program executes before its EXIT (not counting the EXIT itself), by interpreting
+// the program from the zeroed registers a process starts with and propagating the register values it can know: LOAD constants and the
+// INC/ADD/SUB/CMP on them, so that the bounds of counted loops are followed exactly
+// Values that only the kernel decides (what ALLOC, FREE and the asynchronous I/O calls return) are unknown, and a branch on flags that
+// depend on them follows both paths, making the result an upper bound
+// Returns COST_EXACT/COST_BOUNDED with the count in cost, or COST_UNKNOWN (cost = length - 1) if a path runs off the program, jumps out of
+// it, or the paths need more than ANALYSIS_STEP_LIMIT instructions (e.g. a loop waiting on an unknown value)
+// NOTE: stores to memory don't change registers, so they are assumed not to fault
+CostKind analyzeProgram(const Instruction* instructions, uint length, uint& cost);
+
+#endif
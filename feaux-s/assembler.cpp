@@ -0,0 +1,409 @@
+#include "assembler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "browser-api.h"
+
+using namespace std;
+
+// The names of the registers, in Regs order
+static const char* const REGISTER_NAMES[] = {"rax", "rcx", "rdx", "rbx", "rsi", "rdi", "rsp", "rbp",
+											 "r8",	"r9",  "r10", "r11", "r12", "r13", "r14", "r15"};
+
+// How a mnemonic's operands are read
+// OPERANDS_NONE = no operands
+// OPERANDS_NUMBER(_NUMBER) = one (or two) numbers
+// OPERANDS_NUMBER_REG = a number then a register
+// OPERANDS_REG(_REG) = one (or two) registers
+// OPERANDS_LABEL = a label (for jumps)
+enum OperandFormat { OPERANDS_NONE, OPERANDS_NUMBER, OPERANDS_NUMBER_NUMBER, OPERANDS_NUMBER_REG, OPERANDS_REG, OPERANDS_REG_REG, OPERANDS_LABEL };
+
+// A mnemonic and the instruction it assembles to (the macros work, alloc and free expand to more than one)
+struct Mnemonic {
+	const char* name;
+	Opcode opcode;
+	OperandFormat format;
+};
+
+static const Mnemonic MNEMONICS[] = {
+	{"nop", Opcode::NOP, OPERANDS_NONE},		  {"work", Opcode::WORK, OPERANDS_NUMBER},
+	{"io", Opcode::IO, OPERANDS_NUMBER_NUMBER},	  {"exit", Opcode::EXIT, OPERANDS_NONE},
+	{"ldi", Opcode::LOAD, OPERANDS_NUMBER_REG},	  {"mov", Opcode::MOVE, OPERANDS_REG_REG},
+	{"alloc", Opcode::ALLOC, OPERANDS_NUMBER_REG}, {"free", Opcode::FREE, OPERANDS_REG},
+	{"sw", Opcode::SW, OPERANDS_REG_REG},		  {"cmp", Opcode::CMP, OPERANDS_REG_REG},
+	{"jl", Opcode::JL, OPERANDS_LABEL},			  {"jle", Opcode::JLE, OPERANDS_LABEL},
+	{"je", Opcode::JE, OPERANDS_LABEL},			  {"jge", Opcode::JGE, OPERANDS_LABEL},
+	{"jg", Opcode::JG, OPERANDS_LABEL},			  {"inc", Opcode::INC, OPERANDS_REG},
+	{"add", Opcode::ADD, OPERANDS_REG_REG},		  {"sub", Opcode::SUB, OPERANDS_REG_REG},
+	{"aio", Opcode::AIO, OPERANDS_NUMBER},		  {"aiobatch", Opcode::AIOBATCH, OPERANDS_NUMBER_NUMBER},
+	{"aiopoll", Opcode::AIOPOLL, OPERANDS_REG},	  {"aiowait", Opcode::AIOWAIT, OPERANDS_REG},
+	{"lock", Opcode::LOCK, OPERANDS_NUMBER},	  {"unlock", Opcode::UNLOCK, OPERANDS_NUMBER},
+	{"semwait", Opcode::SEMWAIT, OPERANDS_NUMBER}, {"sempost", Opcode::SEMPOST, OPERANDS_NUMBER},
+	{"seminit", Opcode::SEMINIT, OPERANDS_NUMBER_NUMBER},
+};
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static bool tokenIs(const char* start, uint length, const char* word) { return strlen(word) == length && strncmp(start, word, length) == 0; }
+
+// Reads a (decimal, possibly negative) number, returning false if the token isn't one
+static bool parseNumber(const char* start, uint length, uint& value) {
+	bool negative = length > 0 && start[0] == '-';
+	uint i = negative ? 1 : 0;
+
+	if (i == length) {
+		return false;
+	}
+
+	value = 0;
+	for (; i < length; i++) {
+		if (start[i] < '0' || start[i] > '9') {
+			return false;
+		}
+		value = value * 10 + (start[i] - '0');
+	}
+
+	if (negative) {
+		value = -value;
+	}
+	return true;
+}
+
+static bool parseRegister(const char* start, uint length, uint& reg) {
+	for (reg = 0; reg <= R15; reg++) {
+		if (tokenIs(start, length, REGISTER_NAMES[reg])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static Instruction makeInstruction(Opcode opcode, uint operand1, uint operand2) {
+	Instruction instruction;
+
+	instruction.opcode = opcode;
+	instruction.operand1 = operand1;
+	instruction.operand2 = operand2;
+	return instruction;
+}
+
+bool Assembler::_findLabel(const Token& name, uint& index) const {
+	for (const Label& label : _labels) {
+		if (label.name.length == name.length && strncmp(label.name.start, name.start, name.length) == 0) {
+			index = label.index;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Assembler::assemble(const char* source, size_t size, vector<Instruction>& instructions) {
+	const char* end = source + size;
+	uint line = 0;
+
+	instructions.clear();
+	_labels.clear();
+	_patches.clear();
+
+	for (const char* cursor = source; cursor < end;) {
+		Token tokens[4];
+		uint numTokens = 0;
+
+		line++;
+
+		// Split the line into (at most 4) tokens, stopping at a comment
+		while (cursor < end && *cursor != '\n') {
+			if (isSpace(*cursor)) {
+				cursor++;
+			} else if (*cursor == ';') {
+				while (cursor < end && *cursor != '\n') cursor++;
+			} else {
+				const char* start = cursor;
+
+				while (cursor < end && *cursor != '\n' && *cursor != ';' && !isSpace(*cursor)) cursor++;
+
+				if (numTokens == 4) {
+					cerr << "Debug: assembler error on line " << line << ": too many operands" << endl;
+					return false;
+				}
+				tokens[numTokens].start = start;
+				tokens[numTokens].length = cursor - start;
+				numTokens++;
+			}
+		}
+		cursor++;  // Skip the newline
+
+		if (numTokens == 0) {
+			continue;
+		}
+
+		// Labels
+		if (numTokens == 1 && tokens[0].length > 1 && tokens[0].start[tokens[0].length - 1] == ':') {
+			Label label;
+			uint existing;
+
+			label.name.start = tokens[0].start;
+			label.name.length = tokens[0].length - 1;
+			label.index = instructions.size();
+
+			if (_findLabel(label.name, existing)) {
+				cerr << "Debug: assembler error on line " << line << ": label " << string(label.name.start, label.name.length) << " is already defined"
+					 << endl;
+				return false;
+			}
+			_labels.push_back(label);
+			continue;
+		}
+
+		const Mnemonic* mnemonic = nullptr;
+		for (const Mnemonic& candidate : MNEMONICS) {
+			if (tokenIs(tokens[0].start, tokens[0].length, candidate.name)) {
+				mnemonic = &candidate;
+				break;
+			}
+		}
+
+		if (mnemonic == nullptr) {
+			cerr << "Debug: assembler error on line " << line << ": unrecognized mnemonic " << string(tokens[0].start, tokens[0].length) << endl;
+			return false;
+		}
+
+		// Read the operands
+		uint operands[2] = {0, 0}, required = 0, allowed = 0;
+		bool valid = true;
+
+		switch (mnemonic->format) {
+			case OPERANDS_NONE:
+				break;
+			case OPERANDS_NUMBER:
+			case OPERANDS_REG:
+			case OPERANDS_LABEL:
+				required = allowed = 1;
+				break;
+			case OPERANDS_NUMBER_NUMBER:
+				required = mnemonic->opcode == Opcode::IO ? 1 : 2;	// The block of an I/O request is optional
+				allowed = 2;
+				operands[1] = NO_BLOCK;
+				break;
+			case OPERANDS_NUMBER_REG:
+			case OPERANDS_REG_REG:
+				required = allowed = 2;
+				break;
+		}
+
+		if (numTokens - 1 < required || numTokens - 1 > allowed) {
+			cerr << "Debug: assembler error on line " << line << ": " << mnemonic->name << " takes " << required;
+			if (allowed != required) {
+				cerr << " or " << allowed;
+			}
+			cerr << " operand(s)" << endl;
+			return false;
+		}
+
+		for (uint i = 1; i < numTokens && mnemonic->format != OPERANDS_LABEL; i++) {
+			bool isRegister = mnemonic->format == OPERANDS_REG || mnemonic->format == OPERANDS_REG_REG ||
+							  (mnemonic->format == OPERANDS_NUMBER_REG && i == 2);
+
+			valid = isRegister ? parseRegister(tokens[i].start, tokens[i].length, operands[i - 1])
+							   : parseNumber(tokens[i].start, tokens[i].length, operands[i - 1]);
+			if (!valid) {
+				cerr << "Debug: assembler error on line " << line << ": expected a " << (isRegister ? "register" : "number") << ", got "
+					 << string(tokens[i].start, tokens[i].length) << endl;
+				return false;
+			}
+		}
+
+		// Emit the instruction(s)
+		switch (mnemonic->opcode) {
+			case Opcode::WORK:
+				instructions.insert(instructions.end(), operands[0], makeInstruction(Opcode::WORK, 0, 0));
+				break;
+			case Opcode::ALLOC:	 // The kernel takes the size in %rdi and the register to put the address in from %rsi
+				instructions.push_back(makeInstruction(Opcode::LOAD, operands[0], Regs::RDI));
+				instructions.push_back(makeInstruction(Opcode::LOAD, operands[1], Regs::RSI));
+				instructions.push_back(makeInstruction(Opcode::ALLOC, 0, 0));
+				break;
+			case Opcode::FREE:	// The kernel takes the register holding the address from %rdi
+				instructions.push_back(makeInstruction(Opcode::LOAD, operands[0], Regs::RDI));
+				instructions.push_back(makeInstruction(Opcode::FREE, 0, 0));
+				break;
+			case Opcode::JL:
+			case Opcode::JLE:
+			case Opcode::JE:
+			case Opcode::JGE:
+			case Opcode::JG: {
+				Patch patch;
+
+				patch.label = tokens[1];
+				patch.index = instructions.size();
+				patch.line = line;
+				_patches.push_back(patch);
+				instructions.push_back(makeInstruction(mnemonic->opcode, 0, 0));
+				break;
+			}
+			default:
+				instructions.push_back(makeInstruction(mnemonic->opcode, operands[0], operands[1]));
+				break;
+		}
+	}
+
+	if (instructions.empty() || instructions.back().opcode != Opcode::EXIT) {
+		instructions.push_back(makeInstruction(Opcode::EXIT, 0, 0));
+	}
+
+	// Resolve jumps into the byte offsets the CPU adds to the address of the jump
+	for (const Patch& patch : _patches) {
+		uint target;
+
+		if (!_findLabel(patch.label, target)) {
+			cerr << "Debug: assembler error on line " << patch.line << ": unknown label " << string(patch.label.start, patch.label.length) << endl;
+			return false;
+		}
+
+		instructions[patch.index].operand1 = ((int)target - (int)patch.index) * (int)sizeof(Instruction);
+	}
+
+	return true;
+}
+
+uint loadProgramFile(const char* path, const char* name) {
+	static vector<char> source;	 // Reused between calls, so that loading many files doesn't allocate for each one
+
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		cerr << "Debug: unable to open program file " << path << endl;
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	source.resize(length > 0 ? length : 0);
+	size_t read = length > 0 ? fread(source.data(), 1, length, file) : 0;
+	fclose(file);
+
+	uint size = loadProgramSource(source.data(), read, name);
+	if (size == 0) {
+		cerr << "Debug: unable to assemble program file " << path << endl;
+	}
+	return size;
+}
+
+std::string disassemble(const Instruction* instructions, uint length) {
+	vector<bool> targets(length, false);
+	string source;
+	char line[64];
+
+	// Find the jump targets first, so that each can be labelled as it's reached
+	for (uint i = 0; i < length; i++) {
+		if (instructions[i].opcode >= Opcode::JL && instructions[i].opcode <= Opcode::JG) {
+			long target = (long)i + (int)instructions[i].operand1 / (int)sizeof(Instruction);
+
+			if (target >= 0 && target < length) {
+				targets[target] = true;
+			}
+		}
+	}
+
+	for (uint i = 0; i < length; i++) {
+		const Instruction& instruction = instructions[i];
+		const char* name = MNEMONICS[0].name;
+		bool reg1 = instruction.operand1 <= R15, reg2 = instruction.operand2 <= R15;
+
+		for (const Mnemonic& mnemonic : MNEMONICS) {
+			if (mnemonic.opcode == instruction.opcode) {
+				name = mnemonic.name;
+				break;
+			}
+		}
+
+		if (targets[i]) {
+			snprintf(line, sizeof(line), "L%u:\n", i);
+			source += line;
+		}
+
+		switch (instruction.opcode) {
+			case Opcode::NOP:
+			case Opcode::EXIT:
+				snprintf(line, sizeof(line), "%s\n", name);
+				break;
+			case Opcode::WORK:
+				snprintf(line, sizeof(line), "work 1\n");
+				break;
+			case Opcode::IO:
+				if (instruction.operand2 == NO_BLOCK) {
+					snprintf(line, sizeof(line), "io %u\n", instruction.operand1);
+				} else {
+					snprintf(line, sizeof(line), "io %u %u\n", instruction.operand1, instruction.operand2);
+				}
+				break;
+			case Opcode::AIO:
+				snprintf(line, sizeof(line), "aio %u\n", instruction.operand1);
+				break;
+			case Opcode::AIOBATCH:
+				snprintf(line, sizeof(line), "aiobatch %u %u\n", instruction.operand1, instruction.operand2);
+				break;
+			case Opcode::LOCK:
+			case Opcode::UNLOCK:
+			case Opcode::SEMWAIT:
+			case Opcode::SEMPOST:
+				snprintf(line, sizeof(line), "%s %u\n", name, instruction.operand1);
+				break;
+			case Opcode::SEMINIT:
+				snprintf(line, sizeof(line), "seminit %u %u\n", instruction.operand1, instruction.operand2);
+				break;
+			case Opcode::LOAD:
+				if (reg2) {
+					snprintf(line, sizeof(line), "ldi %u %s\n", instruction.operand1, REGISTER_NAMES[instruction.operand2]);
+				} else {
+					snprintf(line, sizeof(line), "; ldi %u %u (register out of range)\n", instruction.operand1, instruction.operand2);
+				}
+				break;
+			case Opcode::INC:
+			case Opcode::AIOPOLL:
+			case Opcode::AIOWAIT:
+				if (reg1) {
+					snprintf(line, sizeof(line), "%s %s\n", name, REGISTER_NAMES[instruction.operand1]);
+				} else {
+					snprintf(line, sizeof(line), "; %s %u (register out of range)\n", name, instruction.operand1);
+				}
+				break;
+			case Opcode::MOVE:
+			case Opcode::SW:
+			case Opcode::CMP:
+			case Opcode::ADD:
+			case Opcode::SUB:
+				if (reg1 && reg2) {
+					snprintf(line, sizeof(line), "%s %s %s\n", name, REGISTER_NAMES[instruction.operand1], REGISTER_NAMES[instruction.operand2]);
+				} else {
+					snprintf(line, sizeof(line), "; %s %u %u (registers out of range)\n", name, instruction.operand1, instruction.operand2);
+				}
+				break;
+			case Opcode::JL:
+			case Opcode::JLE:
+			case Opcode::JE:
+			case Opcode::JGE:
+			case Opcode::JG: {
+				long target = (long)i + (int)instruction.operand1 / (int)sizeof(Instruction);
+
+				if (target >= 0 && target < length) {
+					snprintf(line, sizeof(line), "%s L%ld\n", name, target);
+				} else {
+					snprintf(line, sizeof(line), "; %s %d (out of the program)\n", name, (int)instruction.operand1);
+				}
+				break;
+			}
+			default:  // ALLOC/FREE only come from the alloc/free macros, which load their operands first
+				snprintf(line, sizeof(line), "; %s\n", name);
+				break;
+		}
+		source += line;
+	}
+
+	return source;
+}
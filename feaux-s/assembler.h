@@ -0,0 +1,67 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "decls.h"
+
+// Assembles programs written in the .fsp text format (the same one the browser's program editor compiles), one statement per line:
+//   label:            marks the next instruction as a jump target (jumps may refer to labels further down)
+//   work N            N WORK instructions
+//   io N [block]      an I/O request of size N (at the given block, or anywhere in the process's region)
+//   ldi N reg         LOAD
+//   mov src dest      MOVE
+//   inc reg / add src dest / sub src dest / cmp a b
+//   jl/jle/je/jge/jg label
+//   alloc N reg       allocates N bytes, putting the address in reg (expands to loading %rdi/%rsi and an ALLOC)
+//   free reg          frees the allocation at the address in reg (expands to loading %rdi and a FREE)
+//   sw src addr       stores the low byte of src at the address in addr
+//   aio N / aiobatch N count / aiopoll reg / aiowait reg
+//   lock id / unlock id / seminit id count / semwait id / sempost id (see sync.h)
+//   nop / exit
+// Anything after a ';' is a comment. An EXIT is appended if the program doesn't end with one
+// Assembling is a single pass over the source: tokens are read in place, and jumps to labels that haven't been seen yet are patched once
+// the whole program has been read, so the only allocations are the (reused) label and patch tables and the output
+class Assembler {
+public:
+	// Assembles the source into instructions (replacing the contents of the list)
+	// Returns false (after reporting the offending line) if the source has errors
+	bool assemble(const char* source, size_t size, std::vector<Instruction>& instructions);
+
+private:
+	// A span of the source (tokens aren't copied out of it)
+	struct Token {
+		const char* start;
+		uint length;
+	};
+
+	struct Label {
+		Token name;
+		uint index;	 // The instruction it marks
+	};
+
+	// A jump whose label needs resolving
+	struct Patch {
+		Token label;
+		uint index;	 // The jump instruction
+		uint line;
+	};
+
+	std::vector<Label> _labels;
+	std::vector<Patch> _patches;
+
+	// Finds the instruction a label marks (returns false if there's no such label)
+	bool _findLabel(const Token& name, uint& index) const;
+};
+
+// Reads and assembles an .fsp file, loading it as a program with the given name
+// Returns the number of instructions loaded (0 if the file can't be read or has errors)
+uint loadProgramFile(const char* path, const char* name);
+
+// Writes instructions back out as .fsp source, which assembles to the same instructions (jump targets get labels named after their
+// index); instructions with no .fsp form (ALLOC/FREE on their own, registers out of range, jumps out of the program) are left as comments
+std::string disassemble(const Instruction* instructions, uint length);
+
+#endif
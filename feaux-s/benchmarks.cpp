@@ -1,19 +1,240 @@
 #include "benchmarks.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+#include "fuzz.h"
+#include "profiler.h"
+
 using namespace std;
 
 struct {
 	double usedCPUTime;
 	double totalCPUTime;
+	bool shareMeasured;	 // Whether the suite measured how far the CPU shares of its processes were from their ticket shares
+	double shareError;	 // (as the % of CPU time that would have to move between processes to match the ticket shares)
 } stats;
 
+static const SchedulingStrategy STRATEGIES[] = {SchedulingStrategy::FIFO,	 SchedulingStrategy::SJF,	  SchedulingStrategy::SRT,
+												SchedulingStrategy::MLF,	 SchedulingStrategy::CFS,	  SchedulingStrategy::LOTTERY,
+												SchedulingStrategy::STRIDE, SchedulingStrategy::SJF_PREDICTED, SchedulingStrategy::SRT_PREDICTED};
+#define NUM_STRATEGIES (sizeof(STRATEGIES) / sizeof(SchedulingStrategy))
+// The real-time strategies, with partitioned EDF run once per bin-packing heuristic (the others ignore it)
+static const struct {
+	SchedulingStrategy strategy;
+	PartitionHeuristic heuristic;
+} RT_STRATEGIES[] = {{SchedulingStrategy::RT_FIFO, PartitionHeuristic::FIRST_FIT_DECREASING},
+					 {SchedulingStrategy::RT_EDF, PartitionHeuristic::FIRST_FIT_DECREASING},
+					 {SchedulingStrategy::RT_LST, PartitionHeuristic::FIRST_FIT_DECREASING},
+					 {SchedulingStrategy::RT_PEDF, PartitionHeuristic::FIRST_FIT_DECREASING},
+					 {SchedulingStrategy::RT_PEDF, PartitionHeuristic::WORST_FIT_DECREASING}};
+#define NUM_RT_STRATEGIES (sizeof(RT_STRATEGIES) / sizeof(RT_STRATEGIES[0]))
+
+// The number of strategies the suite is run through, and the ith of them
+static uint numStrategies(const BenchmarkSuite* suite) {
+	return suite->realTime ? NUM_RT_STRATEGIES : NUM_STRATEGIES;
+}
+static SchedulingStrategy suiteStrategy(const BenchmarkSuite* suite, uint i) {
+	return suite->realTime ? RT_STRATEGIES[i].strategy : STRATEGIES[i];
+}
+
+// The name of the current run's strategy (with the bin-packing heuristic, for partitioned EDF)
+static string strategyName() {
+	string name = STRATEGY_NAME(state->strategy);
+
+	if (state->strategy == SchedulingStrategy::RT_PEDF) {
+		name += state->partitionHeuristic == PartitionHeuristic::FIRST_FIT_DECREASING ? " (First-Fit Decreasing)" : " (Worst-Fit Decreasing)";
+	}
+	return name;
+}
+
+// The measurements in the machine-readable output (after the suite and strategy)
+static const char* const BENCHMARK_COLUMNS[] = {"cores",		   "devices",	  "processes",	 "ticks",	   "seconds",		  "ticksPerSecond",
+												"att",			   "utilization", "maxTT",		 "minTT",	   "p95TT",			  "fairness",
+												"contextSwitches", "preemptions", "switchTicks", "ioRequests", "pageFaults",	  "shareError",
+												"burstPredictionError", "deadlineMissRatio", "migrations", "lockAcquisitions", "contendedLocks",
+												"avgLockHold", "avgLockWait", "maxLockWait", "semaphoreWaitTicks", "inheritances"};
+
+// Runs with more processes than this only have the digest of their processes' outcomes in the golden results (to keep the files small)
+#define GOLDEN_LISTED_PROCESSES 4096
+
+// The golden results of a run (see benchmarks.h)
+struct GoldenRun {
+	string summary;			   // The machine, the number of processes, and a digest of their outcomes
+	vector<string> processes;  // The outcome of each process, as "pid state doneTime processorTime" (if there are few enough to list)
+};
+
+// What the benchmarks were asked to run (see benchmarks.h), and how far they've got
+static struct {
+	vector<const BenchmarkSuite*> suites;
+	uint8_t numCores;
+	uint8_t numIODevices;
+	BenchmarkFormat format;
+	string profileTrace;  // Where to write the profiler's trace ("" = nowhere)
+	string goldenDir;	  // Where the golden results are ("" = not checking them)
+	bool updateGolden;	  // Whether to record the golden results rather than check them
+
+	map<string, GoldenRun> golden;	// The current suite's golden results, by strategy
+	string goldenContents;			// (or the golden file being recorded for it)
+	uint goldenRuns;				// The runs checked against their golden results so far
+	uint goldenFailures;			// The ones that didn't match (or golden files that couldn't be written)
+
+	uint suite;	 // The current run (index into suites, and STRATEGIES)
+	uint strategy;
+	bool started;
+	chrono::steady_clock::time_point start;	 // When the current run started
+} runs;
+
+// Writes a number for the machine-readable formats (which have no way to write infinities or NaNs, so those are left empty/null)
+static void writeNumber(double value) {
+	if (std::isfinite(value)) {
+		cout << value;
+	} else if (runs.format == BenchmarkFormat::FORMAT_JSON) {
+		cout << "null";
+	}
+}
+
+static const char* const STATE_NAMES[] = {"ready", "processing", "blocked", "done", "dead"};
+
+static string goldenPath(const BenchmarkSuite* suite) {
+	return runs.goldenDir + "/" + (suite->id < 10 ? "0" : "") + to_string(suite->id) + "-" + suite->name + ".golden";
+}
+
+// The outcome of the run that just finished
+static GoldenRun goldenRun() {
+	GoldenRun run;
+	uint64_t digest = 14695981039346656037ull;	// FNV-1a, over every process's line
+	char line[96];
+
+	for (PCB* proc : state->processList) {
+		snprintf(line, sizeof(line), "%u %s %ld %ld", proc->pid, STATE_NAMES[proc->state()], proc->doneTime(), proc->processorTime());
+		for (const char* c = line; *c != '\0'; c++) {
+			digest = (digest ^ (uint8_t)*c) * 1099511628211ull;
+		}
+		digest = (digest ^ '\n') * 1099511628211ull;
+
+		if (state->processList.size() <= GOLDEN_LISTED_PROCESSES) {
+			run.processes.push_back(line);
+		}
+	}
+
+	snprintf(line, sizeof(line), "cores %u devices %u processes %u digest %016llx", machine->numCores, machine->numIODevices,
+			 (uint)state->processList.size(), (unsigned long long)digest);
+	run.summary = line;
+	return run;
+}
+
+// Reads a suite's golden results into runs.golden (which is left empty if there are none)
+static void loadGolden(const BenchmarkSuite* suite) {
+	ifstream file(goldenPath(suite));
+	string line;
+	GoldenRun* run = nullptr;
+
+	runs.golden.clear();
+	while (getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		if (line.compare(0, 9, "strategy ") == 0) {
+			run = &runs.golden[line.substr(9)];
+		} else if (line.compare(0, 6, "cores ") == 0 && run != nullptr) {
+			run->summary = line;
+		} else if (run != nullptr) {
+			run->processes.push_back(line);
+		}
+	}
+}
+
+// Checks the run that just finished against its golden results, reporting (on stderr) where they differ, or records them with
+// --update-golden (writing out each suite's file after its last run)
+static void checkGolden() {
+	const BenchmarkSuite* suite = runs.suites[runs.suite];
+	string strategy = strategyName();
+	GoldenRun actual = goldenRun();
+
+	if (runs.updateGolden) {
+		if (runs.strategy == 0) {
+			runs.goldenContents = "# Golden results of benchmark suite " + to_string(suite->id) + " (" + suite->name +
+								  "): for each strategy, the outcome of every process\n# (pid state doneTime processorTime, unless there are over " +
+								  to_string(GOLDEN_LISTED_PROCESSES) + " processes)\n";
+		}
+
+		runs.goldenContents += "strategy " + strategy + "\n" + actual.summary + "\n";
+		for (const string& line : actual.processes) runs.goldenContents += line + "\n";
+
+		if (runs.strategy == numStrategies(suite) - 1) {
+			ofstream file(goldenPath(suite), ios::binary);
+
+			if (!(file << runs.goldenContents) || !file.flush()) {
+				cerr << "Debug: unable to write golden results " << goldenPath(suite) << endl;
+				runs.goldenFailures++;
+			}
+		}
+		return;
+	}
+
+	if (runs.strategy == 0) {
+		loadGolden(suite);
+	}
+	runs.goldenRuns++;
+
+	auto it = runs.golden.find(strategy);
+	if (it == runs.golden.end()) {
+		cerr << "Golden: suite " << suite->id << " (" << suite->name << ") " << strategy << " has no golden results in " << goldenPath(suite)
+			 << endl;
+		runs.goldenFailures++;
+		return;
+	}
+
+	const GoldenRun& expected = it->second;
+	if (expected.summary == actual.summary && expected.processes == actual.processes) {
+		return;
+	}
+
+	// Point out the first process whose outcome changed (or the summaries, if the processes aren't listed)
+	size_t i = 0;
+	while (i < expected.processes.size() && i < actual.processes.size() && expected.processes[i] == actual.processes[i]) i++;
+
+	cerr << "Golden: suite " << suite->id << " (" << suite->name << ") " << strategy << " differs: ";
+	if (i < expected.processes.size() || i < actual.processes.size()) {
+		cerr << "expected \"" << (i < expected.processes.size() ? expected.processes[i] : "(no process)") << "\", got \""
+			 << (i < actual.processes.size() ? actual.processes[i] : "(no process)") << "\"" << endl;
+	} else {
+		cerr << "expected " << expected.summary << ", got " << actual.summary << endl;
+	}
+	runs.goldenFailures++;
+}
+
 void printStats() {
-	cout << "Strategy: " << STRATEGY_NAME(state->strategy) << endl;
+	if (!runs.goldenDir.empty()) {
+		checkGolden();
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - runs.start).count();
+	const BenchmarkSuite* suite = runs.suites[runs.suite];
 
-	double totalTT = 0, maxTT = -INFINITY, minTT = INFINITY;
-	for (auto it = state->processList.begin(); it != state->processList.end(); it++) {
-		double tt = (*it)->doneTime - (*it)->arrivalTime;
+	// (fairness is Jain's index over slowdowns: 1 = waiting was spread so that every process was slowed down equally)
+	double totalTT = 0, maxTT = -INFINITY, minTT = INFINITY, totalSlowdown = 0, totalSquaredSlowdown = 0;
+	uint deadlines = 0, deadlineMisses = 0;	 // The processes with a deadline, and the ones that finished after it
+	vector<double> tts;
+	const ProcessColumns& columns = state->columns;	 // (in the same order as the process list)
+	for (uint slot = 0; slot < columns.size(); slot++) {
+		double tt = columns.doneTime[slot] - columns.arrivalTime[slot], slowdown = tt / max(columns.processorTime[slot], 1l);
 		totalTT += tt;
+		totalSlowdown += slowdown;
+		totalSquaredSlowdown += slowdown * slowdown;
+		tts.push_back(tt);
+
+		if (columns.deadline[slot] != -1) {
+			deadlines++;
+			deadlineMisses += columns.doneTime[slot] > columns.deadline[slot];
+		}
 
 		if (tt < minTT) {
 			minTT = tt;
@@ -24,18 +245,142 @@ void printStats() {
 	}
 	double att = totalTT / state->processList.size();
 
+	sort(tts.begin(), tts.end());
+	double p95TT = tts.empty() ? NAN : tts[min(tts.size() * 95 / 100, tts.size() - 1)];
+	double fairness = totalSlowdown * totalSlowdown / (state->processList.size() * totalSquaredSlowdown);
+	double utilization = stats.usedCPUTime / stats.totalCPUTime * 100;
+	const SyncStats& sync = state->syncStats;
+	double avgLockHold = sync.lockAcquisitions > 0 ? (double)sync.lockHoldTicks / sync.lockAcquisitions : NAN;
+	double avgLockWait = sync.lockAcquisitions > 0 ? (double)sync.lockWaitTicks / sync.lockAcquisitions : NAN;	 // (over every acquisition)
+
+	if (runs.format != BenchmarkFormat::FORMAT_TEXT) {
+		// One row/object per run, in the order of BENCHMARK_COLUMNS
+		unsigned long long ioRequests = 0;
+		for (uint i = 0; i < machine->numIODevices; i++) {
+			ioRequests += machine->ioDevices[i]->completed();
+		}
+
+		double values[] = {(double)machine->numCores,
+						   (double)machine->numIODevices,
+						   (double)state->processList.size(),
+						   (double)state->time,
+						   seconds,
+						   state->time / seconds,
+						   att,
+						   utilization,
+						   maxTT,
+						   minTT,
+						   p95TT,
+						   fairness,
+						   (double)state->contextSwitches,
+						   (double)state->preemptions,
+						   (double)state->switchTicks,
+						   (double)ioRequests,
+						   (double)(machine->memory->minorFaults() + machine->memory->majorFaults()),
+						   stats.shareMeasured ? stats.shareError : NAN,
+						   (state->strategy == SchedulingStrategy::SJF_PREDICTED || state->strategy == SchedulingStrategy::SRT_PREDICTED) &&
+								   state->predictedBursts > 0
+							   ? state->burstPredictionError / state->predictedBursts
+							   : NAN,
+						   deadlines > 0 ? (double)deadlineMisses / deadlines : NAN,
+						   (double)state->migrations,
+						   (double)sync.lockAcquisitions,
+						   (double)sync.contendedLocks,
+						   avgLockHold,
+						   avgLockWait,
+						   (double)sync.maxLockWait,
+						   (double)sync.semaphoreWaitTicks,
+						   (double)sync.inheritances};
+
+		if (runs.format == BenchmarkFormat::FORMAT_JSON) {
+			cout << (runs.suite == 0 && runs.strategy == 0 ? "  " : ",\n  ") << "{\"suite\": " << suite->id << ", \"name\": \"" << suite->name
+				 << "\", \"strategy\": \"" << strategyName() << "\"";
+			for (uint i = 0; i < sizeof(values) / sizeof(double); i++) {
+				cout << ", \"" << BENCHMARK_COLUMNS[i] << "\": ";
+				writeNumber(values[i]);
+			}
+			cout << "}";
+		} else {
+			cout << suite->id << "," << suite->name << "," << strategyName();
+			for (uint i = 0; i < sizeof(values) / sizeof(double); i++) {
+				cout << ",";
+				writeNumber(values[i]);
+			}
+			cout << "\n";
+		}
+		return;
+	}
+
+	cout << "Strategy: " << strategyName() << endl;
+
 	cout << "ATT: " << att << " quanta\n"
-		 << "CPU Utilization: " << stats.usedCPUTime / stats.totalCPUTime * 100 << "%\n"
+		 << "CPU Utilization: " << utilization << "%\n"
 		 << "Max TT: " << maxTT << " quanta\n"
 		 << "Min TT: " << minTT << " quanta\n"
-		 << endl;
-}
+		 << "P95 TT: " << p95TT << " quanta\n"
+		 << "Fairness: " << fairness << "\n";
 
-#if FEAUX_S_BENCHMARKING == 1
-bool simulate() {
-	stats.totalCPUTime += 2;
-	stats.usedCPUTime += !machine->cores[0]->free() + !machine->cores[1]->free();
+	for (uint i = 0; i < machine->numIODevices; i++) {
+		IODevice* device = machine->ioDevices[i];
+
+		if (device->completed() > 0) {
+			cout << "I/O Device " << i << ": " << device->completed() << " requests, avg wait " << (double)device->totalWait() / device->completed()
+				 << " quanta, avg service " << (double)device->totalService() / device->completed() << " quanta, max wait " << device->maxWait()
+				 << " quanta\n";
+		}
+	}
+
+	if (machine->memory->minorFaults() + machine->memory->majorFaults() > 0) {
+		cout << "Page faults: " << machine->memory->minorFaults() << " minor, " << machine->memory->majorFaults() << " major, "
+			 << machine->memory->evictions() << " evictions, " << machine->memory->faultTicks() << " quanta stalled\n";
+	}
+
+	for (uint i = 0; i < machine->numCores; i++) {
+		CPU* cpu = machine->cores[i];
+
+		if (cpu->cacheConfig().enabled) {
+			cout << "Core " << i << " caches: L1 " << cpu->l1().misses() << "/" << cpu->l1().hits() + cpu->l1().misses() << " misses, L2 "
+				 << cpu->l2().misses() << "/" << cpu->l2().hits() + cpu->l2().misses() << " misses, TLB " << cpu->tlb().misses() << "/"
+				 << cpu->tlb().hits() + cpu->tlb().misses() << " misses, " << cpu->cacheStallTicks() << " quanta stalled\n";
+		}
+	}
+
+	if ((state->strategy == SchedulingStrategy::SJF_PREDICTED || state->strategy == SchedulingStrategy::SRT_PREDICTED) && state->predictedBursts > 0) {
+		cout << "Burst prediction error: " << state->burstPredictionError / state->predictedBursts << " quanta (static cost: "
+			 << state->oracleBurstError / state->predictedBursts << " quanta, over " << state->predictedBursts << " bursts)\n";
+	}
+
+	if (stats.shareMeasured) {
+		cout << "Share error: " << stats.shareError << "%\n";
+	}
+
+	if (deadlines > 0) {
+		cout << "Deadline misses: " << deadlineMisses << " of " << deadlines << " (" << (double)deadlineMisses / deadlines * 100 << "%), "
+			 << state->preemptions << " preemptions, " << state->migrations << " migrations\n";
+	}
 
+	if (sync.lockAcquisitions > 0) {
+		cout << "Locks: " << sync.lockAcquisitions << " acquisitions (" << sync.contendedLocks << " contended), avg hold " << avgLockHold
+			 << " quanta, avg wait " << avgLockWait << " quanta, max wait " << sync.maxLockWait << " quanta";
+		if (state->priorityInheritance) {
+			cout << ", " << sync.inheritances << " inheritances";
+		}
+		cout << "\n";
+	}
+	if (sync.semaphoreWaits > 0) {
+		cout << "Semaphores: " << sync.semaphoreWaits << " waits, avg wait " << (double)sync.semaphoreWaitTicks / sync.semaphoreWaits << " quanta\n";
+	}
+
+	const ContextSwitchConfig& switchCost = state->switchCost;
+	if (switchCost.fixedTicks + switchCost.registerTicks + switchCost.cacheWarmupTicks > 0) {
+		cout << "Context switches: " << state->contextSwitches << " (" << state->preemptions << " preemptions), " << state->switchTicks
+			 << " quanta lost\n";
+	}
+
+	cout << endl;
+}
+
+static bool suite1() {
 	if (state->time == 1) {
 		Instruction workerInstructions[10] = {
 			{Opcode::WORK, 0, 0}, {Opcode::WORK, 0, 0}, {Opcode::WORK, 0, 0}, {Opcode::WORK, 0, 0}, {Opcode::WORK, 0, 0},
@@ -48,20 +393,17 @@ bool simulate() {
 		stats.usedCPUTime = 0;
 		stats.totalCPUTime = 0;
 
-		spawn(workerName);
-		spawn(workerName);
-		spawn(workerName);
-		spawn(workerName);
-		spawn(workerName);
+		spawn(workerName, -1);
+		spawn(workerName, -1);
+		spawn(workerName, -1);
+		spawn(workerName, -1);
+		spawn(workerName, -1);
 		return true;
 	}
 	return false;
 }
-#elif FEAUX_S_BENCHMARKING == 2
-bool simulate() {
-	stats.totalCPUTime += 2;
-	stats.usedCPUTime += !machine->cores[0]->free() + !machine->cores[1]->free();
 
+static bool suite2() {
 	if (state->time == 1) {
 		Instruction shortWorkerInstructions[10] =
 			{
@@ -86,15 +428,15 @@ bool simulate() {
 		stats.usedCPUTime = 0;
 		stats.totalCPUTime = 0;
 
-		spawn(longWorkerName);
-		spawn(longWorkerName);
-		spawn(workerName);
+		spawn(longWorkerName, -1);
+		spawn(longWorkerName, -1);
+		spawn(workerName, -1);
 		return true;
 	}
 
 	if (state->time % 10 == 0 && state->time <= 300) {
 		char workerName[] = "worker";
-		spawn(workerName);
+		spawn(workerName, -1);
 	}
 
 	if (state->time <= 300) {
@@ -103,11 +445,8 @@ bool simulate() {
 
 	return false;
 }
-#elif FEAUX_S_BENCHMARKING == 3
-bool simulate() {
-	stats.totalCPUTime += 2;
-	stats.usedCPUTime += !machine->cores[0]->free() + !machine->cores[1]->free();
 
+static bool suite3() {
 	if (state->time == 1) {
 		Instruction workerInstructions[5] =
 			{
@@ -127,17 +466,17 @@ bool simulate() {
 		stats.usedCPUTime = 0;
 		stats.totalCPUTime = 0;
 
-		spawn(workerName);
-		spawn(workerName);
-		spawn(longWorkerName);
-		spawn(longWorkerName);
+		spawn(workerName, -1);
+		spawn(workerName, -1);
+		spawn(longWorkerName, -1);
+		spawn(longWorkerName, -1);
 		return true;
 	}
 
 	if (state->time % 2 == 0 && state->time <= 6) {
 		char name[] = "short worker";
-		spawn(name);
-		spawn(name);
+		spawn(name, -1);
+		spawn(name, -1);
 	}
 
 	if (state->time <= 6) {
@@ -146,4 +485,880 @@ bool simulate() {
 
 	return false;
 }
-#endif
\ No newline at end of file
+
+// I/O-bound workload (more-io.fsp) on a simulated disk, with each process's data in its own region of the disk
+static bool suite4() {
+	if (state->time == 1) {
+		Instruction ioWorkerInstructions[33];
+
+		for (int i = 0; i < 33; i++) {
+			ioWorkerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		ioWorkerInstructions[10] = Instruction{Opcode::IO, 5, NO_BLOCK};
+		ioWorkerInstructions[21] = Instruction{Opcode::IO, 5, NO_BLOCK};
+		ioWorkerInstructions[32] = Instruction{Opcode::EXIT, 0, 0};
+
+		char ioWorkerName[] = "io worker";
+		loadProgram(ioWorkerInstructions, 33, ioWorkerName);
+
+		configureIODevice(0, defaultIODeviceConfig(IODeviceClass::DISK));
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 20; i++) {
+			spawn(ioWorkerName, -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Blocking I/O baseline for suite 6 (more-work.fsp: work 10, io 5, work 10, io 5, work 10) on an SSD
+static bool suite5() {
+	if (state->time == 1) {
+		Instruction workerInstructions[33];
+
+		for (int i = 0; i < 33; i++) {
+			workerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		workerInstructions[10] = Instruction{Opcode::IO, 5, NO_BLOCK};
+		workerInstructions[21] = Instruction{Opcode::IO, 5, NO_BLOCK};
+		workerInstructions[32] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker";
+		loadProgram(workerInstructions, 33, workerName);
+
+		configureIODevice(0, defaultIODeviceConfig(IODeviceClass::SSD));
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 10; i++) {
+			spawn(workerName, -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Same work and I/O as suite 5, but both requests are submitted up front in one batch and overlap with the work
+static bool suite6() {
+	if (state->time == 1) {
+		Instruction workerInstructions[34];
+
+		workerInstructions[0] = Instruction{Opcode::AIOBATCH, 5, 2};
+		workerInstructions[1] = Instruction{Opcode::MOVE, Regs::RAX, Regs::RBX};
+		for (int i = 2; i < 32; i++) {
+			workerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		workerInstructions[32] = Instruction{Opcode::AIOWAIT, Regs::RBX, 0};
+		workerInstructions[33] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker";
+		loadProgram(workerInstructions, 34, workerName);
+
+		configureIODevice(0, defaultIODeviceConfig(IODeviceClass::SSD));
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 10; i++) {
+			spawn(workerName, -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Memory pressure: each process allocates 16 pages and writes to every page twice, while the machine only has 64 frames for all of them
+static bool suite7() {
+	if (state->time == 1) {
+		Instruction toucherInstructions[23] = {
+			{Opcode::LOAD, 16 * PAGE_SIZE, Regs::RDI},
+			{Opcode::LOAD, Regs::RCX, Regs::RSI},
+			{Opcode::ALLOC, 0, 0},	// rcx = 16 pages
+			{Opcode::LOAD, 65, Regs::RDX},
+			{Opcode::LOAD, PAGE_SIZE, Regs::R8},
+			{Opcode::LOAD, 0, Regs::R9},
+			{Opcode::LOAD, 16, Regs::R10},
+			{Opcode::MOVE, Regs::RCX, Regs::R11},
+			{Opcode::SW, Regs::RDX, Regs::R11},	 // first pass over the pages
+			{Opcode::ADD, Regs::R8, Regs::R11},
+			{Opcode::INC, Regs::R9, 0},
+			{Opcode::CMP, Regs::R9, Regs::R10},
+			{Opcode::JL, (uint)(-4 * (int)sizeof(Instruction)), 0},
+			{Opcode::LOAD, 0, Regs::R9},
+			{Opcode::MOVE, Regs::RCX, Regs::R11},
+			{Opcode::SW, Regs::RDX, Regs::R11},	 // second pass over the pages
+			{Opcode::ADD, Regs::R8, Regs::R11},
+			{Opcode::INC, Regs::R9, 0},
+			{Opcode::CMP, Regs::R9, Regs::R10},
+			{Opcode::JL, (uint)(-4 * (int)sizeof(Instruction)), 0},
+			{Opcode::LOAD, Regs::RCX, Regs::RDI},
+			{Opcode::FREE, 0, 0},
+			{Opcode::EXIT, 0, 0},
+		};
+
+		char toucherName[] = "toucher";
+		loadProgram(toucherInstructions, 23, toucherName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 8; i++) {
+			spawn(toucherName, -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Cache cold starts: six processes with distinct 2.4KB programs share cores with 2KB L1 caches that are flushed on every context switch, so
+// strategies that switch often pay for refilling L1 from L2 much more often
+static bool suite8() {
+	if (state->time == 1) {
+		CacheConfig config = defaultCacheConfig();
+
+		config.enabled = true;
+		config.l1Sets = 8;
+		config.l1Ways = 4;
+		config.flushOnSwitch = true;
+		configureCaches(config);
+
+		Instruction workerInstructions[200];
+		for (int i = 0; i < 199; i++) {
+			workerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		workerInstructions[199] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker 0";
+		for (int i = 0; i < 6; i++) {
+			workerName[7] = '0' + i;
+			loadProgram(workerInstructions, 200, workerName);
+		}
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 6; i++) {
+			workerName[7] = '0' + i;
+			spawn(workerName, -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Context switch cost: short and long CPU-bound processes, where each switch costs 2 quanta plus 3 more if the core last ran another process,
+// so strategies that switch often lose a noticeable share of the CPU
+static bool suite9() {
+	if (state->time == 1) {
+		setContextSwitchCost(1, 1, 3);
+
+		char shortWorkerName[] = "short worker", longWorkerName[] = "long worker";
+
+		Instruction longInstructions[60];
+		for (int i = 0; i < 59; i++) {
+			longInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		longInstructions[59] = Instruction{Opcode::EXIT, 0, 0};
+		loadProgram(longInstructions, 60, longWorkerName);
+
+		Instruction shortInstructions[10];
+		for (int i = 0; i < 9; i++) {
+			shortInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		shortInstructions[9] = Instruction{Opcode::EXIT, 0, 0};
+		loadProgram(shortInstructions, 10, shortWorkerName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 4; i++) {
+			spawn(longWorkerName, -1);
+		}
+		return true;
+	}
+
+	if (state->time % 15 == 0 && state->time <= 90) {
+		char shortWorkerName[] = "short worker";
+		spawn(shortWorkerName, -1);
+	}
+
+	return state->time <= 90;
+}
+
+// Fairness under constant arrivals (suite 2 with more long workers at different niceness): MLF sinks the long workers to the bottom level
+// behind every arrival, while CFS keeps giving them a share of the CPU weighted by their niceness
+static bool suite10() {
+	if (state->time == 1) {
+		Instruction shortWorkerInstructions[10], longWorkerInstructions[256];
+
+		for (int i = 0; i < 9; i++) {
+			shortWorkerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		shortWorkerInstructions[9] = Instruction{Opcode::EXIT, 0, 0};
+		for (int i = 0; i < 255; i++) {
+			longWorkerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		longWorkerInstructions[255] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker", longWorkerName[] = "long worker";
+		loadProgram(shortWorkerInstructions, 10, workerName);
+		loadProgram(longWorkerInstructions, 256, longWorkerName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		spawn(longWorkerName, -1, -5);
+		spawn(longWorkerName, -1);
+		spawn(longWorkerName, -1);
+		spawn(longWorkerName, -1, 5);
+		spawn(workerName, -1);
+		return true;
+	}
+
+	if (state->time % 8 == 0 && state->time <= 400) {
+		char workerName[] = "worker";
+		spawn(workerName, -1);
+	}
+
+	return state->time <= 400;
+}
+
+// Suite 2 with a tuned MLF: fewer levels with longer quanta (so the long workers are demoted, and pay for being re-dispatched, less often),
+// and periodic priority boosts so that the long workers don't wait at the bottom level for the arrivals to stop
+static bool suite11() {
+	if (state->time == 1) {
+		setMLFLevels(3);
+		setMLFQuantum(0, 4);
+		setMLFQuantum(1, 8);
+		setMLFBoost(150, true);
+
+		Instruction shortWorkerInstructions[10], longWorkerInstructions[256];
+
+		for (int i = 0; i < 9; i++) {
+			shortWorkerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		shortWorkerInstructions[9] = Instruction{Opcode::EXIT, 0, 0};
+		for (int i = 0; i < 255; i++) {
+			longWorkerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		longWorkerInstructions[255] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker", longWorkerName[] = "long worker";
+		loadProgram(shortWorkerInstructions, 10, workerName);
+		loadProgram(longWorkerInstructions, 256, longWorkerName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		spawn(longWorkerName, -1);
+		spawn(longWorkerName, -1);
+		spawn(workerName, -1);
+		return true;
+	}
+
+	if (state->time % 10 == 0 && state->time <= 300) {
+		char workerName[] = "worker";
+		spawn(workerName, -1);
+	}
+
+	return state->time <= 300;
+}
+
+// Proportional share at scale: 1500 processes holding 1, 2 or 4 tickets; after 14000 ticks (about 2 rounds of stride scheduling, with
+// nothing finished yet), each group should have received CPU time in proportion to its tickets (1:2:4)
+static bool suite12() {
+	if (state->time == 1) {
+		Instruction workerInstructions[120];
+		for (int i = 0; i < 119; i++) {
+			workerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		workerInstructions[119] = Instruction{Opcode::EXIT, 0, 0};
+
+		char workerName[] = "worker";
+		loadProgram(workerInstructions, 120, workerName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+		stats.shareMeasured = false;
+
+		for (int i = 0; i < 500; i++) {
+			spawn(workerName, -1, 0, 1);
+			spawn(workerName, -1, 0, 2);
+			spawn(workerName, -1, 0, 4);
+		}
+		return true;
+	}
+
+	if (state->time == 14001) {
+		double groupTime[3] = {0, 0, 0}, totalTime = 0;
+
+		for (PCB* proc : state->processList) {
+			groupTime[proc->tickets == 1 ? 0 : proc->tickets == 2 ? 1 : 2] += proc->processorTime();
+			totalTime += proc->processorTime();
+		}
+
+		stats.shareMeasured = true;
+		stats.shareError = (fabs(groupTime[0] / totalTime - 1.0 / 7) + fabs(groupTime[1] / totalTime - 2.0 / 7) +
+							fabs(groupTime[2] / totalTime - 4.0 / 7)) /
+						   2 * 100;
+	}
+
+	return false;
+}
+
+// Burst prediction: SJF/SRT take a looping program's cost (7 instructions, 163 executed) from the analysis at load time, but an I/O-bound
+// program's whole cost as its burst; the predicted variants learn its bursts from the ones they observe
+static bool suite13() {
+	if (state->time == 1) {
+		Instruction looperInstructions[7] = {
+			{Opcode::LOAD, 40, Regs::RAX},
+			{Opcode::LOAD, 0, Regs::RBX},
+			{Opcode::WORK, 0, 0},
+			{Opcode::INC, Regs::RBX, 0},
+			{Opcode::CMP, Regs::RBX, Regs::RAX},
+			{Opcode::JL, (uint)(-3 * (int)sizeof(Instruction)), 0},
+			{Opcode::EXIT, 0, 0},
+		},
+					ioWorkerInstructions[18], workerInstructions[10];
+
+		for (int i = 0; i < 18; i++) {
+			ioWorkerInstructions[i] = i % 6 == 5 ? Instruction{Opcode::IO, 15, NO_BLOCK} : Instruction{Opcode::WORK, 0, 0};
+		}
+		ioWorkerInstructions[17] = Instruction{Opcode::EXIT, 0, 0};
+		for (int i = 0; i < 9; i++) {
+			workerInstructions[i] = Instruction{Opcode::WORK, 0, 0};
+		}
+		workerInstructions[9] = Instruction{Opcode::EXIT, 0, 0};
+
+		char looperName[] = "looper", ioWorkerName[] = "io worker", workerName[] = "worker";
+		loadProgram(looperInstructions, 7, looperName);
+		loadProgram(ioWorkerInstructions, 18, ioWorkerName);
+		loadProgram(workerInstructions, 10, workerName);
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+		return true;
+	}
+
+	if (state->time % 250 == 0 && state->time <= 2500) {  // Batches of 2 loopers, 6 workers and an I/O worker arriving together
+		char looperName[] = "looper", ioWorkerName[] = "io worker", workerName[] = "worker";
+		spawn(looperName, -1);
+		spawn(looperName, -1);
+		for (int i = 0; i < 6; i++) {
+			spawn(workerName, -1);
+		}
+		spawn(ioWorkerName, -1);
+	}
+
+	return state->time <= 2500;
+}
+
+// The program image suite 15 writes the default programs into (a temporary file, removed when the benchmarks exit)
+static char imagePath[] = "/tmp/feaux-s-programs-XXXXXX";
+
+static void removeProgramImage() { remove(imagePath); }
+
+// The browser's default programs, assembled from their .fsp sources (run from the repository root)
+// With fromImage, they're assembled once into a program image, and every run loads them from the (mapped) image instead, so suite 15 should
+// match suite 14 (the benchmarks stop if the image can't be written or loaded, rather than falling back on the sources)
+static bool defaultPrograms(bool fromImage) {
+	static const char* const programs[] = {"allocer", "io", "looper", "more-io", "more-work", "very-long", "worker"};
+	const uint numPrograms = sizeof(programs) / sizeof(const char*);
+
+	if (state->time == 1) {
+		static bool imageWritten = false;
+
+		if (!fromImage || !imageWritten) {
+			for (const char* program : programs) {
+				string path = string("public/default-programs/") + program + ".fsp";
+
+				loadProgramFile(path.c_str(), program);
+			}
+		}
+
+		if (fromImage) {
+			if (!imageWritten) {
+				int fd = mkstemp(imagePath);
+				FILE* file = fd != -1 ? fdopen(fd, "wb") : nullptr;
+
+				if (file == nullptr) {
+					cerr << "Debug: unable to create a program image in /tmp" << endl;
+					exit(1);
+				}
+				fclose(file);  // (writeProgramImage opens it again)
+				atexit(removeProgramImage);
+
+				if (!writeProgramImage(imagePath)) {
+					cerr << "Debug: unable to write the program image " << imagePath << endl;
+					exit(1);
+				}
+				imageWritten = true;
+				state->programs.clear();
+			}
+
+			if (loadProgramImage(imagePath) != numPrograms) {
+				cerr << "Debug: unable to load the default programs from the program image " << imagePath << endl;
+				exit(1);
+			}
+		}
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+		return true;
+	}
+
+	if (state->time % 20 == 0 && state->time <= 700) {	// One of each program, in turn (very-long only every third time around)
+		const char* program = programs[(state->time / 20) % 7];
+
+		if (strcmp(program, "very-long") != 0 || (state->time / 20) % 21 == 5) {
+			spawn(program, -1);
+		}
+	}
+
+	return state->time <= 700;
+}
+
+static bool suite14() { return defaultPrograms(false); }
+
+static bool suite15() { return defaultPrograms(true); }
+
+// Compute-heavy: counted loops with no I/O, which the CPU runs as fused blocks (see fusion.h)
+static bool suite16() {
+	if (state->time == 1) {
+		const char counter[] = "ldi 2000 rax\nldi 0 rbx\nloop:\nwork 2\ninc rbx\ncmp rbx rax\njl loop\nexit\n";
+		const char summer[] = "ldi 1 rcx\nldi 0 rdx\nldi 1500 rax\nldi 0 rbx\nloop:\nadd rcx rdx\ninc rbx\ncmp rbx rax\njl loop\nexit\n";
+
+		loadProgramSource(counter, sizeof(counter) - 1, "counter");
+		loadProgramSource(summer, sizeof(summer) - 1, "summer");
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+		return true;
+	}
+
+	if (state->time % 1000 == 2 && state->time <= 8000) {
+		spawn("counter", -1);
+		spawn("summer", -1);
+	}
+
+	return state->time <= 8000;
+}
+
+// Generated workloads (see workload.h), run from the repository root
+static WorkloadGenerator* workload = nullptr;
+
+// Starts a new workload (the programs it runs are loaded by the suite)
+static void startWorkload(const WorkloadConfig& config) {
+	delete workload;
+	workload = new WorkloadGenerator(config);
+
+	stats.usedCPUTime = 0;
+	stats.totalCPUTime = 0;
+}
+
+// Spawns this tick's arrivals, returning whether there are more to come
+static bool continueWorkload() {
+	workload->arrive(state->time);
+	return !workload->done(state->time);
+}
+
+// Bursty (MMPP) arrivals of the browser's default programs, mostly quiet with occasional bursts that swamp the cores
+static bool suite17() {
+	if (state->time == 1) {
+		static const char* const programs[] = {"allocer", "io", "looper", "more-io", "more-work", "worker"};
+		static const uint weights[] = {1, 2, 2, 1, 2, 4};
+
+		startWorkload(WorkloadConfig{ARRIVALS_MMPP, 0.05, 0.6, 0.004, 0.1, (uint)-1, 3000, 1});
+		for (uint i = 0; i < 6; i++) {
+			string path = string("public/default-programs/") + programs[i] + ".fsp";
+
+			loadProgramFile(path.c_str(), programs[i]);
+			workload->addProgram(programs[i], weights[i]);
+		}
+		return true;
+	}
+
+	return continueWorkload();
+}
+
+// A recorded trace (feaux-s/workloads/mixed.csv), with simultaneous batches, deadlines, nice values and tickets
+static bool suite18() {
+	if (state->time == 1) {
+		static const char* const programs[] = {"allocer", "io", "looper", "more-io", "more-work", "very-long", "worker"};
+
+		startWorkload(WorkloadConfig{ARRIVALS_TRACE, 0, 0, 0, 0, (uint)-1, 0, 1});
+		for (const char* program : programs) {
+			string path = string("public/default-programs/") + program + ".fsp";
+
+			loadProgramFile(path.c_str(), program);
+		}
+		workload->loadTrace("feaux-s/workloads/mixed.csv");
+		return true;
+	}
+
+	return continueWorkload();
+}
+
+// A load test: a million tiny processes arriving as a Poisson stream far faster than they can run, so the ready list grows to hundreds of
+// thousands of processes
+static bool suite19() {
+	if (state->time == 1) {
+		const char tiny[] = "work 2\nexit\n";
+
+		startWorkload(WorkloadConfig{ARRIVALS_POISSON, 1000, 0, 0, 0, (uint)-1, 1000, 1});
+		loadProgramSource(tiny, sizeof(tiny) - 1, "tiny");
+		workload->addProgram("tiny", 1);
+		return true;
+	}
+
+	return continueWorkload();
+}
+
+// Periodic real-time tasks scaled to the machine: four per core, together needing all of the cores' time (counting the tick to dispatch
+// each job and the one to handle its exit), with deadlines before the end of their periods, and released in step on groups of four cores
+// (staggered from group to group), so that the strategies differ in how many deadlines they miss and how often they preempt (make
+// run-rt-bench runs it on 8 to 64 cores)
+static bool suite20() {
+	static const uint horizon = 2048;  // The tick the tasks stop being released on
+
+	if (state->time == 1) {
+		// The instructions each job of the task runs, the task's period (a power of 2, see below), and the deadline after each release
+		static const uint tasks[4][3] = {{4, 16, 12}, {8, 32, 20}, {18, 64, 48}, {13, 128, 80}};
+
+		for (uint i = 0; i < 4; i++) {
+			vector<Instruction> instructions(tasks[i][0], Instruction{Opcode::WORK, 0, 0});
+			string name = "rt-task-" + to_string(i);
+
+			instructions.back() = Instruction{Opcode::EXIT, 0, 0};
+			loadProgram(instructions.data(), instructions.size(), name.c_str());
+
+			// (jobs are released when (time - delay) % period == 0, which for a power of 2 period never happens early by wrapping around)
+			for (uint core = 0; core < machine->numCores; core++) {
+				dispatch(name.c_str(), tasks[i][1], tasks[i][2], core / 4 * 3 % tasks[i][1]);
+			}
+		}
+		return true;
+	}
+
+	if (state->time == horizon) {
+		for (RTJob* job : state->jobList) {
+			delete job;
+		}
+		state->jobList.clear();
+	}
+
+	return state->time < horizon;
+}
+
+// Workers contending for one mutex around a critical section (with work outside it too), and producers handing units to consumers through
+// a semaphore, so that the strategies differ in how long processes wait on them, and how long a preempted owner keeps the others waiting
+static bool suite21() {
+	if (state->time == 1) {
+		const char worker[] =
+			"ldi 0 rcx\n"
+			"ldi 3 rdx\n"
+			"loop:\n"
+			"work 4\n"
+			"lock 1\n"
+			"work 6\n"
+			"unlock 1\n"
+			"inc rcx\n"
+			"cmp rcx rdx\n"
+			"jl loop\n"
+			"exit\n";
+		const char producer[] = "ldi 0 rcx\nldi 6 rdx\nloop:\nwork 5\nsempost 2\ninc rcx\ncmp rcx rdx\njl loop\nexit\n";
+		const char consumer[] = "ldi 0 rcx\nldi 6 rdx\nloop:\nsemwait 2\nwork 3\ninc rcx\ncmp rcx rdx\njl loop\nexit\n";
+
+		loadProgramSource(worker, sizeof(worker) - 1, "locker");
+		loadProgramSource(producer, sizeof(producer) - 1, "producer");
+		loadProgramSource(consumer, sizeof(consumer) - 1, "consumer");
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		for (int i = 0; i < 4; i++) {
+			spawn("consumer", -1);
+			spawn("locker", -1);
+			spawn("locker", -1);
+			spawn("producer", -1);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Priority inversion: a job with a late deadline takes a mutex that a job with an early deadline then needs, while jobs with deadlines in
+// between (one per core, with no use for the mutex) are released, so that under EDF/LST they keep the owner from running, and the job
+// waiting for it from meeting its deadline, unless the owner inherits the waiter's deadline
+static bool priorityInversion(bool inheritance) {
+	static const uint horizon = 1024;  // The tick the tasks stop being released on
+
+	if (state->time == 1) {
+		const char low[] = "lock 1\nwork 6\nunlock 1\nwork 20\nexit\n", high[] = "work 1\nlock 1\nwork 2\nunlock 1\nexit\n",
+				   medium[] = "work 12\nexit\n";
+
+		setPriorityInheritance(inheritance);
+		loadProgramSource(low, sizeof(low) - 1, "rt-low");
+		loadProgramSource(high, sizeof(high) - 1, "rt-high");
+		loadProgramSource(medium, sizeof(medium) - 1, "rt-medium");
+
+		// (every other release of rt-high comes while rt-low holds the mutex, the rest while it's free)
+		dispatch("rt-low", 64, 60, 1);
+		dispatch("rt-high", 32, 16, 3);
+		for (uint core = 0; core < machine->numCores; core++) {
+			dispatch("rt-medium", 32, 28, 4);
+		}
+		return true;
+	}
+
+	if (state->time == horizon) {
+		for (RTJob* job : state->jobList) {
+			delete job;
+		}
+		state->jobList.clear();
+	}
+
+	return state->time < horizon;
+}
+
+static bool suite22() { return priorityInversion(false); }
+
+static bool suite23() { return priorityInversion(true); }
+
+// Frequent MLF priority boosts: the long workers, held on the first core, sink to the bottom level between boosts while the workers arriving
+// run on the other cores; once they may run anywhere (after the boost at tick 120), each boost lifts the ones left queued at the bottom back
+// to the top level while workers demoted since it are running, which they should preempt
+static bool suite24() {
+	static uint longWorkers;
+
+	if (state->time == 1) {
+		setMLFLevels(4);
+		setMLFQuantum(0, 1);
+		setMLFQuantum(1, 2);
+		setMLFQuantum(2, 4);
+		setMLFBoost(40, false);
+
+		const char worker[] = "work 9\nexit\n", longWorker[] = "work 200\nexit\n";
+		loadProgramSource(worker, sizeof(worker) - 1, "worker");
+		loadProgramSource(longWorker, sizeof(longWorker) - 1, "long worker");
+
+		stats.usedCPUTime = 0;
+		stats.totalCPUTime = 0;
+
+		longWorkers = spawnBatch("long worker", 6, -1);
+		for (uint pid = longWorkers; pid < longWorkers + 6; pid++) {
+			for (uint core = 1; core < machine->numCores; core++) setAffinity(pid, core, false);
+		}
+		return true;
+	}
+
+	if (state->time == 130) {
+		for (uint pid = longWorkers; pid < longWorkers + 6; pid++) {
+			for (uint core = 1; core < machine->numCores; core++) setAffinity(pid, core, true);
+		}
+	}
+
+	if (state->time % 7 == 0 && state->time <= 300) {
+		spawn("worker", -1);
+	}
+
+	return state->time <= 300;
+}
+
+const BenchmarkSuite BENCHMARK_SUITES[] = {
+	{1, "workers", "Five identical CPU-bound workers arriving together", suite1, false},
+	{2, "arrivals", "Two long workers, with a short worker arriving every 10 ticks", suite2, false},
+	{3, "short-jobs", "Workers with I/O and long workers, with pairs of short workers arriving right after", suite3, false},
+	{4, "disk", "I/O-bound workers on a simulated disk", suite4, false},
+	{5, "blocking-io", "Workers blocking on I/O to an SSD (the baseline for async-io)", suite5, false},
+	{6, "async-io", "The work and I/O of blocking-io, with the I/O submitted up front and overlapped with the work", suite6, false},
+	{7, "memory-pressure", "Processes touching more pages than the machine has frames", suite7, false},
+	{8, "cache-cold-starts", "Distinct programs on small L1 caches that are flushed on every context switch", suite8, false},
+	{9, "switch-cost", "Short and long workers with costly context switches", suite9, false},
+	{10, "fairness", "Long workers at different niceness under constant arrivals", suite10, false},
+	{11, "tuned-mlf", "The arrivals suite with fewer, longer MLF levels and priority boosts", suite11, false},
+	{12, "proportional-share", "1500 processes holding 1, 2 or 4 tickets (measures the share error)", suite12, false},
+	{13, "burst-prediction", "Batches of loopers, workers and I/O workers (SJF/SRT on static costs vs predicted bursts)", suite13, false},
+	{14, "default-programs", "The browser's default programs, assembled from their .fsp sources", suite14, false},
+	{15, "program-image", "The default programs, loaded from a program image (should match default-programs)", suite15, false},
+	{16, "compute", "Counted loops with no I/O (run as fused blocks)", suite16, false},
+	{17, "mmpp", "Bursty (MMPP) arrivals of the default programs", suite17, false},
+	{18, "trace", "Arrivals replayed from feaux-s/workloads/mixed.csv", suite18, false},
+	{19, "load-test", "A million tiny processes arriving far faster than they can run", suite19, false},
+	{20, "rt-multicore", "Periodic real-time tasks, four per core, needing all of the cores' time (RT strategies)", suite20, true},
+	{21, "lock-contention", "Workers contending for a mutex, and producers feeding consumers through a semaphore", suite21, false},
+	{22, "priority-inversion", "Real-time jobs sharing a mutex, preempted by jobs with deadlines in between (RT strategies)", suite22, true},
+	{23, "priority-inheritance", "The priority-inversion jobs, with priority inheritance on (RT strategies)", suite23, true},
+	{24, "mlf-boost", "Long workers and arrivals under frequent MLF priority boosts", suite24, false},
+};
+const uint NUM_BENCHMARK_SUITES = sizeof(BENCHMARK_SUITES) / sizeof(BenchmarkSuite);
+
+// Finds a suite by its number or name
+static const BenchmarkSuite* findSuite(const string& key) {
+	for (const BenchmarkSuite& suite : BENCHMARK_SUITES) {
+		if (key == suite.name || key == to_string(suite.id)) {
+			return &suite;
+		}
+	}
+
+	return nullptr;
+}
+
+static void printUsage(const char* program) {
+	cerr << "Usage: " << program << " [--suite=all|ID|NAME[,...]] [--cores=N] [--devices=N] [--format=text|json|csv] [--golden=DIR] [--update-golden=DIR]\n"
+		 << "       [--profile-trace=PATH] [--list] [--fuzz=CASES [--seed=N] [--fuzz-interval=TICKS]]"
+		 << endl;
+}
+
+bool startBenchmarks(int argc, char** argv) {
+	uint fuzzCases = 0, fuzzSeed = 1, fuzzInterval = 1;
+
+	runs.numCores = 2;
+	runs.numIODevices = 1;
+	runs.format = BenchmarkFormat::FORMAT_TEXT;
+	runs.updateGolden = false;
+	runs.goldenRuns = 0;
+	runs.goldenFailures = 0;
+	runs.suite = 0;
+	runs.strategy = 0;
+	runs.started = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		size_t equals = arg.find('=');
+		string option = arg.substr(0, equals), value = equals == string::npos ? "" : arg.substr(equals + 1);
+
+		if (option == "--list") {
+			for (const BenchmarkSuite& suite : BENCHMARK_SUITES) {
+				cout << setw(3) << suite.id << "  " << left << setw(20) << suite.name << right << suite.description << "\n";
+			}
+			exit(0);
+		} else if (option == "--suite" && !value.empty()) {
+			for (size_t start = 0; start <= value.size();) {
+				size_t comma = min(value.find(',', start), value.size());
+				string key = value.substr(start, comma - start);
+
+				if (key == "all") {
+					for (const BenchmarkSuite& suite : BENCHMARK_SUITES) runs.suites.push_back(&suite);
+				} else if (findSuite(key) != nullptr) {
+					runs.suites.push_back(findSuite(key));
+				} else {
+					cerr << "Debug: unknown benchmark suite " << key << " (see --list)" << endl;
+					return false;
+				}
+				start = comma + 1;
+			}
+		} else if ((option == "--cores" || option == "--devices") && !value.empty()) {
+			int count = atoi(value.c_str());
+
+			if (count < 1 || count > 255) {
+				cerr << "Debug: " << option << " must be between 1 and 255" << endl;
+				return false;
+			}
+			(option == "--cores" ? runs.numCores : runs.numIODevices) = count;
+		} else if (option == "--format" && (value == "text" || value == "json" || value == "csv")) {
+			runs.format = value == "text" ? BenchmarkFormat::FORMAT_TEXT : value == "json" ? BenchmarkFormat::FORMAT_JSON : BenchmarkFormat::FORMAT_CSV;
+		} else if ((option == "--golden" || option == "--update-golden") && !value.empty()) {
+			runs.goldenDir = value;
+			runs.updateGolden = option == "--update-golden";
+		} else if ((option == "--fuzz" || option == "--seed" || option == "--fuzz-interval") && !value.empty()) {
+			(option == "--fuzz" ? fuzzCases : option == "--seed" ? fuzzSeed : fuzzInterval) = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--profile-trace" && !value.empty()) {
+#ifdef FEAUX_S_PROFILING
+			runs.profileTrace = value;
+#else
+			cerr << "Debug: --profile-trace needs the profiler (make benchmarks PROFILE=1)" << endl;
+			return false;
+#endif
+		} else {
+			printUsage(argv[0]);
+			return false;
+		}
+	}
+
+	if (fuzzCases > 0) {  // Fuzzing instead of benchmarking
+		exit(runFuzzer(fuzzCases, fuzzSeed, fuzzInterval) ? 0 : 1);
+	}
+
+	if (runs.suites.empty()) {
+		for (const BenchmarkSuite& suite : BENCHMARK_SUITES) runs.suites.push_back(&suite);
+	}
+
+	if (runs.format == BenchmarkFormat::FORMAT_JSON) {
+		cout << "[\n";
+	} else if (runs.format == BenchmarkFormat::FORMAT_CSV) {
+		cout << "suite,name,strategy";
+		for (const char* column : BENCHMARK_COLUMNS) cout << "," << column;
+		cout << "\n";
+	}
+	return true;
+}
+
+bool nextBenchmark(uint8_t& numCores, uint8_t& numIODevices, SchedulingStrategy& strategy) {
+	if (runs.started && ++runs.strategy == numStrategies(runs.suites[runs.suite])) {
+		runs.strategy = 0;
+		runs.suite++;
+	}
+	if (runs.suite == runs.suites.size()) {
+		return false;
+	}
+
+	// Label each suite's runs in the text output when there's more than one suite
+	if (runs.format == BenchmarkFormat::FORMAT_TEXT && runs.strategy == 0 && runs.suites.size() > 1) {
+		cout << "=== Suite " << runs.suites[runs.suite]->id << ": " << runs.suites[runs.suite]->name << " ===\n" << endl;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	runs.started = true;
+	runs.start = chrono::steady_clock::now();
+
+	numCores = runs.numCores;
+	numIODevices = runs.numIODevices;
+	strategy = suiteStrategy(runs.suites[runs.suite], runs.strategy);
+	return true;
+}
+
+bool simulate() {
+	// (the heuristic has to be set before the suite dispatches its jobs on the first tick)
+	if (state->time == 1 && runs.suites[runs.suite]->realTime) {
+		state->partitionHeuristic = RT_STRATEGIES[runs.strategy].heuristic;
+	}
+
+	stats.totalCPUTime += machine->numCores;
+	for (uint i = 0; i < machine->numCores; i++) {
+		stats.usedCPUTime += !machine->cores[i]->free();
+	}
+
+	return runs.suites[runs.suite]->simulate();
+}
+
+bool finishBenchmarks() {
+	if (runs.format == BenchmarkFormat::FORMAT_JSON) {
+		cout << "\n]\n";
+	}
+
+	if (!runs.goldenDir.empty() && !runs.updateGolden) {
+		cerr << "Golden: " << runs.goldenRuns - runs.goldenFailures << " of " << runs.goldenRuns << " runs matched their golden results" << endl;
+	}
+
+#ifdef FEAUX_S_PROFILING
+	// (on stderr, so as not to get mixed into the results)
+	cerr << "\nProfile of all runs:\n";
+	printProfile(cerr);
+	if (!runs.profileTrace.empty()) {
+		writeProfileTrace(runs.profileTrace.c_str());
+	}
+#endif
+
+	return runs.goldenFailures == 0;
+}
@@ -1,19 +1,75 @@
 #ifndef BENCHMARKS_H
 #define BENCHMARKS_H
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
+#include "assembler.h"
 #include "browser-api.h"
 #include "decls.h"
+#include "devices.h"
+#include "image.h"
+#include "memory.h"
+#include "workload.h"
 
 #define STRATEGY_NAME(strategy)                                        \
 	(strategy == SchedulingStrategy::FIFO  ? "First-In-First-Out"      \
 	 : strategy == SchedulingStrategy::SJF ? "Shortest Job First"      \
 	 : strategy == SchedulingStrategy::SRT ? "Shortest Remaining Time" \
 	 : strategy == SchedulingStrategy::MLF ? "Multi-Level Feedback"    \
-										   : "oops...")
+	 : strategy == SchedulingStrategy::CFS ? "Completely Fair"         \
+	 : strategy == SchedulingStrategy::LOTTERY ? "Lottery"             \
+	 : strategy == SchedulingStrategy::STRIDE  ? "Stride"              \
+	 : strategy == SchedulingStrategy::SJF_PREDICTED ? "Shortest (Predicted) Job First"      \
+	 : strategy == SchedulingStrategy::SRT_PREDICTED ? "Shortest (Predicted) Remaining Time" \
+	 : strategy == SchedulingStrategy::RT_FIFO ? "Real-Time First-In-First-Out"      \
+	 : strategy == SchedulingStrategy::RT_EDF  ? "Earliest Deadline First"           \
+	 : strategy == SchedulingStrategy::RT_LST  ? "Least Slack Time"                  \
+	 : strategy == SchedulingStrategy::RT_PEDF ? "Partitioned Earliest Deadline First" \
+													 : "oops...")
 
-void printStats();
+// A benchmark suite: a scenario (machine/OS configuration and process arrivals) that every scheduling strategy is run through
+struct BenchmarkSuite {
+	uint id;
+	const char* name;
+	const char* description;
+	bool (*simulate)();	 // Called at the start of every tick; sets the scenario up on tick 1, and returns whether more processes are to come
+	bool realTime;		 // Whether the suite is run through the real-time strategies (RT_FIFO, RT_EDF, RT_LST, and RT_PEDF with each bin-packing
+						 // heuristic) instead of the others
+};
+
+extern const BenchmarkSuite BENCHMARK_SUITES[];
+extern const uint NUM_BENCHMARK_SUITES;
+
+// How results are written
+// FORMAT_TEXT = readable stats for each run (the default)
+// FORMAT_JSON = an array with an object for each run
+// FORMAT_CSV = a header, then a row for each run
+// (the machine-readable formats include how long each run took, and how many ticks per second it simulated)
+enum BenchmarkFormat { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV };
+
+// The benchmarks run each selected suite with every strategy (the real-time suites with the real-time strategies), one run after another:
+//   feaux-s/bin/bench [--suite=all|ID|NAME[,...]] [--cores=N] [--devices=N] [--format=text|json|csv] [--golden=DIR] [--update-golden=DIR]
+//                     [--profile-trace=PATH] [--list] [--fuzz=CASES [--seed=N] [--fuzz-interval=TICKS]]
+// (all suites on 2 cores and 1 I/O device by default; --list shows the suites)
+// With --golden, the outcome of every process in each run (its final state, doneTime and processorTime) is checked against the golden
+// results recorded in DIR (one file per suite, see feaux-s/golden) by --update-golden, so that changes to the kernel that shouldn't change
+// how processes get scheduled can be shown not to (make check-golden)
+// With --fuzz, the kernel is fuzzed instead (see fuzz.h, make run-fuzz)
+// Built with the profiler (make benchmarks PROFILE=1, as feaux-s/bin/bench-profile), the time spent in each phase of the kernel's ticks is reported at the end, and
+// --profile-trace writes the trace of the first ticks (see profiler.h)
+// Returns false if the arguments are malformed
+bool startBenchmarks(int argc, char** argv);
+// Moves on to the next run, giving the machine and strategy to start it with (returns false once every run is done)
+bool nextBenchmark(uint8_t& numCores, uint8_t& numIODevices, SchedulingStrategy& strategy);
+// Runs the current suite for the tick, returning whether more processes are to come
 bool simulate();
+// Reports the results of the run that just finished
+void printStats();
+// Finishes the output once every run is done
+// Returns false if any run didn't match its golden results (or they couldn't be recorded)
+bool finishBenchmarks();
 
 #endif
\ No newline at end of file
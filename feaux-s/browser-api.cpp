@@ -1,6 +1,13 @@
 #include "browser-api.h"
 
+#include "analysis.h"
+#include "assembler.h"
+#include "devices.h"
+#include "lottery.h"
 #include "machine.h"
+#include "memory.h"
+#include "os.h"
+#include "sync.h"
 
 MachineStateCompat* exportMachineState = nullptr;
 OSStateCompat* exportState = nullptr;
@@ -45,51 +52,93 @@ void
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
-	loadProgram(Instruction* instructionList, uint size, char* name) {
-	Program newProgram{name, size, new Instruction[size]};
+	loadProgram(Instruction* instructionList, uint size, const char* name) {
+	Instruction* instructions = new Instruction[size];
 
 	for (uint i = 0; i < size; i++) {
-		newProgram.instructions[i] = instructionList[i];
+		instructions[i] = instructionList[i];
 	}
 
-	state->programs.emplace(name, newProgram);
+	Program newProgram{name, size, shared_ptr<const Instruction>(instructions, default_delete<Instruction[]>())};
+	newProgram.costKind = analyzeProgram(instructions, size, newProgram.cost);
+	newProgram.predictedBurst = newProgram.cost;
+	placeProgram(newProgram);
+
+	state->programs.emplace(name, std::move(newProgram));
+	flushFusedBlocks();	 // The new program may have been put where an old one's translated code was
 }
 
-Instruction*
+uint
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
-	getProgramLocation(char* name) {
-	return state->programs.at(name).instructions;
+	loadProgramSource(const char* source, uint size, const char* name) {
+	// Reused between programs, so that loading many doesn't allocate for each one
+	static Assembler assembler;
+	static vector<Instruction> instructions;
+
+	if (!assembler.assemble(source, size, instructions)) {
+		return 0;
+	}
+
+	loadProgram(instructions.data(), instructions.size(), name);
+	return instructions.size();
 }
 
-uint
+const Instruction*
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
-	spawn(const char* name, uint d) {
-	if (state->programs.count(name)) {	// If there exists a program of that name
-		Program& program = state->programs.at(name);
-		PCB* proc = new PCB();
-
-		proc->pid = ++nextPID;
-		proc->name = name;
-		proc->arrivalTime = state->time;
-		proc->deadline = d == -1 ? -1 : state->time + d;
-		proc->level = 0;
-		proc->processorTimeOnLevel = 0;
-		proc->state = ready;
-
-		memset(&proc->regstate, 0, sizeof(Registers));
+	getProgramLocation(char* name) {
+	return state->programs.at(name).instructions.get();
+}
+
+// Makes a (ready) process to run the program, without putting it on any list
+static PCB* createProcess(const char* name, const Program& program, uint d, int nice, uint tickets) {
+	PCB* proc = new PCB();
+
+	state->columns.add(proc);
+	proc->pid = ++nextPID;
+	proc->name = name;
+	proc->arrivalTime() = state->time;
+	proc->deadline() = d == -1 ? -1 : state->time + d;
+	proc->level() = 0;
+	proc->processorTimeOnLevel = 0;
+	proc->mlfEpoch = state->mlfEpoch;
+	proc->nice = nice < -20 ? -20 : nice > 19 ? 19 : nice;
+	proc->weight = NICE_TO_WEIGHT[proc->nice + 20];
+	proc->tickets = tickets != 0 ? tickets : program.tickets;
+	proc->predictedBurst = program.predictedBurst;
+	proc->state() = ready;
+
+	memset(&proc->regstate, 0, sizeof(Registers));
 #if FEAUX_S_BENCHMARKING
-		proc->regstate.rip = (uint64_t)program.instructions;  // Loads the address of the first instruction into the instruction pointer of the process
+	proc->regstate.rip = (uint64_t)program.instructions.get();  // Loads the address of the first instruction into the instruction pointer of the process
 #else
-		proc->regstate.rip = (uint)program.instructions;  // Loads the address of the first instruction into the instruction pointer of the process
+	proc->regstate.rip = (uint)program.instructions.get();	// Loads the address of the first instruction into the instruction pointer of the process
 #endif
-		proc->regstate.rdi = 0;
-		proc->reqProcessorTime = program.length - 1;
+	proc->regstate.rdi = 0;
+	proc->reqProcessorTime() = program.cost;
+	proc->codeOffset = program.codeAddress - (uint64_t)(uintptr_t)program.instructions.get();
+	proc->codeEnd = (uint64_t)(uintptr_t)(program.instructions.get() + program.length);
+	proc->addressSpace = new AddressSpace(machine->memory);
+
+	return proc;
+}
+
+uint
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	spawn(const char* name, uint d, int nice, uint tickets) {
+	auto it = state->programs.find(name);
+
+	// If there exists a program of that name (and a ready list to put the process on, checked before it's admitted)
+	if (it != state->programs.end() && hasReadyList(state->strategy)) {
+		PCB* proc = createProcess(name, it->second, d, nice, tickets);
 
 		state->processList.push_back(proc);
+		state->processTable.emplace(proc->pid, proc);
 
 		switch (state->strategy) {
 			case SchedulingStrategy::FIFO:
@@ -97,22 +146,36 @@ uint
 				state->fifoReadyList.emplace(proc);
 				break;
 			case SchedulingStrategy::SJF:
-				state->sjfReadyList.emplace(proc);
+			case SchedulingStrategy::SJF_PREDICTED:
+				state->sjfReadyList.emplace(proc->slot);
 				break;
 			case SchedulingStrategy::SRT:
-				state->srtReadyList.emplace(proc);
+			case SchedulingStrategy::SRT_PREDICTED:
+				enqueueSRT(proc);
 				break;
 			case SchedulingStrategy::MLF:
 				state->mlfLists[0].emplace(proc);
 				break;
 			case SchedulingStrategy::RT_EDF:
-				state->edfReadyList.emplace(proc);
+				state->edfReadyList.emplace(proc->slot);
 				break;
 			case SchedulingStrategy::RT_LST:
-				state->lstReadyList.emplace(proc);
+				enqueueLST(proc);
+				break;
+			case SchedulingStrategy::RT_PEDF:
+				enqueuePEDF(proc);
+				break;
+			case SchedulingStrategy::CFS:
+				enqueueCFS(proc, true);
+				break;
+			case SchedulingStrategy::LOTTERY:
+				state->lotteryReadyList->insert(proc);
+				break;
+			case SchedulingStrategy::STRIDE:
+				enqueueStride(proc);
+				break;
+			default:  // (ruled out above)
 				break;
-			default:
-				return -1;
 		}
 
 		return proc->pid;
@@ -121,6 +184,56 @@ uint
 	}
 }
 
+uint
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	spawnBatch(const char* name, uint count, uint d, int nice, uint tickets) {
+	auto it = state->programs.find(name);
+
+	if (it == state->programs.end() || count == 0 || !hasReadyList(state->strategy)) {	// (checked before any process is admitted)
+		return -1;
+	}
+
+	static vector<PCB*> procs;	// Reused between batches
+	procs.clear();
+	procs.reserve(count);
+
+	for (uint i = 0; i < count; i++) {
+		PCB* proc = createProcess(name, it->second, d, nice, tickets);
+
+		state->processList.push_back(proc);
+		state->processTable.emplace(proc->pid, proc);
+		procs.push_back(proc);
+	}
+
+	enqueueBatch(procs);
+	return procs.front()->pid;
+}
+
+uint releaseJob(const RTJob& job) {
+	auto it = state->programs.find(job.program);
+
+	if (it == state->programs.end()) {
+		return -1;
+	} else if (state->strategy != SchedulingStrategy::RT_PEDF || job.core == -1) {
+		return spawn(job.program.c_str(), job.deadline);  // (spawn takes the deadline relative to now)
+	}
+
+	PCB* proc = createProcess(job.program.c_str(), it->second, job.deadline, 0, 0);
+
+	state->processList.push_back(proc);
+	state->processTable.emplace(proc->pid, proc);
+
+	if (job.core < 64) {
+		setProcessAffinity(proc, 1ull << job.core);
+	}
+	proc->partition = job.core;
+	enqueuePEDF(proc);
+
+	return proc->pid;
+}
+
 void
 #ifndef FEAUX_S_BENCHMARKING
 	exported
@@ -135,6 +248,44 @@ void
 		job->delay = state->time + s;
 
 		state->jobList.emplace_back(job);
+		partitionJobs();
+	}
+}
+
+bool
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setAffinity(uint pid, uint core, bool allowed) {
+	auto it = state->processTable.find(pid);
+
+	if (it == state->processTable.end()) {
+		return false;
+	} else if (core >= 64) {
+		return allowed;
+	}
+
+	PCB* proc = it->second;
+	return setProcessAffinity(proc, allowed ? proc->affinity | 1ull << core : proc->affinity & ~(1ull << core));
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setPartitionHeuristic(PartitionHeuristic heuristic) {
+	state->partitionHeuristic = heuristic;
+	partitionJobs();
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setPriorityInheritance(bool enabled) {
+	state->priorityInheritance = enabled;
+	for (auto& mutex : state->mutexes) {
+		refreshInheritance(mutex.second.owner);
 	}
 }
 
@@ -165,17 +316,34 @@ void
 	exported
 #endif
 	setNumCores(uint8_t cores) {
-	map<string, Program> programs = state->programs;
+	unordered_map<string, Program> programs = std::move(state->programs);
+	uint64_t nextCodeAddress = state->nextCodeAddress;	// (so that programs loaded later don't overlap these)
 	SchedulingStrategy strategy = state->strategy;
 	uint8_t numIODevices = machine->numIODevices;
 	uint clockDelay = machine->clockDelay;
+	vector<IODeviceConfig> deviceConfigs;
+	for (uint i = 0; i < numIODevices; i++) deviceConfigs.push_back(machine->ioDevices[i]->config());
+	CacheConfig cacheConfig = machine->cores[0]->cacheConfig();
+	MemoryConfig memoryConfig = machine->memory->config();
+	ContextSwitchConfig switchCost = state->switchCost;
+	MLFConfig mlfConfig = state->mlfConfig;
+	PartitionHeuristic partitionHeuristic = state->partitionHeuristic;
+	bool priorityInheritance = state->priorityInheritance;
 	cleanupOS();
 	cleanupMachine();
 
 	initMachine(cores, numIODevices);
 	machine->clockDelay = clockDelay;
+	for (uint i = 0; i < numIODevices; i++) configureIODevice(i, deviceConfigs[i]);
+	configureCaches(cacheConfig);
+	configureMemory(memoryConfig);
 	initOS(machine->numCores, strategy);
-	state->programs = programs;
+	state->programs = std::move(programs);
+	state->nextCodeAddress = nextCodeAddress;
+	state->switchCost = switchCost;
+	state->mlfConfig = mlfConfig;
+	state->partitionHeuristic = partitionHeuristic;
+	state->priorityInheritance = priorityInheritance;
 }
 
 void
@@ -183,17 +351,60 @@ void
 	exported
 #endif
 	setNumIODevices(uint8_t ioDevices) {
-	map<string, Program> programs = state->programs;
+	unordered_map<string, Program> programs = std::move(state->programs);
+	uint64_t nextCodeAddress = state->nextCodeAddress;	// (so that programs loaded later don't overlap these)
 	SchedulingStrategy strategy = state->strategy;
 	uint8_t numCores = machine->numCores;
 	uint clockDelay = machine->clockDelay;
+	vector<IODeviceConfig> deviceConfigs;  // Devices that still exist after the change keep their configuration
+	for (uint i = 0; i < machine->numIODevices && i < ioDevices; i++) deviceConfigs.push_back(machine->ioDevices[i]->config());
+	CacheConfig cacheConfig = machine->cores[0]->cacheConfig();
+	MemoryConfig memoryConfig = machine->memory->config();
+	ContextSwitchConfig switchCost = state->switchCost;
+	MLFConfig mlfConfig = state->mlfConfig;
+	PartitionHeuristic partitionHeuristic = state->partitionHeuristic;
+	bool priorityInheritance = state->priorityInheritance;
 	cleanupOS();
 	cleanupMachine();
 
 	initMachine(numCores, ioDevices);
 	machine->clockDelay = clockDelay;
+	for (uint i = 0; i < deviceConfigs.size(); i++) configureIODevice(i, deviceConfigs[i]);
+	configureCaches(cacheConfig);
+	configureMemory(memoryConfig);
 	initOS(machine->numCores, strategy);
-	state->programs = programs;
+	state->programs = std::move(programs);
+	state->nextCodeAddress = nextCodeAddress;
+	state->switchCost = switchCost;
+	state->mlfConfig = mlfConfig;
+	state->partitionHeuristic = partitionHeuristic;
+	state->priorityInheritance = priorityInheritance;
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setIODeviceClass(uint8_t device, IODeviceClass deviceClass) {
+	if (device < machine->numIODevices) {
+		IODeviceConfig config = defaultIODeviceConfig(deviceClass);
+
+		config.policy = machine->ioDevices[device]->config().policy;
+		configureIODevice(device, config);
+	}
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setIOSchedulingPolicy(uint8_t device, IOSchedulingPolicy policy) {
+	if (device < machine->numIODevices) {
+		IODeviceConfig config = machine->ioDevices[device]->config();
+
+		config.policy = policy;
+		configureIODevice(device, config);
+	}
 }
 
 void
@@ -201,7 +412,12 @@ void
 	exported
 #endif
 	setSchedulingStrategy(SchedulingStrategy strategy) {
-	map<string, Program> programs = state->programs;  // Save a copy of the programs, so that the new OS will still have the same programs
+	unordered_map<string, Program> programs = std::move(state->programs);	// Keep the programs, so that the new OS will still have the same programs
+	uint64_t nextCodeAddress = state->nextCodeAddress;	// (so that programs loaded later don't overlap these)
+	ContextSwitchConfig switchCost = state->switchCost;
+	MLFConfig mlfConfig = state->mlfConfig;
+	PartitionHeuristic partitionHeuristic = state->partitionHeuristic;
+	bool priorityInheritance = state->priorityInheritance;
 	cleanupOS();
 
 	for (uint i = 0; i < machine->numCores; i++) {
@@ -213,7 +429,75 @@ void
 	}
 
 	initOS(machine->numCores, strategy);
-	state->programs = programs;
+	state->programs = std::move(programs);
+	state->nextCodeAddress = nextCodeAddress;
+	state->switchCost = switchCost;
+	state->mlfConfig = mlfConfig;
+	state->partitionHeuristic = partitionHeuristic;
+	state->priorityInheritance = priorityInheritance;
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setCacheModel(bool enabled, bool flushOnSwitch) {
+	CacheConfig config = machine->cores[0]->cacheConfig();
+
+	config.enabled = enabled;
+	config.flushOnSwitch = flushOnSwitch;
+	configureCaches(config);
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setContextSwitchCost(uint fixedTicks, uint registerTicks, uint cacheWarmupTicks) {
+	state->switchCost = ContextSwitchConfig{fixedTicks, registerTicks, cacheWarmupTicks};
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setProgramTickets(char* name, uint tickets) {
+	auto it = state->programs.find(name);
+
+	if (it != state->programs.end() && tickets != 0) {
+		it->second.tickets = tickets;
+	}
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFLevels(uint numLevels) {
+	if (!state->processList.empty()) {
+		cerr << "Debug: can't change the number of MLF levels while there are processes" << endl;
+	} else if (numLevels >= 1 && numLevels <= NUM_LEVELS) {
+		state->mlfConfig.numLevels = numLevels;
+	}
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFQuantum(uint level, uint quantum) {
+	if (level < NUM_LEVELS) {
+		state->mlfConfig.quanta[level] = quantum;
+	}
+}
+
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFBoost(uint period, bool ioPromotion) {
+	state->mlfConfig.boostPeriod = period;
+	state->mlfConfig.ioPromotion = ioPromotion;
 }
 
 MachineStateCompat*
@@ -363,13 +647,14 @@ OSStateCompat*
 			}
 			break;
 		case SchedulingStrategy::SJF:
+		case SchedulingStrategy::SJF_PREDICTED:
 			exportState->numReady = state->sjfReadyList.size();
 			if (exportState->numReady > 0) {
 				exportState->readyList = new ProcessCompat[exportState->numReady];
 				// Need to create copy of list in order to access all elements (priority queue does not allow iteration)
 				list<PCB*> copy;
 				for (uint i = 0; i < exportState->numReady; i++) {
-					PCB* ptr = state->sjfReadyList.top();
+					PCB* ptr = state->columns.pcb[state->sjfReadyList.top()];
 
 					exportProcess(*ptr, exportState->readyList[i]);
 
@@ -377,7 +662,7 @@ OSStateCompat*
 					copy.push_back(ptr);
 				}
 				for (auto it = copy.begin(); it != copy.end(); it++) {
-					state->sjfReadyList.push(*it);
+					state->sjfReadyList.push((*it)->slot);
 				}
 
 				prevReadyListSize = exportState->numReady;
@@ -387,13 +672,14 @@ OSStateCompat*
 			}
 			break;
 		case SchedulingStrategy::SRT:
+		case SchedulingStrategy::SRT_PREDICTED:
 			exportState->numReady = state->srtReadyList.size();
 			if (exportState->numReady > 0) {
 				exportState->readyList = new ProcessCompat[exportState->numReady];
 				// Need to create copy of list in order to access all elements (priority queue does not allow iteration)
 				list<PCB*> copy;
 				for (uint i = 0; i < exportState->numReady; i++) {
-					PCB* ptr = state->srtReadyList.top();
+					PCB* ptr = state->columns.pcb[state->srtReadyList.top()];
 
 					exportProcess(*ptr, exportState->readyList[i]);
 
@@ -401,7 +687,7 @@ OSStateCompat*
 					copy.push_back(ptr);
 				}
 				for (auto it = copy.begin(); it != copy.end(); it++) {
-					state->srtReadyList.push(*it);
+					state->srtReadyList.push((*it)->slot);
 				}
 
 				prevReadyListSize = exportState->numReady;
@@ -443,7 +729,7 @@ OSStateCompat*
 
 				auto copy = state->edfReadyList;
 				for (uint i = 0; i < exportState->numReady; i++) {
-					PCB* ptr = copy.top();
+					PCB* ptr = state->columns.pcb[copy.top()];
 
 					exportProcess(*ptr, exportState->readyList[i]);
 
@@ -462,6 +748,85 @@ OSStateCompat*
 				exportState->readyList = new ProcessCompat[exportState->numReady];
 
 				auto copy = state->lstReadyList;
+				for (uint i = 0; i < exportState->numReady; i++) {
+					PCB* ptr = state->columns.pcb[copy.top()];
+
+					exportProcess(*ptr, exportState->readyList[i]);
+
+					copy.pop();
+				}
+
+				prevReadyListSize = exportState->numReady;
+			} else {
+				prevReadyListSize = 0;
+				exportState->readyList = nullptr;  // should be ignored on the other end if there are 0 processes, but set it to nullptr anyway for insurance
+			}
+			break;
+		case SchedulingStrategy::RT_PEDF:
+			// The cores' ready lists one after another (each in deadline order)
+			exportState->numReady = 0;
+			for (const auto& list : state->coreEDFReadyLists) exportState->numReady += list.size();
+			if (exportState->numReady > 0) {
+				exportState->readyList = new ProcessCompat[exportState->numReady];
+
+				i = 0;
+				for (const auto& list : state->coreEDFReadyLists) {
+					for (auto copy = list; !copy.empty(); copy.pop(), i++) {
+						exportProcess(*state->columns.pcb[copy.top()], exportState->readyList[i]);
+					}
+				}
+
+				prevReadyListSize = exportState->numReady;
+			} else {
+				prevReadyListSize = 0;
+				exportState->readyList = nullptr;  // should be ignored on the other end if there are 0 processes, but set it to nullptr anyway for insurance
+			}
+			break;
+		case SchedulingStrategy::CFS:
+			exportState->numReady = state->cfsReadyList.size();
+			if (exportState->numReady > 0) {
+				exportState->readyList = new ProcessCompat[exportState->numReady];
+
+				auto copy = state->cfsReadyList;
+				for (uint i = 0; i < exportState->numReady; i++) {
+					PCB* ptr = copy.top();
+
+					exportProcess(*ptr, exportState->readyList[i]);
+
+					copy.pop();
+				}
+
+				prevReadyListSize = exportState->numReady;
+			} else {
+				prevReadyListSize = 0;
+				exportState->readyList = nullptr;  // should be ignored on the other end if there are 0 processes, but set it to nullptr anyway for insurance
+			}
+			break;
+		case SchedulingStrategy::LOTTERY:
+			exportState->numReady = state->lotteryReadyList->size();
+			if (exportState->numReady > 0) {
+				exportState->readyList = new ProcessCompat[exportState->numReady];
+
+				// (in slot order: there is no "next" process in a lottery)
+				i = 0;
+				for (PCB* ptr : state->lotteryReadyList->slots()) {
+					if (ptr != nullptr) {
+						exportProcess(*ptr, exportState->readyList[i++]);
+					}
+				}
+
+				prevReadyListSize = exportState->numReady;
+			} else {
+				prevReadyListSize = 0;
+				exportState->readyList = nullptr;  // should be ignored on the other end if there are 0 processes, but set it to nullptr anyway for insurance
+			}
+			break;
+		case SchedulingStrategy::STRIDE:
+			exportState->numReady = state->strideReadyList.size();
+			if (exportState->numReady > 0) {
+				exportState->readyList = new ProcessCompat[exportState->numReady];
+
+				auto copy = state->strideReadyList;
 				for (uint i = 0; i < exportState->numReady; i++) {
 					PCB* ptr = copy.top();
 
@@ -10,6 +10,10 @@
 extern void initOS(uint numCores, SchedulingStrategy strategy);
 extern void cleanupOS();
 
+// Spawns a process for a release of the real-time job (under RT_PEDF, bound to the job's core, see partitionJobs)
+// Returns its pid, or -1 if there's no such program
+uint releaseJob(const RTJob& job);
+
 // The current state of a CPU (for compatibility layer)
 struct CPUState {
 	bool available;
@@ -123,21 +127,38 @@ void
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
-	loadProgram(Instruction* instructionList, uint size, char* name);
+	loadProgram(Instruction* instructionList, uint size, const char* name);
+
+// Assembles a program from .fsp source (see Assembler) and loads it into the OS
+// Returns the number of instructions loaded (0 if the source has errors)
+uint
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	loadProgramSource(const char* source, uint size, const char* name);
 
 // Gets the memory address where a program's instructions are stored (for monitoring progress since loops are a thing)
-Instruction*
+const Instruction*
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
 	getProgramLocation(char* name);
 
 // Spawns a process with the program specified by the given name
+// (nice only affects the process's share of the CPU under CFS, and tickets under LOTTERY/STRIDE; 0 tickets = the program's)
 uint
 #ifndef FEAUX_S_BENCHMARKING
 	exported
 #endif
-	spawn(const char* name, uint d);
+	spawn(const char* name, uint d, int nice = 0, uint tickets = 0);
+
+// Spawns count processes with the same program and parameters at once (for bulk arrivals, which go onto the ready list together)
+// Returns the pid of the first (the rest follow consecutively), or -1 if there's no such program
+uint
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	spawnBatch(const char* name, uint count, uint d, int nice = 0, uint tickets = 0);
 
 // Dispatches a job (periodic task) with the program specified by the given name
 void
@@ -146,6 +167,29 @@ void
 #endif
 	dispatch(const char* name, uint p, uint d, uint s);
 
+// Allow or disallow a process to run on a core (the cores past the 64th always allow every process)
+// Returns false if there's no such process, or it would be left without a core to run on
+bool
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setAffinity(uint pid, uint core, bool allowed);
+
+// Set the bin-packing heuristic that binds the real-time jobs to cores under RT_PEDF (binding the jobs dispatched so far again)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setPartitionHeuristic(PartitionHeuristic heuristic);
+
+// Turn priority inheritance on or off: under RT_EDF/RT_LST/RT_PEDF, whether a process holding a mutex runs with the earliest deadline of
+// the processes waiting on it (see sync.h)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setPriorityInheritance(bool enabled);
+
 // Pause the simulation
 void
 #ifndef FEAUX_S_BENCHMARKING
@@ -178,6 +222,20 @@ void
 #endif
 	setNumIODevices(uint8_t ioDevices);
 
+// Set the class of an I/O device (resets it to that class's default parameters, but keeps its scheduling policy)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setIODeviceClass(uint8_t device, IODeviceClass deviceClass);
+
+// Set the policy an I/O device uses to order its queued requests
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setIOSchedulingPolicy(uint8_t device, IOSchedulingPolicy policy);
+
 // Set the scheduling strategy of the OS
 // Needs to reboot OS, so will lose all processes (but keeps programs)
 void
@@ -186,6 +244,48 @@ void
 #endif
 	setSchedulingStrategy(SchedulingStrategy strategy);
 
+// Turn the per-core cache/TLB model on or off (flushOnSwitch chooses flushing over PID tagging on context switches)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setCacheModel(bool enabled, bool flushOnSwitch);
+
+// Set the extra ticks a core spends switching to a process (the warmup component is only paid if the core last ran a different process)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setContextSwitchCost(uint fixedTicks, uint registerTicks, uint cacheWarmupTicks);
+
+// Set the lottery/stride tickets that processes of a program get by default
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setProgramTickets(char* name, uint tickets);
+
+// Set the number of MLF levels (1 to NUM_LEVELS; only while there are no processes)
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFLevels(uint numLevels);
+
+// Set the CPU time a process may receive on an MLF level before being demoted
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFQuantum(uint level, uint quantum);
+
+// Set how often (in ticks, 0 = never) all MLF processes are boosted to the top level, and whether waking from I/O moves a process up a level
+void
+#ifndef FEAUX_S_BENCHMARKING
+	exported
+#endif
+	setMLFBoost(uint period, bool ioPromotion);
+
 // Get the current state of the machine
 MachineStateCompat*
 #ifndef FEAUX_S_BENCHMARKING
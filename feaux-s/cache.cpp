@@ -0,0 +1,55 @@
+#include "cache.h"
+
+using namespace std;
+
+Cache::Cache(uint sets, uint ways)
+	: _sets(sets == 0 ? 1 : sets), _ways(ways == 0 ? 1 : ways), _lines(_sets * _ways, Line{false, 0, 0, 0}), _clock(0), _hits(0), _misses(0) {}
+
+bool Cache::access(uint asid, uint64_t line) {
+	Line* set = &_lines[(line % _sets) * _ways];
+	Line* victim = set;
+
+	_clock++;
+
+	for (uint i = 0; i < _ways; i++) {
+		if (set[i].valid && set[i].asid == asid && set[i].tag == line) {
+			set[i].lastUse = _clock;
+			_hits++;
+			return true;
+		}
+
+		// Prefer an empty way, otherwise the least recently used one
+		if (victim->valid && (!set[i].valid || set[i].lastUse < victim->lastUse)) {
+			victim = &set[i];
+		}
+	}
+
+	*victim = Line{true, asid, line, _clock};
+	_misses++;
+	return false;
+}
+
+void Cache::flush() {
+	for (Line& line : _lines) {
+		line.valid = false;
+	}
+}
+
+CacheConfig defaultCacheConfig() {
+	CacheConfig config;
+
+	config.enabled = false;
+	config.lineSize = 64;
+	config.l1Sets = 64;	 // 16KB
+	config.l1Ways = 4;
+	config.l2Sets = 512;  // 256KB
+	config.l2Ways = 8;
+	config.tlbSets = 16;  // 64 entries
+	config.tlbWays = 4;
+	config.l2HitTicks = 1;
+	config.memoryTicks = 10;
+	config.tlbMissTicks = 5;
+	config.flushOnSwitch = false;
+
+	return config;
+}
@@ -0,0 +1,45 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "decls.h"
+
+// A set-associative cache with LRU replacement (used for the simulated caches and TLBs)
+// Lines are tagged with an address space ID, so that entries of different processes can live side by side
+class Cache {
+public:
+	Cache(uint sets = 1, uint ways = 1);
+
+	// Looks up a line, inserting it on a miss (evicting the least recently used line in its set); returns whether it hit
+	bool access(uint asid, uint64_t line);
+
+	// Invalidates every line
+	void flush();
+
+	// Statistics
+	uint hits() const { return _hits; }
+	uint misses() const { return _misses; }
+
+private:
+	struct Line {
+		bool valid;
+		uint asid;
+		uint64_t tag;
+		unsigned long long lastUse;
+	};
+
+	uint _sets;
+	uint _ways;
+	std::vector<Line> _lines;  // _ways consecutive lines per set
+	unsigned long long _clock;
+
+	uint _hits;
+	uint _misses;
+};
+
+// Gets the default cache/TLB parameters (the model starts disabled)
+CacheConfig defaultCacheConfig();
+
+#endif
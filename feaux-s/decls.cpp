@@ -7,36 +7,92 @@ uint nextPID = 0;
 // NOOP register state (see machine.cpp#CPU::_readNextInstruction)
 const Registers NOPROC{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
-bool SJFComparator::operator()(PCB* a, PCB* b) {
-	return a->reqProcessorTime > b->reqProcessorTime;
+// CFS weight of each nice level (-20 to 19); each level is ~1.25x the next, so a process gets ~10% more CPU than one a level nicer
+const uint NICE_TO_WEIGHT[40] = {
+	88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916, 9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+	1024, 820, 655, 526, 423, 335, 272, 215, 172, 137, 110, 87, 70, 56, 45, 36, 29, 23, 18, 15,
+};
+
+void ProcessColumns::add(PCB* proc) {
+	proc->columns = this;
+	proc->slot = pcb.size();
+
+	arrivalTime.push_back(-1);
+	doneTime.push_back(-1);
+	deadline.push_back(-1);
+	reqProcessorTime.push_back(0);
+	processorTime.push_back(0);
+	level.push_back(-1);
+	state.push_back(ready);
+	readyKey.push_back(0);
+	pcb.push_back(proc);
 }
 
-bool SRTComparator::operator()(PCB* a, PCB* b) {
-	return (a->reqProcessorTime - a->processorTime) > (b->reqProcessorTime - b->processorTime);
+void ProcessColumns::setReadyKeys(uint first, uint last, SchedulingStrategy strategy) {
+	// Plain loops over the columns, so that they vectorise (the LST one selects rather than branches on the deadline)
+	const long *deadlines = deadline.data(), *required = reqProcessorTime.data(), *received = processorTime.data();
+	long* keys = readyKey.data();
+
+	if (strategy == SchedulingStrategy::RT_LST) {
+		for (uint slot = first; slot < last; slot++) {
+			long key = deadlines[slot] - (required[slot] - received[slot]);
+			keys[slot] = deadlines[slot] == -1 ? std::numeric_limits<long>::max() : key;
+		}
+	} else {
+		for (uint slot = first; slot < last; slot++) {
+			keys[slot] = required[slot] - received[slot];
+		}
+	}
 }
 
-bool EDFComparator::operator()(PCB* a, PCB* b) {
+bool SJFComparator::operator()(uint a, uint b) {
+	const ProcessColumns& columns = state->columns;
+
+	if (state->strategy == SchedulingStrategy::SJF_PREDICTED) {	 // (the predictions aren't hot enough to be kept in columns)
+		return columns.pcb[a]->predictedBurst > columns.pcb[b]->predictedBurst;
+	}
+
+	return columns.reqProcessorTime[a] > columns.reqProcessorTime[b];
+}
+
+bool SRTComparator::operator()(uint a, uint b) {
+	const ProcessColumns& columns = state->columns;
+
+	if (state->strategy == SchedulingStrategy::SRT_PREDICTED) {
+		const PCB *procA = columns.pcb[a], *procB = columns.pcb[b];
+		return (procA->predictedBurst - (columns.processorTime[a] - procA->burstStart)) >
+			   (procB->predictedBurst - (columns.processorTime[b] - procB->burstStart));
+	}
+
+	return columns.readyKey[a] > columns.readyKey[b];
+}
+
+bool EDFComparator::operator()(uint a, uint b) {
+	long deadlineA = state->columns.deadline[a], deadlineB = state->columns.deadline[b];
+
 	// this case needs to exist to satisfy anti-commutativity of equality operation
-	if (a->deadline == -1 && b->deadline == -1) {
+	if (deadlineA == -1 && deadlineB == -1) {
 		return false;
-	} else if (a->deadline == -1) {
+	} else if (deadlineA == -1) {
 		return true;
-	} else if (b->deadline == -1) {
+	} else if (deadlineB == -1) {
 		return false;
 	} else {
-		return a->deadline > b->deadline;
+		return deadlineA > deadlineB;
 	}
 }
 
-bool LSTComparator::operator()(PCB* a, PCB* b) {
+bool LSTComparator::operator()(uint a, uint b) {
+	// (processes without a deadline are keyed after the rest, and equal to each other, as in EDFComparator)
+	return state->columns.readyKey[a] > state->columns.readyKey[b];
+}
+
+bool CFSComparator::operator()(PCB* a, PCB* b) {
+	// ties go to the older process, so that equal virtual runtimes are served in FIFO order
+	return a->vruntime != b->vruntime ? a->vruntime > b->vruntime : a->pid > b->pid;
+}
+
+bool StrideComparator::operator()(PCB* a, PCB* b) {
 	// same as above
-	if (a->deadline == -1 && b->deadline == -1) {
-		return false;
-	} else if (a->deadline == -1) {
-		return true;
-	} else if (b->deadline == -1) {
-		return false;
-	} else {
-		return (a->deadline - (a->reqProcessorTime - a->processorTime)) > (b->deadline - (b->reqProcessorTime - b->processorTime));
-	}
+	return a->pass != b->pass ? a->pass > b->pass : a->pid > b->pid;
 }
\ No newline at end of file
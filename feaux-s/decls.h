@@ -5,10 +5,15 @@
 #include <emscripten.h>
 #endif
 
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <queue>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 struct PCB;
 struct RTJob;
@@ -16,14 +21,36 @@ class IOInterrupt;
 class Interrupt;
 class CPU;
 class IODevice;
+class PhysicalMemory;
+class AddressSpace;
+class LotteryTree;
 
 #define exported EMSCRIPTEN_KEEPALIVE
-#define NUM_LEVELS 6
+#define NUM_LEVELS 6	 // The most MLF levels a simulation can use (the compatibility layer always exports this many lists)
+
+// CFS tunables (in ticks): every runnable process should run once per target latency, slices are never shorter than the minimum granularity,
+// and a woken process only preempts the running one if it is at least the wakeup granularity behind it in virtual runtime
+#define CFS_TARGET_LATENCY 32
+#define CFS_MIN_GRANULARITY 8
+#define CFS_WAKEUP_GRANULARITY 4
+// Virtual runtime is kept in fixed point: a nice 0 process gains (1 << CFS_VRUNTIME_SHIFT) per tick it runs
+#define CFS_VRUNTIME_SHIFT 16
+#define NICE_0_WEIGHT 1024
+
+// Proportional-share (lottery/stride) tunables: the ticks a process runs before the next draw/pick, the tickets a program gets unless
+// configured otherwise, and the stride numerator (a process's pass advances by STRIDE_1 / tickets per tick it runs)
+#define PROPORTIONAL_QUANTUM 4
+#define DEFAULT_TICKETS 100
+#define STRIDE_1 (1 << 20)
+
+// The weight exponential averaging gives the latest observed CPU burst when predicting the next one (SJF_PREDICTED/SRT_PREDICTED)
+#define BURST_ALPHA 0.5
 typedef unsigned int uint;
 typedef unsigned char uint8_t;
 
 // The OS action at the current step of the simulation
-enum StepAction { NOOP, HANDLE_INTERRUPT, BEGIN_RUN, CONTINUE_RUN, HANDLE_SYSCALL, SERVICE_REQUEST };
+// (CONTEXT_SWITCH = the core is still paying the extra cost of switching to the process it just began running)
+enum StepAction { NOOP, HANDLE_INTERRUPT, BEGIN_RUN, CONTINUE_RUN, HANDLE_SYSCALL, SERVICE_REQUEST, CONTEXT_SWITCH };
 // The scheduling strategies
 // FIFO = First In, First Out
 // SJF = Shortest Job First
@@ -32,18 +59,60 @@ enum StepAction { NOOP, HANDLE_INTERRUPT, BEGIN_RUN, CONTINUE_RUN, HANDLE_SYSCAL
 // RT_* = Real-Time
 // EDF = Earliest Deadline First
 // LST = Least Slack time
-enum SchedulingStrategy { FIFO, SJF, SRT, MLF, RT_FIFO, RT_EDF, RT_LST };
+// CFS = Completely Fair Scheduler (weighted virtual runtime)
+// LOTTERY/STRIDE = proportional share (randomized/deterministic) by tickets
+// *_PREDICTED = SJF/SRT on CPU bursts predicted from each program's past bursts, instead of the (static) program length
+// RT_PEDF = partitioned EDF (each real-time job is bound to a core, see partitionJobs, and each core runs EDF over its own ready list)
+enum SchedulingStrategy { FIFO, SJF, SRT, MLF, RT_FIFO, RT_EDF, RT_LST, CFS, LOTTERY, STRIDE, SJF_PREDICTED, SRT_PREDICTED, RT_PEDF };
+// The bin-packing heuristics that bind real-time jobs to cores under RT_PEDF (see partitionJobs), both taking the jobs by decreasing
+// utilization
+// FIRST_FIT_DECREASING = each job goes on the first core it fits on (packing the cores tightly)
+// WORST_FIT_DECREASING = each job goes on the least loaded core (spreading the load evenly)
+enum PartitionHeuristic { FIRST_FIT_DECREASING, WORST_FIT_DECREASING };
 // The states a process can be in
 enum State { ready, processing, blocked, done, dead };
 // The opcodes for CPU instructions
-enum Opcode { NOP, WORK, IO, EXIT, LOAD, MOVE, ALLOC, FREE, SW, CMP, JL, JLE, JE, JGE, JG, INC, ADD, SUB };
+// AIO/AIOBATCH submit I/O without blocking and return a completion handle in %rax, which AIOPOLL/AIOWAIT take in a register
+// LOCK/UNLOCK take a mutex and SEMWAIT/SEMPOST/SEMINIT a semaphore by its (immediate) id, and return 0 in %rax, or -1 if misused (see sync.h)
+enum Opcode {
+	NOP, WORK, IO, EXIT, LOAD, MOVE, ALLOC, FREE, SW, CMP, JL, JLE, JE, JGE, JG, INC, ADD, SUB, AIO, AIOBATCH, AIOPOLL, AIOWAIT,
+	LOCK, UNLOCK, SEMWAIT, SEMPOST, SEMINIT
+};
 // The available x86-64 registers (yes i know in my imiplementation they're 32-bit, not 64-bit,
 // but WASM interacts weirdly with unsigned long longs for some reason)
 enum Regs { RAX, RCX, RDX, RBX, RSI, RDI, RSP, RBP, R8, R9, R10, R11, R12, R13, R14, R15 };
 // The types of interrupt that can occur
 enum InterruptType { IO_COMPLETION };
 // The syscalls available to processes
-enum Syscall { SYS_NONE, SYS_IO, SYS_EXIT, SYS_ALLOC, SYS_FREE };
+// (SYS_FAULT is not a real syscall: the CPU raises it when a process touches memory it doesn't own)
+enum Syscall {
+	SYS_NONE, SYS_IO, SYS_EXIT, SYS_ALLOC, SYS_FREE, SYS_AIO_SUBMIT, SYS_AIO_POLL, SYS_AIO_WAIT, SYS_FAULT,
+	SYS_LOCK, SYS_UNLOCK, SYS_SEM_WAIT, SYS_SEM_POST, SYS_SEM_INIT
+};
+// The kinds of I/O device that can be simulated
+// GENERIC = services each request in exactly the requested number of ticks
+// DISK = rotating disk (seek + rotational latency + transfer)
+// SSD = flash storage with several channels servicing requests in parallel
+// NETWORK = network link with a latency distribution and limited bandwidth
+enum IODeviceClass { GENERIC, DISK, SSD, NETWORK };
+// The policies an I/O device can use to pick the next queued request
+// IO_FIFO = First In, First Out
+// IO_SSTF = Shortest Seek Time First
+// IO_ELEVATOR = SCAN (sweep back and forth across the blocks, servicing requests on the way)
+// IO_DEADLINE = Elevator, but requests that have waited past the device's expiry time go first
+enum IOSchedulingPolicy { IO_FIFO, IO_SSTF, IO_ELEVATOR, IO_DEADLINE };
+// The shapes of latency distributions that devices can sample from
+enum DistributionType { CONSTANT, UNIFORM, EXPONENTIAL };
+// How much is known about the number of instructions a program executes (see analyzeProgram)
+// COST_EXACT = every process running it executes exactly that many
+// COST_BOUNDED = it branches on values only known at runtime, so that many is the most any process executes
+// COST_UNKNOWN = the analysis couldn't bound it, so the program length is used instead
+enum CostKind { COST_EXACT, COST_BOUNDED, COST_UNKNOWN };
+// The outcomes of a simulated memory access
+// ACCESS_MINOR_FAULT = the page had never been touched, so it was given a zeroed frame
+// ACCESS_MAJOR_FAULT = the page had been evicted, so it was read back in from swap
+// ACCESS_SEGFAULT = the address is not part of any allocation of the process
+enum AccessResult { ACCESS_OK, ACCESS_MINOR_FAULT, ACCESS_MAJOR_FAULT, ACCESS_SEGFAULT };
 
 // A CPU instruction
 struct Instruction {
@@ -52,30 +121,48 @@ struct Instruction {
 	uint operand2;
 };
 
+// Programs' code is laid out in the simulated address space from CODE_BASE_ADDRESS (past any (32 bit) data address), each starting on a
+// new CODE_PAGE_SIZE page
+#define CODE_BASE_ADDRESS (1ull << 32)
+#define CODE_PAGE_SIZE 4096
+
 // A program that is recognized by the OS
+// Programs are moved, never copied: their instructions are immutable and shared (reference counted) with whatever else holds them, e.g.
+// the mapped program image they came from, so there's nothing a copy would need its own of
 struct Program {
 	// Makes a "blank" program
-	Program() : name(""), length(0), instructions(nullptr) {}
+	Program() : name(""), length(0), tickets(DEFAULT_TICKETS), predictedBurst(0), cost(0), costKind(COST_UNKNOWN), codeAddress(0) {}
 	// Constructs a program from the given data
-	Program(const std::string& name, uint length, Instruction* instructions) : name(name), length(length), instructions(instructions) {}
-	// Copies another program
-	Program(const Program& other) : name(other.name), length(other.length), instructions(new Instruction[other.length]) {
-		for (uint i = 0; i < length; i++) {
-			instructions[i] = other.instructions[i];
-		}
-	}
+	Program(const std::string& name, uint length, std::shared_ptr<const Instruction> instructions)
+		: name(name),
+		  length(length),
+		  instructions(std::move(instructions)),
+		  tickets(DEFAULT_TICKETS),
+		  predictedBurst(length == 0 ? 0 : length - 1),
+		  cost(length == 0 ? 0 : length - 1),
+		  costKind(COST_UNKNOWN),
+		  codeAddress(0) {}
+	Program(const Program&) = delete;
+	Program& operator=(const Program&) = delete;
+	Program(Program&&) = default;
+	Program& operator=(Program&&) = default;
 
 	// The name of the program (will be shared by processes executing this program's instructions)
 	std::string name;
 	// The size of the program
 	uint length;
-	Instruction* instructions;
-
-	// Necessary to store programs in a map (i think, actually maybe not but im not going to remove it because :P)
-	bool operator<(const Program& other) { return name < other.name; }
-
-	// Free a program
-	~Program() { delete[] instructions; }
+	std::shared_ptr<const Instruction> instructions;
+	// The lottery/stride tickets processes of this program get (unless given their own at spawn)
+	uint tickets;
+	// The exponential average of the CPU bursts (runs between blocking I/O) processes of this program have had (starts at the static cost)
+	double predictedBurst;
+	// The number of instructions processes of this program execute before exiting, as found by analyzeProgram when it was loaded
+	uint cost;
+	CostKind costKind;
+	// Where the program's code sits in the simulated address space, which its instruction fetches go through the caches at (programs are
+	// laid out one after another as they're loaded, so that the caches behave the same from one run to the next, wherever the host put
+	// the instructions)
+	uint64_t codeAddress;
 };
 
 #define FLAG_CY 0x0001
@@ -110,10 +197,119 @@ struct Registers {
 	uint r15;  // %r15
 };
 
+// Block address used by I/O instructions that don't specify one (the device picks a block in the process's own region)
+#define NO_BLOCK 0xFFFFFFFF
+
 // An I/O request made by a process
 struct IORequest {
 	uint pid;
-	uint duration;
+	uint duration;	  // The size of the request (in ticks for GENERIC devices, in blocks otherwise)
+	uint block;		  // The block address the request targets
+	uint submitTime;  // The time at which the process issued the request
+	uint handle;	  // The completion handle of an asynchronous request (0 for blocking requests)
+};
+
+// A latency distribution (in ticks)
+struct Distribution {
+	DistributionType type;
+	double a;  // The constant value (CONSTANT), lower bound (UNIFORM) or mean (EXPONENTIAL)
+	double b;  // The upper bound (UNIFORM only)
+};
+
+// The parameters of a simulated I/O device (see machine.cpp#defaultIODeviceConfig for the defaults of each class)
+struct IODeviceConfig {
+	IODeviceClass deviceClass;
+	IOSchedulingPolicy policy;
+	uint queueDepth;  // The number of requests the device will hold (in service + queued); any more wait in the OS's pending list
+	uint channels;	  // The number of requests the device services at the same time
+	uint numBlocks;	  // The number of addressable blocks
+	uint deadlineExpiry;  // How long a request may wait before IO_DEADLINE serves it ahead of the elevator order
+
+	// DISK
+	uint blocksPerTrack;
+	double seekBase;			   // Fixed cost of any nonzero seek
+	double seekPerTrack;		   // Additional cost per track travelled
+	Distribution rotationalLatency;
+
+	// DISK, SSD
+	double transferPerBlock;  // Ticks to transfer a single block
+
+	// SSD, NETWORK
+	Distribution accessLatency;	 // Latency before the first block is transferred (flash access time/network round trip)
+
+	// NETWORK
+	double bandwidth;  // Blocks transferred per tick
+
+	uint seed;	// Seed for the device's random number generator (latency sampling)
+};
+
+// The parameters of the per-core cache hierarchy (L1, L2) and TLB model
+struct CacheConfig {
+	bool enabled;  // When disabled, every instruction costs exactly one tick
+	uint lineSize;	// Bytes per cache line
+	uint l1Sets;
+	uint l1Ways;
+	uint l2Sets;
+	uint l2Ways;
+	uint tlbSets;
+	uint tlbWays;
+	uint l2HitTicks;	 // Stall for an L1 miss that hits in L2
+	uint memoryTicks;	 // Stall for a miss in both levels
+	uint tlbMissTicks;	 // Stall for walking the page table on a TLB miss
+	bool flushOnSwitch;	 // Flush L1 and the TLB when a different process starts running (otherwise entries are tagged by PID)
+};
+
+// A process may run on core i if bit i of its affinity mask is set (PCB::affinity), and on any core past the 64th
+#define AFFINITY_ALL (~0ull)
+
+// The cost of switching a core to a process, on top of the tick spent dispatching it (BEGIN_RUN)
+struct ContextSwitchConfig {
+	uint fixedTicks;		// Charged on every switch (entering/leaving the kernel, scheduler bookkeeping)
+	uint registerTicks;		// Charged on every switch for saving the old and restoring the new register state
+	uint cacheWarmupTicks;	// Charged when the core last ran a different process (its caches are cold for the new one)
+};
+
+// The MLF (Multi-Level Feedback) parameters of a simulation
+struct MLFConfig {
+	uint numLevels;			   // The number of levels in use (at most NUM_LEVELS)
+	uint quanta[NUM_LEVELS];   // The CPU time a process may receive on each level before being demoted (the last level has no limit)
+	uint boostPeriod;		   // Every this many ticks, all processes are boosted back to the top level (0 = never)
+	bool ioPromotion;		   // Whether a process moves up a level when it wakes from blocking I/O
+};
+
+// A mutex kept by the kernel (see sync.h), made the first time a process locks it
+struct Mutex {
+	uint id;
+	PCB* owner;				  // The process holding it (nullptr = unlocked)
+	std::list<PCB*> waiters;  // The processes blocked on it, in the order they blocked
+	uint acquiredAt;		  // When the owner took it
+};
+
+// A counting semaphore kept by the kernel (see sync.h), made (with a count of 0) the first time a process uses it
+struct Semaphore {
+	uint count;
+	std::list<PCB*> waiters;  // The processes blocked on it (only while the count is 0), in the order they blocked
+};
+
+// How long a simulation's processes held and waited on mutexes/semaphores
+struct SyncStats {
+	uint lockAcquisitions;					// The times a process took a mutex
+	uint contendedLocks;					// The ones it had to block for (it was held)
+	unsigned long long lockHoldTicks;		// The total ticks mutexes were held (up to their release)
+	unsigned long long lockWaitTicks;		// The total ticks processes were blocked on mutexes
+	uint maxLockWait;						// The longest a process was blocked on a mutex
+	uint semaphoreWaits;					// The times a process blocked on a semaphore
+	unsigned long long semaphoreWaitTicks;	// The total ticks processes were blocked on semaphores
+	uint inheritances;						// The times priority inheritance moved a mutex owner's deadline up
+};
+
+// The parameters of the simulated physical memory
+struct MemoryConfig {
+	uint numFrames;		   // The number of physical page frames shared by all processes
+	uint minorFaultTicks;  // Stall for giving an untouched page a zeroed frame
+	uint majorFaultTicks;  // Stall for reading an evicted page back in from swap
+	uint writebackTicks;   // Stall for writing a dirty page out to swap when its frame is taken
+	uint maxVirtualPages;  // The size of each process's address space (in pages)
 };
 
 // The current state of the simulation machine
@@ -123,52 +319,125 @@ struct MachineState {
 	uint clockDelay;
 	CPU** cores;		   // note: these are not 2-d arrays, just arrays of pointers (so that i can use nullptr)
 	IODevice** ioDevices;  // note: these are not 2-d arrays, just arrays of pointers (so that i can use nullptr)
+	PhysicalMemory* memory;
 };
 
-// A class for the SJF (Shortest Job First) priority queue to be able to compare 2 processes
+// A class for the SJF (Shortest Job First) priority queue to be able to compare 2 processes (by slot)
 class SJFComparator {
 public:
-	bool operator()(PCB* a, PCB* b);
+	bool operator()(uint a, uint b);
 };
 
-// A class for the SRT (Shortest Remaining Time) priority queue to be able to compare 2 processes
+// A class for the SRT (Shortest Remaining Time) priority queue to be able to compare 2 processes (by slot)
 class SRTComparator {
 public:
-	bool operator()(PCB* a, PCB* b);
+	bool operator()(uint a, uint b);
 };
 
-// A class for the EDF (Earliest Deadline First) priority queue to be able to compare 2 processes
+// A class for the EDF (Earliest Deadline First) priority queue to be able to compare 2 processes (by slot)
 class EDFComparator {
 public:
-	bool operator()(PCB* a, PCB* b);
+	bool operator()(uint a, uint b);
 };
 
-// A class for the LST (Least Slack Time) priority queue to be able to compare 2 processes
+// A class for the LST (Least Slack Time) priority queue to be able to compare 2 processes (by slot)
 class LSTComparator {
+public:
+	bool operator()(uint a, uint b);
+};
+
+// A class for the CFS (Completely Fair Scheduler) priority queue to be able to compare 2 processes
+class CFSComparator {
 public:
 	bool operator()(PCB* a, PCB* b);
 };
 
+// A class for the STRIDE priority queue to be able to compare 2 processes
+class StrideComparator {
+public:
+	bool operator()(PCB* a, PCB* b);
+};
+
+// The hot scheduling fields of the processes, kept out of their PCBs as columns (one entry per process, at PCB::slot), so that the ready
+// list comparators and the loops over every process stream through contiguous memory instead of chasing PCB pointers
+// The PCB's accessors (eg. PCB::processorTime()) read and write these
+struct ProcessColumns {
+	std::vector<long> arrivalTime;		 // See PCB::arrivalTime()
+	std::vector<long> doneTime;			 // See PCB::doneTime()
+	std::vector<long> deadline;			 // See PCB::deadline()
+	std::vector<long> reqProcessorTime;	 // See PCB::reqProcessorTime()
+	std::vector<long> processorTime;	 // See PCB::processorTime()
+	std::vector<uint> level;			 // See PCB::level()
+	std::vector<State> state;			 // See PCB::state()
+	std::vector<long> readyKey;			 // What the process is ordered by on the SRT/LST ready list, while it's on it (see setReadyKeys)
+	std::vector<PCB*> pcb;				 // The process in each slot
+
+	// Gives the process the next slot (with the same defaults as a new PCB's other fields)
+	void add(PCB* proc);
+	uint size() const { return pcb.size(); }
+
+	// The time the process needs to run to completion
+	long remaining(uint slot) const { return reqProcessorTime[slot] - processorTime[slot]; }
+	// The process's deadline, or the largest long for a process without one (so that it's ordered after the ones with)
+	long edfKey(uint slot) const { return deadline[slot] == -1 ? std::numeric_limits<long>::max() : deadline[slot]; }
+	// The process's slack less the current time (the same for every process, so it orders them just as well), or the largest long for a
+	// process without a deadline (so that it's ordered after the ones with)
+	long lstKey(uint slot) const { return deadline[slot] == -1 ? std::numeric_limits<long>::max() : deadline[slot] - remaining(slot); }
+	// Sets the ready keys of the slots [first, last) for the strategy: the remaining time for SRT, lstKey for LST
+	// The key is set as the process is put on the ready list; it doesn't run while it's there, so the key can't go stale
+	void setReadyKeys(uint first, uint last, SchedulingStrategy strategy);
+};
+
 // The data kept track of by the OS
 struct OSState {
 	std::list<RTJob*> jobList;												   // A list of all the real-time jobs scheduled
 	std::list<PCB*> processList;											   // A list of all the processes that have/are/will execute
+	std::unordered_map<uint, PCB*> processTable;							   // The processes in the process list, by pid
+	ProcessColumns columns;													   // The hot scheduling fields of the processes in the process list
+	uint finishedProcesses;													   // The number of processes in the process list that are done or dead
 	std::list<Interrupt*> interrupts;										   // A list of the interrupts that the OS has yet to handle
 	std::queue<PCB*> fifoReadyList;											   // The ready list for the FIFO scheduling algorithm
-	std::priority_queue<PCB*, std::vector<PCB*>, SJFComparator> sjfReadyList;  // The ready list for the SJF scheduling algorithm
-	std::priority_queue<PCB*, std::vector<PCB*>, SRTComparator> srtReadyList;  // The ready list for the SRT scheduling algorithm
-	std::priority_queue<PCB*, std::vector<PCB*>, EDFComparator> edfReadyList;  // The ready list for the RT_EDF scheduling algorithm
-	std::priority_queue<PCB*, std::vector<PCB*>, LSTComparator> lstReadyList;  // The ready list for the RT_LST scheduling algorithm
-	std::queue<PCB*>* mlfLists;												   // The ready lists for the MLF scheduling algorithm (will always be 6 long)
+	std::priority_queue<uint, std::vector<uint>, SJFComparator> sjfReadyList;  // The ready list for the SJF scheduling algorithm (of slots)
+	std::priority_queue<uint, std::vector<uint>, SRTComparator> srtReadyList;  // The ready list for the SRT scheduling algorithm (of slots)
+	std::priority_queue<uint, std::vector<uint>, EDFComparator> edfReadyList;  // The ready list for the RT_EDF scheduling algorithm (of slots)
+	std::priority_queue<uint, std::vector<uint>, LSTComparator> lstReadyList;  // The ready list for the RT_LST scheduling algorithm (of slots)
+	std::vector<std::priority_queue<uint, std::vector<uint>, EDFComparator>> coreEDFReadyLists;	 // The ready list of each core for RT_PEDF
+	PartitionHeuristic partitionHeuristic;	// How partitionJobs binds the real-time jobs to cores
+	bool pinning;							// Whether any process has been kept off some core (so schedule() has to check affinity masks)
+	std::priority_queue<PCB*, std::vector<PCB*>, CFSComparator> cfsReadyList;  // The ready list for the CFS scheduling algorithm
+	unsigned long long cfsMinVruntime;										   // The (monotonic) smallest virtual runtime CFS has dispatched
+	unsigned long cfsReadyWeight;											   // The total weight of the processes in the CFS ready list
+	LotteryTree* lotteryReadyList;											   // The ready list for the LOTTERY scheduling algorithm
+	std::priority_queue<PCB*, std::vector<PCB*>, StrideComparator> strideReadyList;	 // The ready list for the STRIDE scheduling algorithm
+	unsigned long long strideGlobalPass;	// The (monotonic) smallest pass STRIDE has dispatched
+	double burstPredictionError;  // The total (absolute) error of the burst predictions checked so far
+	double oracleBurstError;	  // The total (absolute) error the static program costs would have had as burst predictions
+	uint predictedBursts;		  // The number of burst predictions checked so far
+	MLFConfig mlfConfig;
+	uint mlfEpoch;	// The number of priority boosts so far (processes whose level predates the last boost are lazily moved to the top level)
+	std::queue<PCB*>* mlfLists;												   // The ready lists for the MLF scheduling algorithm (always NUM_LEVELS long)
 	std::list<PCB*> reentryList;											   // The list of processes that, on this cycle, had I/O operations complete
 	std::queue<IORequest> pendingRequests;	// The pending I/O requests (raised by a process, but all I/O Devices were busy)
 	StepAction* stepAction;					// The current action for each core at this step of the simulation
 	Syscall* pendingSyscalls;				// The pending syscalls for each core
 	PCB** runningProcess;					// The currently running process for each core
+	uint* switchRemaining;					// The context switch ticks each core has left to pay before its process runs
+	uint* lastProcess;						// The PID of the last process dispatched on each core
+	bool* rtPreempt;						// Whether global EDF/LST preempts the process on each core this tick (see pickRTPreemptions)
+	ContextSwitchConfig switchCost;
+	uint contextSwitches;					// The number of times a process was dispatched on a core
+	uint preemptions;						// The number of those dispatches that took the core from a running process
+	uint migrations;						// The number of those dispatches that moved a process to another core than it last ran on
+	unsigned long long switchTicks;			// Core ticks lost to the extra context switch cost
 	uint time;
 	bool paused;
 	SchedulingStrategy strategy;
-	std::map<std::string, Program> programs;  // The set of all programs known to the OS
+	std::unordered_map<uint, Mutex> mutexes;			// The mutexes processes have used, by id
+	std::unordered_map<uint, Semaphore> semaphores;		// The semaphores processes have used, by id
+	bool priorityInheritance;							// Whether mutex owners inherit their waiters' deadlines under EDF/LST/PEDF (see sync.h)
+	SyncStats syncStats;
+	std::unordered_map<std::string, Program> programs;	// The set of all programs known to the OS
+	uint64_t nextCodeAddress;							// Where the code of the next program loaded goes (see Program::codeAddress)
 };
 
 // Some declarations for global state
@@ -176,5 +445,6 @@ extern MachineState* machine;
 extern OSState* state;
 extern uint nextPID;
 extern const Registers NOPROC;
+extern const uint NICE_TO_WEIGHT[40];
 
 #endif
\ No newline at end of file
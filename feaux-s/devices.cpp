@@ -0,0 +1,97 @@
+#include "devices.h"
+
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+uint DiskDevice::_serviceTime(const IORequest& req) {
+	uint fromTrack = _head / _config.blocksPerTrack, toTrack = req.block / _config.blocksPerTrack;
+	uint distance = fromTrack > toTrack ? fromTrack - toTrack : toTrack - fromTrack;
+	double time = _sample(_config.rotationalLatency) + req.duration * _config.transferPerBlock;
+
+	if (distance != 0) {
+		time += _config.seekBase + distance * _config.seekPerTrack;
+	}
+
+	return (uint)ceil(time);
+}
+
+uint SSDDevice::_serviceTime(const IORequest& req) { return (uint)ceil(_sample(_config.accessLatency) + req.duration * _config.transferPerBlock); }
+
+uint NetworkDevice::_serviceTime(const IORequest& req) { return (uint)ceil(_sample(_config.accessLatency) + req.duration / _config.bandwidth); }
+
+IODeviceConfig defaultIODeviceConfig(IODeviceClass deviceClass) {
+	IODeviceConfig config;
+
+	config.deviceClass = deviceClass;
+	config.policy = IOSchedulingPolicy::IO_FIFO;
+	config.queueDepth = 1;
+	config.channels = 1;
+	config.numBlocks = 1;
+	config.deadlineExpiry = 0;
+	config.blocksPerTrack = 1;
+	config.seekBase = 0;
+	config.seekPerTrack = 0;
+	config.rotationalLatency = Distribution{DistributionType::CONSTANT, 0, 0};
+	config.transferPerBlock = 0;
+	config.accessLatency = Distribution{DistributionType::CONSTANT, 0, 0};
+	config.bandwidth = 1;
+	config.seed = 1;
+
+	switch (deviceClass) {
+		case IODeviceClass::GENERIC:  // One request at a time, the rest wait in the OS (the original model)
+			break;
+		case IODeviceClass::DISK:  // 1024 tracks of 64 blocks, ~10 ticks for a full-stroke seek
+			config.policy = IOSchedulingPolicy::IO_ELEVATOR;
+			config.queueDepth = 32;
+			config.numBlocks = 1 << 16;
+			config.deadlineExpiry = 50;
+			config.blocksPerTrack = 64;
+			config.seekBase = 2;
+			config.seekPerTrack = 0.008;
+			config.rotationalLatency = Distribution{DistributionType::UNIFORM, 0, 4};
+			config.transferPerBlock = 0.25;
+			break;
+		case IODeviceClass::SSD:
+			config.queueDepth = 32;
+			config.channels = 4;
+			config.numBlocks = 1 << 16;
+			config.transferPerBlock = 0.1;
+			config.accessLatency = Distribution{DistributionType::CONSTANT, 1, 0};
+			break;
+		case IODeviceClass::NETWORK:  // Requests are independent connections sharing the link
+			config.queueDepth = 64;
+			config.channels = 8;
+			config.numBlocks = 1;
+			config.accessLatency = Distribution{DistributionType::EXPONENTIAL, 5, 0};
+			config.bandwidth = 2;
+			break;
+	}
+
+	return config;
+}
+
+IODevice* makeIODevice(uint8_t id, const IODeviceConfig& config) {
+	switch (config.deviceClass) {
+		case IODeviceClass::DISK:
+			return new DiskDevice(id, config);
+		case IODeviceClass::SSD:
+			return new SSDDevice(id, config);
+		case IODeviceClass::NETWORK:
+			return new NetworkDevice(id, config);
+		case IODeviceClass::GENERIC:
+		default:
+			return new IODevice(id, config);
+	}
+}
+
+void configureIODevice(uint8_t id, const IODeviceConfig& config) {
+	if (id >= machine->numIODevices) {
+		cerr << "Debug: attempting to configure nonexistent I/O device " << (uint)id << endl;
+		return;
+	}
+
+	delete machine->ioDevices[id];
+	machine->ioDevices[id] = makeIODevice(id, config);
+}
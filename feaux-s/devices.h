@@ -0,0 +1,43 @@
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include "decls.h"
+#include "machine.h"
+
+// A rotating disk: requests pay for moving the head to the right track, waiting for the block to rotate under it, and the transfer itself
+class DiskDevice : public IODevice {
+public:
+	DiskDevice(uint8_t id, const IODeviceConfig& config) : IODevice(id, config) {}
+
+protected:
+	uint _serviceTime(const IORequest& req) override;
+};
+
+// Flash storage: no seek cost, but several channels service requests in parallel
+class SSDDevice : public IODevice {
+public:
+	SSDDevice(uint8_t id, const IODeviceConfig& config) : IODevice(id, config) {}
+
+protected:
+	uint _serviceTime(const IORequest& req) override;
+};
+
+// A network link: each request pays a (sampled) round trip latency, then transfers at the link's bandwidth
+class NetworkDevice : public IODevice {
+public:
+	NetworkDevice(uint8_t id, const IODeviceConfig& config) : IODevice(id, config) {}
+
+protected:
+	uint _serviceTime(const IORequest& req) override;
+};
+
+// Gets the default parameters for the given class of I/O device
+IODeviceConfig defaultIODeviceConfig(IODeviceClass deviceClass);
+
+// Creates an I/O device of the class given in the config
+IODevice* makeIODevice(uint8_t id, const IODeviceConfig& config);
+
+// Replaces the I/O device with the given ID by one built from the config (any requests it was holding are dropped)
+void configureIODevice(uint8_t id, const IODeviceConfig& config);
+
+#endif
@@ -0,0 +1,231 @@
+#include "fusion.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "utils.h"
+
+using namespace std;
+
+// The registers, in Regs order (so fused operations can reach them without going through getRegister)
+static uint Registers::*const REGISTER_FIELDS[] = {&Registers::rax, &Registers::rcx, &Registers::rdx, &Registers::rbx, &Registers::rsi, &Registers::rdi,
+												   &Registers::rsp, &Registers::rbp, &Registers::r8,  &Registers::r9,  &Registers::r10, &Registers::r11,
+												   &Registers::r12, &Registers::r13, &Registers::r14, &Registers::r15};
+
+bool jumpTaken(Opcode opcode, uint flags) {
+	bool cy = flags & FLAG_CY, zf = flags & FLAG_ZF;
+
+	switch (opcode) {
+		case Opcode::JL:
+			return cy && !zf;
+		case Opcode::JLE:
+			return cy;
+		case Opcode::JE:
+			return zf;
+		case Opcode::JGE:
+			return !cy;
+		case Opcode::JG:
+			return !cy && !zf;
+		default:
+			return false;
+	}
+}
+
+static bool isJump(Opcode opcode) {
+	return opcode == Opcode::JL || opcode == Opcode::JLE || opcode == Opcode::JE || opcode == Opcode::JGE || opcode == Opcode::JG;
+}
+
+// Sets the flags the way CMP does
+static void compare(Registers& regs, uint a, uint b) {
+	regs.flags &= (~FLAG_CY & ~FLAG_ZF);
+	if (a == b) {
+		regs.flags |= (FLAG_CY | FLAG_ZF);
+	} else if (a < b) {
+		regs.flags |= FLAG_CY;
+	}
+}
+
+// Whether the instruction can be part of a block (it only touches valid registers, and can't stall, fault or call into the kernel)
+static bool fusable(const Instruction& instruction) {
+	switch (instruction.opcode) {
+		case Opcode::NOP:
+		case Opcode::WORK:
+		case Opcode::JL:
+		case Opcode::JLE:
+		case Opcode::JE:
+		case Opcode::JGE:
+		case Opcode::JG:
+			return true;
+		case Opcode::LOAD:
+			return instruction.operand2 <= R15;
+		case Opcode::INC:
+			return instruction.operand1 <= R15;
+		case Opcode::MOVE:
+		case Opcode::CMP:
+		case Opcode::ADD:
+		case Opcode::SUB:
+			return instruction.operand1 <= R15 && instruction.operand2 <= R15;
+		default:
+			return false;
+	}
+}
+
+void executeRegisterOp(Registers& regs, const Instruction& instruction) {
+	switch (instruction.opcode) {
+		case Opcode::LOAD: {
+			uint* dest = getRegister(regs, (Regs)instruction.operand2);
+			*dest = instruction.operand1;
+			break;
+		}
+		case Opcode::MOVE: {
+			uint *dest = getRegister(regs, (Regs)instruction.operand2), *src = getRegister(regs, (Regs)instruction.operand1);
+			*dest = *src;
+			break;
+		}
+		case Opcode::CMP:
+			compare(regs, *getRegister(regs, (Regs)instruction.operand1), *getRegister(regs, (Regs)instruction.operand2));
+			break;
+		case Opcode::JL:
+		case Opcode::JLE:
+		case Opcode::JE:
+		case Opcode::JGE:
+		case Opcode::JG:
+			if (jumpTaken(instruction.opcode, regs.flags))
+				// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
+				regs.rip = (regs.rip - sizeof(Instruction)) + (int)instruction.operand1;
+			break;
+		case Opcode::INC: {
+			uint* loc = getRegister(regs, (Regs)instruction.operand1);
+
+			(*loc)++;
+			break;
+		}
+		case Opcode::ADD: {
+			uint *src = getRegister(regs, (Regs)instruction.operand1), *dest = getRegister(regs, (Regs)instruction.operand2);
+
+			regs.flags &= (~FLAG_CY & ~FLAG_ZF);
+			if (*dest > numeric_limits<uint>::max() - *src) {
+				if (*src != 0 && *dest == numeric_limits<uint>::max() - *src + 1) {
+					regs.flags |= FLAG_ZF;
+				}
+
+				regs.flags |= FLAG_CY;
+			}
+
+			*dest += *src;
+			break;
+		}
+		case Opcode::SUB: {
+			uint *src = getRegister(regs, (Regs)instruction.operand1), *dest = getRegister(regs, (Regs)instruction.operand2);
+
+			regs.flags &= (~FLAG_CY & ~FLAG_ZF);
+			if (*dest >= *src) {
+				if (*dest == *src) {
+					regs.flags |= FLAG_ZF;
+				}
+
+				regs.flags |= FLAG_CY;
+			}
+
+			*dest -= *src;
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void translateBlock(const Instruction* start, const Instruction* end, FusedBlock& block) {
+	const Instruction* at = start;
+
+	block.address = (uint64_t)(uintptr_t)start;
+	block.length = 0;
+	block.numOps = 0;
+
+	// A jump ends the block (so that only its last instruction can move the instruction pointer)
+	while (block.length < FUSED_BLOCK_MAX && at < end && fusable(at[0])) {
+		FusedOp& op = block.ops[block.numOps];
+		// The instructions left to look at (never past the end of the program, which may not finish with an EXIT)
+		uint room = min((uint)(FUSED_BLOCK_MAX - block.length), (uint)(end - at));
+
+		if (at[0].opcode == Opcode::NOP || at[0].opcode == Opcode::WORK) {
+			if (block.numOps > 0 && block.ops[block.numOps - 1].kind == FUSED_SKIP) {  // Extend the run
+				block.length++;
+				at++;
+				continue;
+			}
+
+			op.kind = FUSED_SKIP;
+			block.length++;
+			at++;
+		} else if (at[0].opcode == Opcode::INC && room >= 3 && at[1].opcode == Opcode::CMP && fusable(at[1]) && isJump(at[2].opcode)) {
+			op.kind = FUSED_INC_CMP_JCC;
+			op.regs[0] = at[0].operand1;
+			op.regs[1] = at[1].operand1;
+			op.regs[2] = at[1].operand2;
+			op.jump = at[2].opcode;
+			op.values[0] = at[2].operand1;
+			block.length += 3;
+			block.numOps++;
+			break;
+		} else if (at[0].opcode == Opcode::LOAD && room >= 2 && at[1].opcode == Opcode::LOAD && fusable(at[1])) {
+			op.kind = FUSED_LOAD_LOAD;
+			op.regs[0] = at[0].operand2;
+			op.values[0] = at[0].operand1;
+			op.regs[1] = at[1].operand2;
+			op.values[1] = at[1].operand1;
+			block.length += 2;
+			at += 2;
+		} else if (at[0].opcode == Opcode::LOAD) {
+			op.kind = FUSED_LOAD;
+			op.regs[0] = at[0].operand2;
+			op.values[0] = at[0].operand1;
+			block.length++;
+			at++;
+		} else {
+			op.kind = FUSED_OTHER;
+			op.instruction = at[0];
+			block.length++;
+			block.numOps++;
+
+			if (isJump(at[0].opcode)) {
+				break;
+			}
+			at++;
+			continue;
+		}
+
+		block.numOps++;
+	}
+}
+
+void runBlock(const FusedBlock& block, Registers& regs) {
+	// Every instruction that can move the instruction pointer is at the end of the block, so it can be advanced past the block up front
+	regs.rip = block.address + block.length * sizeof(Instruction);
+
+	for (uint i = 0; i < block.numOps; i++) {
+		const FusedOp& op = block.ops[i];
+
+		switch (op.kind) {
+			case FUSED_SKIP:
+				break;
+			case FUSED_LOAD:
+				regs.*REGISTER_FIELDS[op.regs[0]] = op.values[0];
+				break;
+			case FUSED_LOAD_LOAD:
+				regs.*REGISTER_FIELDS[op.regs[0]] = op.values[0];
+				regs.*REGISTER_FIELDS[op.regs[1]] = op.values[1];
+				break;
+			case FUSED_INC_CMP_JCC:
+				(regs.*REGISTER_FIELDS[op.regs[0]])++;
+				compare(regs, regs.*REGISTER_FIELDS[op.regs[1]], regs.*REGISTER_FIELDS[op.regs[2]]);
+				if (jumpTaken(op.jump, regs.flags)) {
+					regs.rip = (regs.rip - sizeof(Instruction)) + (int)op.values[0];
+				}
+				break;
+			case FUSED_OTHER:
+				executeRegisterOp(regs, op.instruction);
+				break;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <cstdint>
+
+#include "decls.h"
+
+// Superinstructions: the CPU translates each straight run of register-only instructions (NOP, WORK, LOAD, MOVE, INC, CMP, ADD, SUB,
+// optionally ending in a conditional jump) into a block of fused operations the first time it reaches it, and runs the whole block at
+// once when it does again, instead of fetching and dispatching one instruction per tick
+// The simulation still charges one tick per original instruction: the CPU waits out the rest of the block's ticks afterwards, and
+// if the process is switched out part way through, its registers are rebuilt as they would be after the instructions it was charged for
+// (see CPU::regstate)
+
+// The most instructions a block covers
+#define FUSED_BLOCK_MAX 16
+// The number of blocks each core keeps translated (direct-mapped by address)
+#define FUSED_BLOCK_CACHE_SIZE 256
+
+// The kinds of fused operation
+// FUSED_SKIP = a run of NOPs/WORKs (nothing to do)
+// FUSED_LOAD = LOAD (and FUSED_LOAD_LOAD, two of them)
+// FUSED_INC_CMP_JCC = the step of a counted loop: INC, CMP, then a conditional jump
+// FUSED_OTHER = any other single instruction
+enum FusedKind { FUSED_SKIP, FUSED_LOAD, FUSED_LOAD_LOAD, FUSED_INC_CMP_JCC, FUSED_OTHER };
+
+struct FusedOp {
+	FusedKind kind;
+	uint8_t regs[3];		  // Registers (LOAD: destination; LOAD_LOAD: both destinations; INC_CMP_JCC: incremented, compared a/b)
+	Opcode jump;			  // The jump of an INC_CMP_JCC
+	uint values[2];			  // The loaded values, or the jump offset
+	Instruction instruction;  // For FUSED_OTHER
+};
+
+// A translated run of instructions
+struct FusedBlock {
+	uint64_t address;  // Of the first instruction (0 = nothing translated in this slot)
+	uint8_t length;	   // The number of instructions the block covers (fewer than 2 = not worth fusing, so they're interpreted)
+	uint8_t numOps;
+	FusedOp ops[FUSED_BLOCK_MAX];
+};
+
+// Whether a conditional jump is taken with the given flags
+bool jumpTaken(Opcode opcode, uint flags);
+
+// Executes one register-only instruction (LOAD, MOVE, INC, CMP, ADD, SUB or a conditional jump; anything else does nothing), the way the
+// CPU does: the instruction pointer must already point past it
+void executeRegisterOp(Registers& regs, const Instruction& instruction);
+
+// Translates the run of fusable instructions starting at the given one, up to (not including) the end of its program
+void translateBlock(const Instruction* start, const Instruction* end, FusedBlock& block);
+
+// Runs a whole block on the registers (whose instruction pointer must be at its start), leaving them as they'd be after its last instruction
+void runBlock(const FusedBlock& block, Registers& regs);
+
+#endif
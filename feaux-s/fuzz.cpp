@@ -0,0 +1,1251 @@
+#include "fuzz.h"
+
+#if FEAUX_S_BENCHMARKING
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "assembler.h"
+#include "browser-api.h"
+#include "lottery.h"
+#include "machine.h"
+#include "memory.h"
+#include "os.h"
+#include "process.h"
+#include "sync.h"
+#include "utils.h"
+
+using namespace std;
+
+static const SchedulingStrategy STRATEGIES[] = {
+	SchedulingStrategy::FIFO,	SchedulingStrategy::SJF,	 SchedulingStrategy::SRT,	 SchedulingStrategy::MLF,
+	SchedulingStrategy::RT_FIFO, SchedulingStrategy::RT_EDF,	 SchedulingStrategy::RT_LST, SchedulingStrategy::CFS,
+	SchedulingStrategy::LOTTERY, SchedulingStrategy::STRIDE, SchedulingStrategy::SJF_PREDICTED, SchedulingStrategy::SRT_PREDICTED,
+	SchedulingStrategy::RT_PEDF};
+static const char* const STRATEGY_NAMES[] = {"FIFO", "SJF", "SRT", "MLF", "RT_FIFO", "RT_EDF", "RT_LST", "CFS", "LOTTERY", "STRIDE", "SJF_PREDICTED",
+											 "SRT_PREDICTED", "RT_PEDF"};
+static const char* const REGISTER_NAMES[] = {"rax", "rcx", "rdx", "rbx", "rsi", "rdi", "rsp", "rbp",
+											 "r8",	"r9",  "r10", "r11", "r12", "r13", "r14", "r15"};
+
+// The mutexes the programs lock (1 up to this), the semaphores they wait on and post in pairs (likewise, each given a unit or two before
+// any process runs), and the first of the two they only initialize and post (which no process ever waits on)
+#define FUZZ_MUTEXES 2
+#define FUZZ_SEMAPHORES 2
+#define FUZZ_PRIVATE_SEMAPHORE 16
+
+// The reference interpreter: one instruction at a time, straight from the definition of the ISA, with none of the CPU's shortcuts
+
+static void setFlags(Registers& regs, bool carry, bool zero) {
+	regs.flags &= ~(uint)(FLAG_CY | FLAG_ZF);
+	if (carry) {
+		regs.flags |= FLAG_CY;
+	}
+	if (zero) {
+		regs.flags |= FLAG_ZF;
+	}
+}
+
+// A process as the reference interpreter has run it (with the state the ISA gives a process besides its registers: the pages it has
+// allocated, its asynchronous I/O handles and the mutexes it holds), and as the reference scheduler sees it (see checkDispatches)
+struct ReferenceProcess {
+	Registers regs;
+	long executed;				  // The instructions it has run
+	Syscall lastSyscall;		  // The syscall the last of them made
+	vector<bool> pages;			  // Each page it has allocated (pages aren't reused), and whether it still is
+	map<uint, uint> allocations;  // The first page of each allocation -> its number of pages
+	uint nextIOHandle;
+	vector<uint> mutexes;  // The mutexes it holds
+	uint level;			   // Its MLF level (with every boost applied to every process as it comes, rather than when the kernel next looks)
+	long timeOnLevel;	   // The ticks it has run on that level
+	long readySince;	   // When it last went on the ready list (see rankOf)
+	Opcode blockedOn;	   // The instruction it last blocked on
+};
+
+static ReferenceProcess newReferenceProcess(const PCB* proc, uint time) {
+	ReferenceProcess ref;
+
+	ref.regs = proc->regstate;
+	ref.executed = 0;
+	ref.lastSyscall = Syscall::SYS_NONE;
+	ref.nextIOHandle = 1;
+	ref.level = 0;
+	ref.timeOnLevel = 0;
+	ref.readySince = 2 * (long)time;
+	ref.blockedOn = Opcode::NOP;
+	return ref;
+}
+
+// Runs the instruction at the instruction pointer, setting the syscall it makes (SYS_NONE if it doesn't, SYS_FAULT if it stores outside
+// the pages the process has allocated)
+// AIOPOLL and SEMINIT give what they do in the programs the fuzzer generates, which only poll handles they've waited on and only initialize
+// semaphores no process waits on
+// Returns false if the reference doesn't model the instruction (an operand that names no register)
+static bool referenceStep(ReferenceProcess& ref, uint maxVirtualPages) {
+	Registers& regs = ref.regs;
+	uint64_t address = regs.rip;
+	const Instruction instruction = *(const Instruction*)(uintptr_t)address;
+	uint* a = instruction.operand1 <= R15 ? getRegister(regs, (Regs)instruction.operand1) : nullptr;
+	uint* b = instruction.operand2 <= R15 ? getRegister(regs, (Regs)instruction.operand2) : nullptr;
+	bool carry = regs.flags & FLAG_CY, zero = regs.flags & FLAG_ZF, jump = false;
+
+	regs.rip += sizeof(Instruction);
+	ref.lastSyscall = Syscall::SYS_NONE;
+
+	switch (instruction.opcode) {
+		case Opcode::NOP:
+		case Opcode::WORK:
+			return true;
+		case Opcode::IO:
+			regs.rdi = instruction.operand1;
+			regs.rsi = instruction.operand2;
+			ref.lastSyscall = Syscall::SYS_IO;
+			return true;
+		case Opcode::EXIT:
+			ref.lastSyscall = Syscall::SYS_EXIT;
+			return true;
+		case Opcode::LOAD:
+			if (b == nullptr) return false;
+			*b = instruction.operand1;
+			return true;
+		case Opcode::MOVE:
+			if (a == nullptr || b == nullptr) return false;
+			*b = *a;
+			return true;
+		case Opcode::INC:  // (leaves the flags alone)
+			if (a == nullptr) return false;
+			*a += 1;
+			return true;
+		case Opcode::CMP:  // CY = the first is at most the second, ZF = they're equal
+			if (a == nullptr || b == nullptr) return false;
+			setFlags(regs, *a <= *b, *a == *b);
+			return true;
+		case Opcode::ADD: {	 // CY = the sum carried out of 32 bits, ZF = it carried and came to exactly 0
+			if (a == nullptr || b == nullptr) return false;
+			uint64_t sum = (uint64_t)*b + *a;
+			bool carried = sum > numeric_limits<uint>::max();
+
+			*b = (uint)sum;
+			setFlags(regs, carried, carried && *b == 0);
+			return true;
+		}
+		case Opcode::SUB:  // The flags are set as CMP sets them (CY = nothing was borrowed), then the destination is subtracted from
+			if (a == nullptr || b == nullptr) return false;
+			setFlags(regs, *a <= *b, *a == *b);
+			*b -= *a;
+			return true;
+		case Opcode::ALLOC: {  // %rdi bytes in whole pages, after the last ones allocated, into the register numbered %rsi (and the size in %rax,
+							   // or 0 in both if there's no room or nothing was asked for)
+			uint* dest = regs.rsi <= R15 ? getRegister(regs, (Regs)regs.rsi) : nullptr;
+			uint size = regs.rdi, numPages = size / PAGE_SIZE + (size % PAGE_SIZE != 0), at = 0;
+			if (dest == nullptr) return false;
+
+			if (numPages != 0 && numPages <= maxVirtualPages - ref.pages.size()) {
+				at = HEAP_BASE + ref.pages.size() * PAGE_SIZE;
+				ref.allocations[ref.pages.size()] = numPages;
+				ref.pages.resize(ref.pages.size() + numPages, true);
+			}
+			*dest = at;
+			regs.rax = at == 0 ? 0 : size;
+			ref.lastSyscall = Syscall::SYS_ALLOC;
+			return true;
+		}
+		case Opcode::FREE: {  // The allocation starting at the address in the register numbered %rdi (%rax = 0, or -1 if none starts there)
+			uint* from = regs.rdi <= R15 ? getRegister(regs, (Regs)regs.rdi) : nullptr;
+			if (from == nullptr) return false;
+			auto allocation = *from >= HEAP_BASE && (*from - HEAP_BASE) % PAGE_SIZE == 0 ? ref.allocations.find((*from - HEAP_BASE) / PAGE_SIZE)
+																						  : ref.allocations.end();
+
+			regs.rax = -1;
+			if (allocation != ref.allocations.end()) {
+				fill(ref.pages.begin() + allocation->first, ref.pages.begin() + allocation->first + allocation->second, false);
+				ref.allocations.erase(allocation);
+				regs.rax = 0;
+			}
+			ref.lastSyscall = Syscall::SYS_FREE;
+			return true;
+		}
+		case Opcode::SW: {	// (the byte stored can't be read back into a register, so only whether the address is allocated matters)
+			if (a == nullptr || b == nullptr) return false;
+			uint page = (*b - HEAP_BASE) / PAGE_SIZE;
+
+			if (*b < HEAP_BASE || page >= ref.pages.size() || !ref.pages[page]) {
+				ref.lastSyscall = Syscall::SYS_FAULT;
+			}
+			return true;
+		}
+		case Opcode::AIO:  // Requests (one for AIO) under the next handle, which goes in %rax
+		case Opcode::AIOBATCH:
+			regs.rdi = instruction.operand1;
+			regs.rsi = instruction.opcode == Opcode::AIO ? 1 : instruction.operand2;
+			regs.rax = ref.nextIOHandle++;
+			ref.lastSyscall = Syscall::SYS_AIO_SUBMIT;
+			return true;
+		case Opcode::AIOPOLL:  // (1 = the handle's requests have all completed)
+		case Opcode::AIOWAIT:
+			if (a == nullptr) return false;
+			regs.rdi = *a;
+			regs.rax = instruction.opcode == Opcode::AIOPOLL;
+			ref.lastSyscall = instruction.opcode == Opcode::AIOPOLL ? Syscall::SYS_AIO_POLL : Syscall::SYS_AIO_WAIT;
+			return true;
+		case Opcode::LOCK:	// (%rax = -1 if the process already holds the mutex)
+		case Opcode::UNLOCK: {	// (%rax = -1 if it doesn't)
+			auto held = find(ref.mutexes.begin(), ref.mutexes.end(), instruction.operand1);
+			bool lock = instruction.opcode == Opcode::LOCK;
+
+			regs.rdi = instruction.operand1;
+			regs.rax = lock == (held == ref.mutexes.end()) ? 0 : -1;
+			if (lock && held == ref.mutexes.end()) {
+				ref.mutexes.push_back(instruction.operand1);
+			} else if (!lock && held != ref.mutexes.end()) {
+				ref.mutexes.erase(held);
+			}
+			ref.lastSyscall = lock ? Syscall::SYS_LOCK : Syscall::SYS_UNLOCK;
+			return true;
+		}
+		case Opcode::SEMWAIT:
+		case Opcode::SEMPOST:
+			regs.rdi = instruction.operand1;
+			regs.rax = 0;
+			ref.lastSyscall = instruction.opcode == Opcode::SEMWAIT ? Syscall::SYS_SEM_WAIT : Syscall::SYS_SEM_POST;
+			return true;
+		case Opcode::SEMINIT:
+			regs.rdi = instruction.operand1;
+			regs.rsi = instruction.operand2;
+			regs.rax = 0;
+			ref.lastSyscall = Syscall::SYS_SEM_INIT;
+			return true;
+		case Opcode::JL:
+			jump = carry && !zero;
+			break;
+		case Opcode::JLE:
+			jump = carry;
+			break;
+		case Opcode::JE:
+			jump = zero;
+			break;
+		case Opcode::JGE:
+			jump = !carry;
+			break;
+		case Opcode::JG:
+			jump = !carry && !zero;
+			break;
+		default:
+			return false;
+	}
+
+	if (jump) {	 // (the offset is from the jump itself)
+		regs.rip = address + (int)instruction.operand1;
+	}
+	return true;
+}
+
+// The random cases (drawn from the raw output of an mt19937, like sampleUniform)
+
+static uint below(mt19937& rng, uint n) { return rng() % n; }
+
+static uint randomValue(mt19937& rng) {
+	static const uint EDGES[] = {0, 1, 2, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFE, 0xFFFFFFFF};
+
+	switch (below(rng, 4)) {
+		case 0:
+		case 1:
+			return EDGES[below(rng, sizeof(EDGES) / sizeof(uint))];
+		case 2:
+			return below(rng, 16);
+		default:
+			return rng();
+	}
+}
+
+// A run of instructions no branch from outside it may land in: from first to last, and tail more after that (a loop's body up to the INC
+// of its tail, then the CMP and JL; or a sequence that only works as a whole, past its first instruction)
+struct Region {
+	uint first;
+	uint last;
+	uint tail;
+};
+
+// Appends a random instruction that only works on registers, and doesn't write either of the reserved registers (the counter and limit of
+// the loop it's in)
+static void generateRegisterOp(mt19937& rng, uint numRegs, uint reserved1, uint reserved2, vector<Instruction>& code) {
+	uint dest, src = below(rng, numRegs);
+
+	do {
+		dest = below(rng, numRegs);
+	} while (dest == reserved1 || dest == reserved2);
+
+	switch (below(rng, 12)) {
+		case 0:
+			code.push_back({Opcode::NOP, 0, 0});
+			break;
+		case 1:
+			code.push_back({Opcode::WORK, 0, 0});
+			break;
+		case 2:
+		case 3:
+			code.push_back({Opcode::LOAD, randomValue(rng), dest});
+			break;
+		case 4:
+			code.push_back({Opcode::MOVE, src, dest});
+			break;
+		case 5:
+			code.push_back({Opcode::INC, dest, 0});
+			break;
+		case 6:
+		case 7:
+			code.push_back({Opcode::ADD, src, dest});
+			break;
+		case 8:
+		case 9:
+			code.push_back({Opcode::SUB, src, dest});
+			break;
+		default:
+			code.push_back({Opcode::CMP, src, below(rng, numRegs)});
+			break;
+	}
+}
+
+// Appends a random instruction, or a short sequence that only works as a whole (with its region), that doesn't write either of the
+// reserved registers:
+// - an ALLOC and a store to what it got, a FREE, or a store to wherever a register points (which usually faults)
+// - an AIO/AIOBATCH, then an AIOWAIT and an AIOPOLL on the handle it got
+// - a LOCK and UNLOCK, or a SEMWAIT and SEMPOST on one of the shared semaphores, around register-only instructions (so no process blocks or
+//   dies holding a mutex or a unit, and the programs can't deadlock); or a SEMINIT and SEMPOST on a semaphore of its own
+// Conditional jumps are appended with no target yet (see generateProgram)
+static void generateInstruction(mt19937& rng, uint numRegs, uint reserved1, uint reserved2, vector<Instruction>& code, vector<uint>& jumps,
+								vector<Region>& regions) {
+	uint dest, first = code.size() + 1;	 // (a sequence may be entered at its first instruction)
+
+	do {
+		dest = below(rng, numRegs);
+	} while (dest == reserved1 || dest == reserved2);
+
+	switch (below(rng, 20)) {
+		case 12:
+		case 13:
+		case 14:
+			jumps.push_back(code.size());
+			code.push_back({(Opcode)(Opcode::JL + below(rng, 5)), 0, 0});
+			return;
+		case 15:
+			code.push_back({Opcode::IO, 1 + below(rng, 8), NO_BLOCK});
+			return;
+		case 16: {
+			uint choice = below(rng, 8);
+
+			if (choice == 0) {
+				code.push_back({Opcode::SW, below(rng, numRegs), below(rng, numRegs)});
+				return;
+			} else if (choice < 3) {  // (%rdi = the number of a register that may hold an address)
+				code.push_back({Opcode::LOAD, below(rng, numRegs), RDI});
+				code.push_back({Opcode::FREE, 0, 0});
+			} else {  // (not into %rax, which gets the size; and sometimes of nothing, which fails)
+				uint into, size = below(rng, 16) == 0 ? 0 : 1 + below(rng, 3 * PAGE_SIZE);
+				do {
+					into = below(rng, numRegs);
+				} while (into == reserved1 || into == reserved2 || into == RAX);
+
+				code.push_back({Opcode::LOAD, size, RDI});
+				code.push_back({Opcode::LOAD, into, RSI});
+				code.push_back({Opcode::ALLOC, 0, 0});
+				code.push_back({Opcode::SW, below(rng, numRegs), into});
+			}
+			break;
+		}
+		case 17:
+			if (below(rng, 2) == 0) {
+				code.push_back({Opcode::AIO, 1 + below(rng, 8), 0});
+			} else {
+				code.push_back({Opcode::AIOBATCH, 1 + below(rng, 8), below(rng, 4)});
+			}
+			code.push_back({Opcode::MOVE, RAX, dest});
+			code.push_back({Opcode::AIOWAIT, dest, 0});
+			code.push_back({Opcode::AIOPOLL, dest, 0});
+			break;
+		case 18:
+		case 19: {
+			bool mutex = below(rng, 2) == 0;
+			uint id = 1 + below(rng, mutex ? FUZZ_MUTEXES : FUZZ_SEMAPHORES), body = 1 + below(rng, 3);
+
+			if (!mutex && below(rng, 4) == 0) {	 // (on a semaphore of its own, so the count it sets is never waited on)
+				id = FUZZ_PRIVATE_SEMAPHORE + below(rng, 2);
+				code.push_back({Opcode::SEMINIT, id, below(rng, 4)});
+				code.push_back({Opcode::SEMPOST, id, 0});
+				break;
+			}
+
+			code.push_back({mutex ? Opcode::LOCK : Opcode::SEMWAIT, id, 0});
+			for (uint i = 0; i < body; i++) {
+				generateRegisterOp(rng, numRegs, reserved1, reserved2, code);
+			}
+			if (mutex && below(rng, 4) == 0) {	// (already held, so it fails rather than blocks)
+				code.push_back({Opcode::LOCK, id, 0});
+			}
+			code.push_back({mutex ? Opcode::UNLOCK : Opcode::SEMPOST, id, 0});
+			break;
+		}
+		default:
+			generateRegisterOp(rng, numRegs, reserved1, reserved2, code);
+			return;
+	}
+
+	regions.push_back({first, (uint)code.size() - 1, 0});
+}
+
+// A random program: arithmetic on a few registers, forward branches on its flags, counted loops (INC, CMP, JL back to the top, the
+// pattern the CPU fuses), blocking and asynchronous I/O, memory, mutexes and semaphores, ending in an EXIT
+// Branches only go forward, and never into or out of a loop (or into a sequence), so every program finishes
+static vector<Instruction> generateProgram(mt19937& rng) {
+	vector<Instruction> code;
+	vector<uint> jumps;
+	vector<Region> regions;
+	uint length = 4 + below(rng, 48), numRegs = 4 + below(rng, 13);
+
+	while (code.size() < length) {
+		if (below(rng, 8) != 0) {
+			generateInstruction(rng, numRegs, numRegs, numRegs, code, jumps, regions);
+			continue;
+		}
+
+		// (not %rax, %rsi or %rdi, which syscalls overwrite)
+		uint counter, limit;
+		do {
+			counter = below(rng, 16);
+			limit = below(rng, 16);
+		} while (limit == counter || counter == RAX || counter == RSI || counter == RDI || limit == RAX || limit == RSI || limit == RDI);
+
+		code.push_back({Opcode::LOAD, 0, counter});
+		code.push_back({Opcode::LOAD, 1 + below(rng, 6), limit});
+
+		uint start = code.size(), body = 1 + below(rng, 8);
+		for (uint i = 0; i < body; i++) {
+			generateInstruction(rng, numRegs, counter, limit, code, jumps, regions);
+		}
+
+		regions.push_back({start, (uint)code.size(), 2});
+		code.push_back({Opcode::INC, counter, 0});
+		code.push_back({Opcode::CMP, counter, limit});
+		code.push_back({Opcode::JL, (uint)(((int)start - (int)code.size()) * (int)sizeof(Instruction)), 0});
+	}
+	code.push_back({Opcode::EXIT, 0, 0});
+
+	// Point each branch a little way forward: within its loop (at most to the INC, so the loop still counts), or anywhere outside loops,
+	// but never into the middle of another region
+	vector<uint> targets;
+	for (uint at : jumps) {
+		const Region* within = nullptr;
+		for (const Region& region : regions) {
+			if (at >= region.first && at < region.last) {
+				within = &region;
+			}
+		}
+
+		targets.clear();
+		for (uint target = at + 1; target < code.size() && target <= at + 12; target++) {
+			bool allowed = within != nullptr ? target <= within->last : true;
+
+			for (const Region& region : regions) {
+				if (&region != within && target >= region.first && target <= region.last + region.tail) {
+					allowed = false;
+				}
+			}
+			if (allowed) {
+				targets.push_back(target);
+			}
+		}
+
+		uint target = !targets.empty() ? targets[below(rng, targets.size())] : within != nullptr ? within->last : code.size() - 1;
+		code[at].operand1 = (target - at) * sizeof(Instruction);
+	}
+
+	return code;
+}
+
+struct FuzzArrival {
+	uint time;
+	uint program;
+	uint deadline;	// Relative (-1 = none)
+	int nice;
+	uint tickets;  // 0 = the program's
+	uint64_t affinity;
+};
+
+struct FuzzJob {
+	uint program;
+	uint period;
+	uint deadline;	// Relative
+	uint delay;
+};
+
+// A fuzzing case: the machine, strategy, programs and arrivals, all drawn from its seed
+struct FuzzCase {
+	uint8_t numCores;
+	uint8_t numIODevices;
+	uint strategy;	// Index into STRATEGIES
+	ContextSwitchConfig switchCost;
+	vector<vector<Instruction>> programs;
+	vector<string> names;
+	vector<FuzzArrival> arrivals;  // In order of time
+	uint reconfigureAfter;		   // The number of programs loaded before the machine is reconfigured (all of them = it isn't)
+	uint reconfiguration;		   // How: 0 = setNumCores, 1 = setNumIODevices, 2 = setSchedulingStrategy (each to what it already is)
+	MemoryConfig memory;		   // (with no stalls, so that every tick a process is charged for runs an instruction)
+	MLFConfig mlf;
+	uint semaphoreUnits[FUZZ_SEMAPHORES];
+	vector<FuzzJob> jobs;  // Released until FUZZ_JOB_TICKS (under the real-time strategies)
+	PartitionHeuristic partitionHeuristic;
+};
+
+static FuzzCase generateCase(uint seed) {
+	mt19937 rng(seed);
+	FuzzCase fuzzCase;
+
+	fuzzCase.numCores = 1 + below(rng, 4);
+	fuzzCase.numIODevices = 1 + below(rng, 2);
+	fuzzCase.strategy = below(rng, sizeof(STRATEGIES) / sizeof(SchedulingStrategy));
+	fuzzCase.switchCost = below(rng, 2) == 0 ? ContextSwitchConfig{0, 0, 0} : ContextSwitchConfig{below(rng, 3), below(rng, 2), below(rng, 4)};
+
+	uint numPrograms = 1 + below(rng, 6);
+	for (uint i = 0; i < numPrograms; i++) {
+		fuzzCase.programs.push_back(generateProgram(rng));
+		fuzzCase.names.push_back("fuzz " + to_string(i));
+	}
+
+	uint numArrivals = 1 + below(rng, 24);
+	for (uint i = 0; i < numArrivals; i++) {
+		FuzzArrival arrival;
+
+		arrival.time = 1 + below(rng, 100);
+		arrival.program = below(rng, numPrograms);
+		arrival.deadline = below(rng, 2) == 0 ? (uint)-1 : 20 + below(rng, 400);
+		arrival.nice = (int)below(rng, 40) - 20;
+		arrival.tickets = below(rng, 2) == 0 ? 0 : 1 + below(rng, 400);
+		arrival.affinity = below(rng, 4) != 0 ? AFFINITY_ALL : 1 + below(rng, (1 << fuzzCase.numCores) - 1);  // (some of the cores)
+		fuzzCase.arrivals.push_back(arrival);
+	}
+	stable_sort(fuzzCase.arrivals.begin(), fuzzCase.arrivals.end(), [](const FuzzArrival& a, const FuzzArrival& b) { return a.time < b.time; });
+
+	fuzzCase.reconfigureAfter = below(rng, 2) == 0 ? numPrograms : below(rng, numPrograms);
+	fuzzCase.reconfiguration = below(rng, 3);
+
+	fuzzCase.memory = MemoryConfig{1 + below(rng, 16), 0, 0, 0, 4 + below(rng, 61)};
+	fuzzCase.mlf = defaultMLFConfig();
+	fuzzCase.mlf.numLevels = 1 + below(rng, NUM_LEVELS);
+	for (uint level = 0; level < fuzzCase.mlf.numLevels; level++) {
+		fuzzCase.mlf.quanta[level] = 1 + below(rng, 8);
+	}
+	fuzzCase.mlf.boostPeriod = below(rng, 2) == 0 ? 0 : 8 + below(rng, 57);
+	fuzzCase.mlf.ioPromotion = below(rng, 2) == 0;
+	for (uint& units : fuzzCase.semaphoreUnits) units = 1 + below(rng, 2);
+
+	SchedulingStrategy strategy = STRATEGIES[fuzzCase.strategy];
+	uint numJobs = strategy == SchedulingStrategy::RT_FIFO || strategy == SchedulingStrategy::RT_EDF || strategy == SchedulingStrategy::RT_LST ||
+						   strategy == SchedulingStrategy::RT_PEDF
+					   ? below(rng, 5)
+					   : 0;
+	for (uint i = 0; i < numJobs; i++) {
+		FuzzJob job;
+
+		job.program = below(rng, numPrograms);
+		job.period = 20 + below(rng, 81);
+		job.deadline = 5 + below(rng, job.period);
+		job.delay = below(rng, 50);
+		fuzzCase.jobs.push_back(job);
+	}
+	fuzzCase.partitionHeuristic = below(rng, 2) == 0 ? PartitionHeuristic::FIRST_FIT_DECREASING : PartitionHeuristic::WORST_FIT_DECREASING;
+
+	return fuzzCase;
+}
+
+// A simulation of its own (the kernel works on the globals, so the one being ticked is swapped into them)
+struct Simulation {
+	MachineState* machine;
+	OSState* state;
+	uint nextPID;
+};
+
+static void enter(const Simulation& sim) {
+	machine = sim.machine;
+	state = sim.state;
+	nextPID = sim.nextPID;
+}
+
+static void leave(Simulation& sim) {
+	sim.machine = machine;
+	sim.state = state;
+	sim.nextPID = nextPID;
+	machine = nullptr;
+	state = nullptr;
+}
+
+static Simulation startSimulation(FuzzCase& fuzzCase, bool fused) {
+	Simulation sim;
+
+	initMachine(fuzzCase.numCores, fuzzCase.numIODevices);
+	initOS(machine->numCores, STRATEGIES[fuzzCase.strategy]);
+
+	setContextSwitchCost(fuzzCase.switchCost.fixedTicks, fuzzCase.switchCost.registerTicks, fuzzCase.switchCost.cacheWarmupTicks);
+	for (uint i = 0; i < fuzzCase.programs.size(); i++) {
+		if (i == fuzzCase.reconfigureAfter) {  // (the programs loaded so far are carried over)
+			if (fuzzCase.reconfiguration == 0) {
+				setNumCores(fuzzCase.numCores);
+			} else if (fuzzCase.reconfiguration == 1) {
+				setNumIODevices(fuzzCase.numIODevices);
+			} else {
+				setSchedulingStrategy(STRATEGIES[fuzzCase.strategy]);
+			}
+		}
+		loadProgram(fuzzCase.programs[i].data(), fuzzCase.programs[i].size(), fuzzCase.names[i].c_str());
+	}
+
+	for (uint i = 0; i < machine->numCores; i++) {
+		machine->cores[i]->setFusion(fused);
+	}
+
+	// (after the reconfiguration, which would drop the jobs)
+	configureMemory(fuzzCase.memory);
+	setMLFLevels(fuzzCase.mlf.numLevels);
+	for (uint level = 0; level < fuzzCase.mlf.numLevels; level++) {
+		setMLFQuantum(level, fuzzCase.mlf.quanta[level]);
+	}
+	setMLFBoost(fuzzCase.mlf.boostPeriod, fuzzCase.mlf.ioPromotion);
+	for (uint i = 0; i < FUZZ_SEMAPHORES; i++) {
+		initSemaphore(1 + i, fuzzCase.semaphoreUnits[i]);
+	}
+	setPartitionHeuristic(fuzzCase.partitionHeuristic);
+	for (const FuzzJob& job : fuzzCase.jobs) {
+		dispatch(fuzzCase.names[job.program].c_str(), job.period, job.deadline, job.delay);
+	}
+
+	leave(sim);
+	return sim;
+}
+
+static void endSimulation(Simulation& sim) {
+	enter(sim);
+	cleanupOS();
+	cleanupMachine();
+	machine = nullptr;
+	state = nullptr;
+}
+
+// The registers a process has right now (on the core running it, if it's running)
+static Registers registersOf(const Simulation& sim, const PCB* proc) {
+	if (proc->state() == processing) {
+		for (uint core = 0; core < sim.machine->numCores; core++) {
+			if (sim.state->runningProcess[core] == proc) {
+				return sim.machine->cores[core]->regstate();
+			}
+		}
+	}
+
+	return proc->regstate;
+}
+
+static uint64_t programBase(const Simulation& sim, const PCB* proc) {
+	return (uint64_t)(uintptr_t)sim.state->programs.at(proc->name).instructions.get();
+}
+
+// Describes how two sets of registers differ (empty if they don't), with the instruction pointers as indices into their programs
+static string diffRegisters(Registers expected, uint64_t expectedBase, Registers actual, uint64_t actualBase) {
+	long long expectedAt = (long long)(expected.rip - expectedBase) / (long long)sizeof(Instruction);
+	long long actualAt = (long long)(actual.rip - actualBase) / (long long)sizeof(Instruction);
+
+	// The common case (checked every tick for every process), without building the description
+	bool same = expectedAt == actualAt && expected.flags == actual.flags;
+	for (uint reg = 0; reg <= R15 && same; reg++) {
+		same = *getRegister(expected, (Regs)reg) == *getRegister(actual, (Regs)reg);
+	}
+	if (same) {
+		return "";
+	}
+
+	ostringstream diff;
+	if (expectedAt != actualAt) {
+		diff << " rip " << expectedAt << "/" << actualAt;
+	}
+	if (expected.flags != actual.flags) {
+		diff << " flags " << expected.flags << "/" << actual.flags;
+	}
+	for (uint reg = 0; reg <= R15; reg++) {
+		uint expectedValue = *getRegister(expected, (Regs)reg), actualValue = *getRegister(actual, (Regs)reg);
+
+		if (expectedValue != actualValue) {
+			diff << " " << REGISTER_NAMES[reg] << " " << expectedValue << "/" << actualValue;
+		}
+	}
+
+	return diff.str();
+}
+
+// Checks that no two programs' code shares an address (programs loaded after a reconfiguration must go after those carried over)
+static bool checkCodeLayout(const Simulation& sim, ostringstream& failure) {
+	vector<const Program*> programs;
+	for (const auto& entry : sim.state->programs) programs.push_back(&entry.second);
+	sort(programs.begin(), programs.end(), [](const Program* a, const Program* b) { return a->codeAddress < b->codeAddress; });
+
+	for (size_t i = 1; i < programs.size(); i++) {
+		if (programs[i - 1]->codeAddress + programs[i - 1]->length * sizeof(Instruction) > programs[i]->codeAddress) {
+			failure << "programs " << programs[i - 1]->name << " and " << programs[i]->name << " share code addresses";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Checks each real-time job is bound to the core partitionJobs should have picked, worked out again the slow way: the jobs taken one at a
+// time by decreasing utilization (the first listed of any that tie), each onto the first core it fits on (for first fit) or else the least
+// loaded one (the first of any that tie)
+static bool checkPartitions(const Simulation& sim, ostringstream& failure) {
+	vector<const RTJob*> jobs(sim.state->jobList.begin(), sim.state->jobList.end());
+	vector<double> load(sim.machine->numCores, 0);
+	auto utilization = [&sim](const RTJob* job) { return (sim.state->programs.at(job->program).cost + 2) / (double)job->period; };
+
+	while (!jobs.empty()) {
+		size_t next = 0;
+		for (size_t i = 1; i < jobs.size(); i++) {
+			if (utilization(jobs[i]) > utilization(jobs[next])) {
+				next = i;
+			}
+		}
+
+		const RTJob* job = jobs[next];
+		int core = -1;
+		for (uint i = 0; i < load.size() && sim.state->partitionHeuristic == PartitionHeuristic::FIRST_FIT_DECREASING; i++) {
+			if (core == -1 && load[i] + utilization(job) <= 1) {
+				core = i;
+			}
+		}
+		if (core == -1) {
+			core = min_element(load.begin(), load.end()) - load.begin();
+		}
+
+		if (job->core != core) {
+			failure << "a job of " << job->program << " (" << utilization(job) << " of a core) is bound to core " << job->core << " instead of "
+					<< core;
+			return false;
+		}
+		load[core] += utilization(job);
+		jobs.erase(jobs.begin() + next);
+	}
+
+	return true;
+}
+
+// The reference scheduler: each tick, the kernel's dispatch decisions are checked against linear scans over every process (in place of the
+// ready lists, the lazy MLF boost and pickRTPreemptions)
+
+// What the reference scheduler needs of a simulation as a tick starts (after the tick's arrivals are spawned)
+struct TickStart {
+	vector<State> states;		   // Of each process, by slot (processes in slots past these were released during the tick)
+	vector<const PCB*> running;	   // On each core
+	vector<long> processorTime;	   // Of each core's process
+	vector<unsigned long long> vruntime;
+};
+
+static void startTick(const Simulation& sim, TickStart& start) {
+	start.states.assign(sim.state->columns.state.begin(), sim.state->columns.state.end());
+	start.running.assign(sim.state->runningProcess, sim.state->runningProcess + sim.machine->numCores);
+	start.processorTime.clear();
+	start.vruntime.clear();
+	for (const PCB* proc : start.running) {
+		start.processorTime.push_back(proc != nullptr ? proc->processorTime() : 0);
+		start.vruntime.push_back(proc != nullptr ? proc->vruntime : 0);
+	}
+}
+
+// Where the strategy ranks a process (lowest first, and processes that rank the same may be taken in either order), given its processor
+// time and virtual runtime (which only change while it runs)
+typedef tuple<double, unsigned long long, long, uint> Rank;
+
+static Rank rankOf(const PCB* proc, const ReferenceProcess& ref, long processorTime, unsigned long long vruntime, SchedulingStrategy strategy) {
+	long remaining = proc->reqProcessorTime() - processorTime, noDeadline = numeric_limits<long>::max();
+
+	switch (strategy) {
+		case SchedulingStrategy::FIFO:
+		case SchedulingStrategy::RT_FIFO:  // (spawned and released processes are stamped on even times, in order; woken ones on odd, in any)
+			return Rank(0, 0, ref.readySince, ref.readySince % 2 == 0 ? proc->pid : 0);
+		case SchedulingStrategy::SJF:
+			return Rank(0, 0, proc->reqProcessorTime(), 0);
+		case SchedulingStrategy::SRT:
+			return Rank(0, 0, remaining, 0);
+		case SchedulingStrategy::SJF_PREDICTED:
+			return Rank(proc->predictedBurst, 0, 0, 0);
+		case SchedulingStrategy::SRT_PREDICTED:
+			return Rank(proc->predictedBurst - (processorTime - proc->burstStart), 0, 0, 0);
+		case SchedulingStrategy::MLF:
+			return Rank(0, 0, ref.level, 0);
+		case SchedulingStrategy::RT_EDF:
+		case SchedulingStrategy::RT_PEDF:
+			return Rank(0, 0, proc->deadline() == -1 ? noDeadline : proc->deadline(), 0);
+		case SchedulingStrategy::RT_LST:
+			return Rank(0, 0, proc->deadline() == -1 ? noDeadline : proc->deadline() - remaining, 0);
+		case SchedulingStrategy::CFS:  // (ties to the older process)
+			return Rank(0, vruntime, 0, proc->pid);
+		case SchedulingStrategy::STRIDE:
+			return Rank(0, proc->pass, 0, proc->pid);
+		default:  // LOTTERY: any of them, it's a draw
+			return Rank(0, 0, 0, 0);
+	}
+}
+
+// Whether the strategy has a ready process take the core from a running one (ranked as of the start of the tick)
+static bool preempts(const Rank& ready, const Rank& running, SchedulingStrategy strategy) {
+	switch (strategy) {
+		case SchedulingStrategy::MLF:
+		case SchedulingStrategy::RT_EDF:
+		case SchedulingStrategy::RT_LST:
+		case SchedulingStrategy::RT_PEDF:
+			return ready < running;
+		case SchedulingStrategy::CFS:  // (only once it's the wakeup granularity behind)
+			return get<1>(ready) + ((unsigned long long)CFS_WAKEUP_GRANULARITY << CFS_VRUNTIME_SHIFT) < get<1>(running);
+		default:
+			return false;
+	}
+}
+
+// Whether the core may take the process (under RT_PEDF, only the processes bound to it)
+static bool mayTake(const PCB* proc, uint core, SchedulingStrategy strategy) {
+	return proc->mayRunOn(core) && (strategy != SchedulingStrategy::RT_PEDF || proc->partition == (int)core);
+}
+
+// The number of processes on the strategy's ready lists
+static size_t readyListSize(const OSState& os) {
+	size_t size = 0;
+
+	switch (os.strategy) {
+		case SchedulingStrategy::FIFO:
+		case SchedulingStrategy::RT_FIFO:
+			return os.fifoReadyList.size();
+		case SchedulingStrategy::SJF:
+		case SchedulingStrategy::SJF_PREDICTED:
+			return os.sjfReadyList.size();
+		case SchedulingStrategy::SRT:
+		case SchedulingStrategy::SRT_PREDICTED:
+			return os.srtReadyList.size();
+		case SchedulingStrategy::MLF:
+			for (uint level = 0; level < NUM_LEVELS; level++) size += os.mlfLists[level].size();
+			return size;
+		case SchedulingStrategy::RT_EDF:
+			return os.edfReadyList.size();
+		case SchedulingStrategy::RT_LST:
+			return os.lstReadyList.size();
+		case SchedulingStrategy::RT_PEDF:
+			for (const auto& list : os.coreEDFReadyLists) size += list.size();
+			return size;
+		case SchedulingStrategy::CFS:
+			return os.cfsReadyList.size();
+		case SchedulingStrategy::LOTTERY:
+			return os.lotteryReadyList->size();
+		default:
+			return os.strideReadyList.size();
+	}
+}
+
+// Checks the tick that just ran against the reference scheduler, core by core in the order the kernel steps them:
+// - a free core takes the best ready process it may (or leaves them all, only if there are none it may or it served an interrupt or I/O
+//   request instead)
+// - a running process is only preempted under MLF, CFS, EDF, LST and PEDF, by the best ready process the core may take, and one that ranks
+//   ahead of it
+// - a running process is preempted whenever the strategy calls for it: under MLF and CFS when no core is free and a ready process the core
+//   may take ranks ahead of it, under PEDF whenever its core's best ready process does, and under global EDF/LST on exactly the cores a full
+//   scan picks (the free cores taking the best ready processes, then each of the rest displacing the worst running process left that it
+//   beats; with affinity masks in the way, on some of them)
+// - under MLF, each process is on the level it would be on with every boost applied to every process at once, and is demoted (taken off its
+//   core) exactly when it runs out its quantum
+// - the ready lists hold exactly the ready processes
+static bool checkDispatches(const Simulation& sim, const TickStart& start, map<uint, ReferenceProcess>& reference, ostringstream& failure,
+							const PCB*& culprit) {
+	const OSState& os = *sim.state;
+	const MLFConfig& mlf = os.mlfConfig;
+	SchedulingStrategy strategy = os.strategy;
+	uint numCores = sim.machine->numCores;
+	vector<const PCB*> candidates, requeued, blockedNow;
+	vector<bool> preempted(numCores, false);
+	auto rank = [&](const PCB* proc) { return rankOf(proc, reference.at(proc->pid), proc->processorTime(), proc->vruntime, strategy); };
+	auto startRank = [&](uint core) {
+		return rankOf(start.running[core], reference.at(start.running[core]->pid), start.processorTime[core], start.vruntime[core], strategy);
+	};
+
+	if (strategy == SchedulingStrategy::MLF && mlf.boostPeriod != 0 && os.time % mlf.boostPeriod == 0) {
+		for (auto& entry : reference) {
+			entry.second.level = 0;
+			entry.second.timeOnLevel = 0;
+		}
+	}
+
+	for (uint slot = 0; slot < os.columns.size(); slot++) {
+		if (slot >= start.states.size() || start.states[slot] == ready) {
+			candidates.push_back(os.columns.pcb[slot]);
+		}
+	}
+	const vector<const PCB*> startCandidates = candidates;
+
+	for (uint core = 0; core < numCores; core++) {
+		const PCB *before = start.running[core], *after = os.runningProcess[core];
+		StepAction action = os.stepAction[core];
+		bool coreFree = false;	// Whether another core was free as this one stepped (those before it have stepped, those after haven't yet)
+
+		for (uint other = 0; other < numCores; other++) {
+			coreFree = coreFree || (other != core && (other < core ? os.runningProcess[other] : start.running[other]) == nullptr);
+		}
+
+		if (after != nullptr && after != before) {
+			auto it = find(candidates.begin(), candidates.end(), after);
+
+			culprit = after;
+			if (it == candidates.end()) {
+				failure << "was dispatched on core " << core << " without being ready";
+				return false;
+			} else if (!mayTake(after, core, strategy)) {
+				failure << "was dispatched on core " << core << ", which it may not run on";
+				return false;
+			}
+			candidates.erase(it);
+
+			for (const PCB* other : candidates) {
+				if (mayTake(other, core, strategy) && rank(other) < rank(after)) {
+					failure << "was dispatched on core " << core << " ahead of pid " << other->pid;
+					return false;
+				}
+			}
+
+			if (before != nullptr) {
+				culprit = before;
+				if (!preempts(rank(after), startRank(core), strategy)) {
+					failure << "was preempted on core " << core << " by pid " << after->pid << ", which doesn't rank ahead of it";
+					return false;
+				}
+
+				preempted[core] = true;
+				requeued.push_back(before);
+				candidates.push_back(before);
+				if (strategy == SchedulingStrategy::MLF) {
+					reference.at(before->pid).timeOnLevel = 0;
+				}
+			}
+		} else if (before == nullptr) {
+			for (const PCB* other : candidates) {
+				if (action != StepAction::SERVICE_REQUEST && action != StepAction::HANDLE_INTERRUPT && mayTake(other, core, strategy)) {
+					culprit = other;
+					failure << "was left ready with core " << core << " free";
+					return false;
+				}
+			}
+		} else if (action == StepAction::CONTINUE_RUN) {
+			if ((strategy == SchedulingStrategy::MLF || strategy == SchedulingStrategy::CFS) && !coreFree) {
+				for (const PCB* other : candidates) {
+					if (mayTake(other, core, strategy) && preempts(rank(other), startRank(core), strategy)) {
+						culprit = before;
+						failure << "wasn't preempted on core " << core << " by pid " << other->pid << ", which ranks ahead of it";
+						return false;
+					}
+				}
+			}
+
+			if (strategy == SchedulingStrategy::MLF) {
+				ReferenceProcess& ref = reference.at(before->pid);
+				bool demoted = ++ref.timeOnLevel > mlf.quanta[ref.level] && ref.level < mlf.numLevels - 1;
+
+				culprit = before;
+				if (demoted != (after == nullptr)) {
+					failure << (demoted ? "wasn't" : "was") << " demoted on core " << core << " after " << ref.timeOnLevel << " ticks on MLF level "
+							<< ref.level;
+					return false;
+				} else if (demoted) {
+					ref.level++;
+					ref.timeOnLevel = 0;
+				}
+			}
+		} else if (action == StepAction::HANDLE_SYSCALL && after == nullptr && (before->state() == blocked || before->state() == ready)) {
+			blockedNow.push_back(before);  // (and maybe woken again by a later core)
+		}
+	}
+
+	if (strategy == SchedulingStrategy::RT_EDF || strategy == SchedulingStrategy::RT_LST || strategy == SchedulingStrategy::RT_PEDF) {
+		vector<bool> expected(numCores, false);
+		vector<pair<Rank, uint>> running;  // Each process that could be preempted, and its core
+		vector<Rank> ready;
+		uint freeCores = 0;
+
+		for (uint core = 0; core < numCores; core++) {
+			if (start.running[core] == nullptr) {
+				freeCores++;
+			} else if (os.stepAction[core] == StepAction::CONTINUE_RUN || preempted[core]) {
+				running.emplace_back(startRank(core), core);
+			}
+		}
+
+		if (strategy == SchedulingStrategy::RT_PEDF) {
+			for (const pair<Rank, uint>& proc : running) {
+				for (const PCB* other : startCandidates) {
+					expected[proc.second] = expected[proc.second] || (other->partition == (int)proc.second && rank(other) < proc.first);
+				}
+			}
+		} else {
+			for (const PCB* other : startCandidates) ready.push_back(rank(other));
+			sort(ready.begin(), ready.end());
+			stable_sort(running.begin(), running.end(), [](const pair<Rank, uint>& a, const pair<Rank, uint>& b) { return a.first > b.first; });
+
+			for (size_t i = 0; i < running.size() && freeCores + i < ready.size() && ready[freeCores + i] < running[i].first; i++) {
+				expected[running[i].second] = true;
+			}
+		}
+
+		for (uint core = 0; core < numCores; core++) {
+			// (with affinity masks in the way, a global scan's pick may have no process its core may take)
+			if (preempted[core] ? !expected[core] : expected[core] && (strategy == SchedulingStrategy::RT_PEDF || !os.pinning)) {
+				culprit = start.running[core];
+				failure << (preempted[core] ? "was" : "wasn't") << " preempted on core " << core << " against a full scan of the ready processes";
+				return false;
+			}
+		}
+	}
+
+	size_t numReady = 0;
+	unsigned long readyWeight = 0;
+	for (uint slot = 0; slot < os.columns.size(); slot++) {
+		const PCB* proc = os.columns.pcb[slot];
+		ReferenceProcess& ref = reference.at(proc->pid);
+		State was = slot < start.states.size() ? start.states[slot] : ready;
+		bool blockedThisTick = find(blockedNow.begin(), blockedNow.end(), proc) != blockedNow.end();
+
+		culprit = proc;
+		if (blockedThisTick) {
+			ref.blockedOn = ((const Instruction*)(uintptr_t)proc->regstate.rip)[-1].opcode;
+		}
+		// Back on the ready list through the reentry list (rather than straight back after being preempted)
+		if (proc->state() == ready && was != ready && find(requeued.begin(), requeued.end(), proc) == requeued.end()) {
+			bool woken = was == blocked || blockedThisTick;
+
+			ref.readySince = 2 * (long)os.time + 1;
+			if (woken && strategy == SchedulingStrategy::MLF && mlf.ioPromotion && ref.level > 0 &&
+				(ref.blockedOn == Opcode::IO || ref.blockedOn == Opcode::AIOWAIT)) {
+				ref.level--;
+				ref.timeOnLevel = 0;
+			}
+		}
+
+		if (proc->state() == ready) {
+			numReady++;
+			readyWeight += proc->weight;
+			if (strategy == SchedulingStrategy::RT_PEDF && (proc->partition == -1 || !proc->mayRunOn(proc->partition))) {
+				failure << "is ready, bound to core " << proc->partition << ", which it may not run on";
+				return false;
+			}
+		}
+
+		bool current = proc->mlfEpoch == os.mlfEpoch;
+		if (strategy == SchedulingStrategy::MLF && proc->state() != done && proc->state() != dead &&
+			((current ? proc->level() : 0) != ref.level || (current ? proc->processorTimeOnLevel : 0) != ref.timeOnLevel)) {
+			failure << "is on MLF level " << (current ? proc->level() : 0) << " after " << (current ? proc->processorTimeOnLevel : 0)
+					<< " ticks, but boosting every process at once puts it on level " << ref.level << " after " << ref.timeOnLevel;
+			return false;
+		}
+	}
+
+	culprit = nullptr;
+	if (readyListSize(os) != numReady) {
+		failure << "the ready lists hold " << readyListSize(os) << " processes, but " << numReady << " are ready";
+		return false;
+	} else if (strategy == SchedulingStrategy::CFS && os.cfsReadyWeight != readyWeight) {
+		failure << "cfsReadyWeight is " << os.cfsReadyWeight << ", but the ready processes weigh " << readyWeight;
+		return false;
+	}
+
+	return true;
+}
+
+#define COMPARE(what, expected, actual)                                                               \
+	if ((expected) != (actual)) {                                                                     \
+		failure << what << " differs without superinstructions: " << (expected) << "/" << (actual); \
+		return false;                                                                                 \
+	}
+
+// Checks the two runs against each other and the reference, describing the first difference found (and the process it's in)
+static bool check(const Simulation& fast, const Simulation& slow, map<uint, ReferenceProcess>& reference, ostringstream& failure,
+				  const PCB*& culprit) {
+	COMPARE("time", fast.state->time, slow.state->time);
+	COMPARE("the number of processes", fast.state->processList.size(), slow.state->processList.size());
+	COMPARE("finishedProcesses", fast.state->finishedProcesses, slow.state->finishedProcesses);
+	COMPARE("contextSwitches", fast.state->contextSwitches, slow.state->contextSwitches);
+	COMPARE("preemptions", fast.state->preemptions, slow.state->preemptions);
+	COMPARE("switchTicks", fast.state->switchTicks, slow.state->switchTicks);
+
+	for (uint core = 0; core < fast.machine->numCores; core++) {
+		const PCB *fastProc = fast.state->runningProcess[core], *slowProc = slow.state->runningProcess[core];
+		COMPARE("the process on core " + to_string(core), fastProc != nullptr ? (int)fastProc->pid : -1, slowProc != nullptr ? (int)slowProc->pid : -1);
+	}
+
+	for (auto fastIt = fast.state->processList.begin(), slowIt = slow.state->processList.begin(); fastIt != fast.state->processList.end();
+		 fastIt++, slowIt++) {
+		const PCB *proc = *fastIt, *other = *slowIt;
+		ReferenceProcess& ref = reference.at(proc->pid);
+
+		culprit = proc;
+		COMPARE("pid", proc->pid, other->pid);
+		COMPARE("state", proc->state(), other->state());
+		COMPARE("doneTime", proc->doneTime(), other->doneTime());
+		COMPARE("processorTime", proc->processorTime(), other->processorTime());
+		COMPARE("level", proc->level(), other->level());
+		COMPARE("processorTimeOnLevel", proc->processorTimeOnLevel, other->processorTimeOnLevel);
+		COMPARE("vruntime", proc->vruntime, other->vruntime);
+		COMPARE("pass", proc->pass, other->pass);
+		COMPARE("predictedBurst", proc->predictedBurst, other->predictedBurst);
+		COMPARE("burstStart", proc->burstStart, other->burstStart);
+
+		Registers regs = registersOf(fast, proc);
+		string diff = diffRegisters(regs, programBase(fast, proc), registersOf(slow, other), programBase(slow, other));
+		if (!diff.empty()) {
+			failure << "registers differ without superinstructions (with/without):" << diff;
+			return false;
+		}
+
+		// Run the reference up to the instructions the process has been charged for (which, with no memory stalls, is every tick it ran)
+		while (ref.executed < proc->processorTime()) {
+			if (ref.lastSyscall == Syscall::SYS_EXIT || ref.lastSyscall == Syscall::SYS_FAULT) {
+				failure << "charged for " << proc->processorTime() << " instructions, but " << (ref.lastSyscall == Syscall::SYS_EXIT ? "exits" : "faults")
+						<< " after " << ref.executed;
+				return false;
+			} else if (!referenceStep(ref, fast.machine->memory->config().maxVirtualPages)) {
+				failure << "ran an instruction the reference doesn't model";
+				return false;
+			}
+			ref.executed++;
+		}
+
+		diff = diffRegisters(ref.regs, programBase(fast, proc), regs, programBase(fast, proc));
+		if (!diff.empty()) {
+			failure << "registers differ from the reference after " << ref.executed << " instructions (reference/kernel):" << diff;
+			return false;
+		}
+
+		// (a process that faults is killed, one that exits is dead if it missed its deadline, and only I/O, AIOWAIT, LOCK and SEMWAIT block)
+		bool finished = proc->state() == done || proc->state() == dead, mayBlock = ref.lastSyscall == Syscall::SYS_IO ||
+																				 ref.lastSyscall == Syscall::SYS_AIO_WAIT ||
+																				 ref.lastSyscall == Syscall::SYS_LOCK || ref.lastSyscall == Syscall::SYS_SEM_WAIT;
+		if (finished != (ref.lastSyscall == Syscall::SYS_EXIT || ref.lastSyscall == Syscall::SYS_FAULT) ||
+			(ref.lastSyscall == Syscall::SYS_FAULT && proc->state() != dead) || (proc->state() == blocked && !mayBlock)) {
+			failure << "in state " << proc->state() << " after its last instruction made syscall " << ref.lastSyscall;
+			return false;
+		}
+	}
+
+	culprit = nullptr;
+	return true;
+}
+
+#undef COMPARE
+
+// Runs a case, returning false (after reporting it) if it failed
+static bool runCase(uint seed, uint interval, unsigned long long& processes, unsigned long long& ticks) {
+	FuzzCase fuzzCase = generateCase(seed);
+	Simulation fast = startSimulation(fuzzCase, true), slow = startSimulation(fuzzCase, false);
+	map<uint, ReferenceProcess> reference;
+	ostringstream failure;
+	const PCB* culprit = nullptr;
+	TickStart start;
+	size_t arrived = 0;
+	uint tick;
+	bool ok = checkCodeLayout(fast, failure) && checkPartitions(fast, failure);
+
+	for (tick = 1; ok; tick++) {
+		size_t arriving = arrived;
+		while (arriving < fuzzCase.arrivals.size() && fuzzCase.arrivals[arriving].time == tick) arriving++;
+
+		for (Simulation* sim : {&fast, &slow}) {
+			enter(*sim);
+			state->time++;
+
+			if (tick == FUZZ_JOB_TICKS) {  // (so that the case can finish)
+				for (RTJob* job : state->jobList) delete job;
+				state->jobList.clear();
+			}
+
+			for (size_t i = arrived; i < arriving; i++) {
+				const FuzzArrival& arrival = fuzzCase.arrivals[i];
+				uint pid = spawn(fuzzCase.names[arrival.program].c_str(), arrival.deadline, arrival.nice, arrival.tickets);
+				setProcessAffinity(state->processTable.at(pid), arrival.affinity);
+
+				if (sim == &fast) {
+					reference.emplace(pid, newReferenceProcess(state->processTable.at(pid), state->time));
+				}
+			}
+
+			if (sim == &fast) {
+				startTick(*sim, start);
+			}
+			if (ok && kernelTick() != 0) {
+				failure << "the kernel failed" << (sim == &fast ? "" : " without superinstructions");
+				ok = false;
+			}
+			if (ok && sim == &fast) {
+				for (uint slot = start.states.size(); slot < state->columns.size(); slot++) {	// (the processes released during the tick)
+					reference.emplace(state->columns.pcb[slot]->pid, newReferenceProcess(state->columns.pcb[slot], state->time));
+				}
+				ok = checkDispatches(*sim, start, reference, failure, culprit);
+			}
+			leave(*sim);
+		}
+		arrived = arriving;
+
+		bool finished = arrived == fuzzCase.arrivals.size() && (fuzzCase.jobs.empty() || tick >= FUZZ_JOB_TICKS) && fast.state->finishedProcesses == fast.state->processList.size() &&
+						slow.state->finishedProcesses == slow.state->processList.size();
+		if (ok && (tick % interval == 0 || finished)) {
+			ok = check(fast, slow, reference, failure, culprit);
+		}
+
+		if (finished) {
+			break;
+		} else if (ok && tick == FUZZ_MAX_TICKS) {
+			failure << "still running after " << FUZZ_MAX_TICKS << " ticks";
+			ok = false;
+		}
+	}
+
+	if (!ok) {
+		cout << "Fuzz case " << seed << " (" << STRATEGY_NAMES[fuzzCase.strategy] << ", " << (uint)fuzzCase.numCores << " cores, "
+			 << (uint)fuzzCase.numIODevices << " devices, " << fuzzCase.arrivals.size() << " arrivals, " << fuzzCase.jobs.size() << " jobs) failed at tick " << tick << ":\n  ";
+		if (culprit != nullptr) {
+			cout << "pid " << culprit->pid << " (" << culprit->name << "): ";
+		}
+		cout << failure.str() << "\n";
+
+		if (culprit != nullptr) {
+			const vector<Instruction>& program = fuzzCase.programs[stoi(culprit->name.substr(5))];
+
+			cout << "Program " << culprit->name << ":\n" << disassemble(program.data(), program.size());
+		}
+		cout << endl;
+	}
+
+	processes += fast.state->processList.size();
+	ticks += tick;
+	endSimulation(fast);
+	endSimulation(slow);
+	return ok;
+}
+
+bool runFuzzer(uint cases, uint seed, uint interval) {
+	unsigned long long processes = 0, ticks = 0;
+	uint failures = 0;
+
+	for (uint i = 0; i < cases; i++) {
+		failures += !runCase(seed + i, interval == 0 ? 1 : interval, processes, ticks);
+	}
+
+	if (failures == 0) {
+		cout << "Fuzz: all " << cases << " cases from seed " << seed << " matched (" << processes << " processes, " << ticks << " ticks)" << endl;
+	} else {
+		cout << "Fuzz: " << failures << " of " << cases << " cases from seed " << seed << " failed (rerun one alone with --fuzz=1 --seed=N)"
+			 << endl;
+	}
+	return failures == 0;
+}
+#endif
@@ -0,0 +1,28 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include "decls.h"
+
+// Differential fuzzing of the kernel (bench --fuzz=CASES): each case is a random machine, strategy, set of programs and arrivals, run
+// twice side by side, once on the kernel as it is and once with superinstructions off (every instruction fetched and dispatched on a tick
+// of its own), and every few ticks:
+// - the two runs must agree on every process (its state, times, scheduling fields and registers) and on the OS's counters
+// - each process's registers must be what a reference interpreter (a plain reading of the ISA, written separately from the CPU) gets by
+//   running its program for as many instructions as the process has been charged for
+// And every tick, the kernel's dispatch decisions must be what a reference scheduler makes of them: linear scans over every process for
+// each strategy instead of the ready lists, MLF boosts applied to every process as they come, and a full scan for EDF/LST preemptions
+// The programs use every opcode (memory, asynchronous I/O, mutexes and semaphores included), and the cases draw the memory and MLF configs,
+// and real-time jobs under the real-time strategies (whose partitions must be what a plain first/worst fit gives)
+// Some cases reconfigure the machine partway through loading the programs, and no two programs' code may then share an address
+// A case that fails is reported with its seed (to rerun it alone) and the offending program as .fsp source
+
+// The most ticks a case may take before it's considered stuck
+#define FUZZ_MAX_TICKS 200000
+// The tick a case's real-time jobs are withdrawn on (so that the case can finish)
+#define FUZZ_JOB_TICKS 300
+
+// Runs the given number of cases (with seeds seed, seed + 1, ...), checking every interval ticks
+// Returns false if any case failed
+bool runFuzzer(uint cases, uint seed, uint interval);
+
+#endif
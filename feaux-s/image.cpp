@@ -0,0 +1,191 @@
+#include "image.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "machine.h"
+#include "os.h"
+
+using namespace std;
+
+static_assert(sizeof(Instruction) == 12, "program images store instructions exactly as the CPU reads them");
+
+// Rounds an offset up to where instructions can be read from
+static uint32_t alignInstructions(uint32_t offset) { return (offset + alignof(Instruction) - 1) / alignof(Instruction) * alignof(Instruction); }
+
+// Whether the instruction at the given index of a program can be run as it is: a known opcode, registers that exist, and (for a jump) a
+// target inside the program
+static bool validInstruction(const Instruction* instructions, uint length, uint index) {
+	const Instruction& instruction = instructions[index];
+
+	switch (instruction.opcode) {
+		case Opcode::LOAD:
+			return instruction.operand2 <= R15;
+		case Opcode::INC:
+		case Opcode::AIOPOLL:
+		case Opcode::AIOWAIT:
+			return instruction.operand1 <= R15;
+		case Opcode::MOVE:
+		case Opcode::CMP:
+		case Opcode::ADD:
+		case Opcode::SUB:
+		case Opcode::SW:
+			return instruction.operand1 <= R15 && instruction.operand2 <= R15;
+		case Opcode::JL:
+		case Opcode::JLE:
+		case Opcode::JE:
+		case Opcode::JGE:
+		case Opcode::JG: {
+			int offset = (int)instruction.operand1;
+			long target = (long)index + offset / (int)sizeof(Instruction);
+			return offset % (int)sizeof(Instruction) == 0 && target >= 0 && target < (long)length;
+		}
+		default:
+			return (uint)instruction.opcode <= Opcode::SEMINIT;
+	}
+}
+
+bool writeProgramImage(const char* path) {
+	ImageHeader header;
+	vector<ImageEntry> entries;
+	string strings;
+	uint32_t offset = sizeof(ImageHeader) + state->programs.size() * sizeof(ImageEntry);
+
+	for (const auto& it : state->programs) {
+		const Program& program = it.second;
+		ImageEntry entry;
+
+		offset = alignInstructions(offset);
+		entry.nameOffset = strings.size();
+		entry.nameLength = program.name.size();
+		entry.instructionOffset = offset;
+		entry.length = program.length;
+		entry.cost = program.cost;
+		entry.costKind = program.costKind;
+		entry.tickets = program.tickets;
+
+		strings += program.name;
+		offset += program.length * sizeof(Instruction);
+		entries.push_back(entry);
+	}
+
+	header.magic = IMAGE_MAGIC;
+	header.version = IMAGE_VERSION;
+	header.numPrograms = entries.size();
+	header.stringTableOffset = offset;
+	header.stringTableSize = strings.size();
+
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) {
+		cerr << "Debug: unable to create program image " << path << endl;
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(ImageHeader), 1, file) == 1;
+	ok = ok && (entries.empty() || fwrite(entries.data(), sizeof(ImageEntry), entries.size(), file) == entries.size());
+
+	uint i = 0;
+	for (const auto& it : state->programs) {
+		static const char padding[alignof(Instruction)] = {};
+		uint32_t written = ftell(file);
+
+		ok = ok && fwrite(padding, 1, entries[i].instructionOffset - written, file) == entries[i].instructionOffset - written;
+		ok = ok && (it.second.length == 0 || fwrite(it.second.instructions.get(), sizeof(Instruction), it.second.length, file) == it.second.length);
+		i++;
+	}
+
+	ok = ok && fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok) {
+		cerr << "Debug: unable to write program image " << path << endl;
+	}
+	return ok;
+}
+
+uint loadProgramImage(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		cerr << "Debug: unable to open program image " << path << endl;
+		return 0;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ImageHeader)) {
+		cerr << "Debug: " << path << " is not a program image" << endl;
+		close(fd);
+		return 0;
+	}
+
+	size_t size = info.st_size;
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	// The mapping keeps the file open
+
+	if (mapping == MAP_FAILED) {
+		cerr << "Debug: unable to map program image " << path << endl;
+		return 0;
+	}
+
+	const char* image = (const char*)mapping;
+	const ImageHeader* header = (const ImageHeader*)image;
+	const ImageEntry* entries = (const ImageEntry*)(image + sizeof(ImageHeader));
+
+	// Check everything the programs will point into lies inside the image before loading any of them
+	bool valid = header->magic == IMAGE_MAGIC && header->version == IMAGE_VERSION &&
+				 header->numPrograms <= (size - sizeof(ImageHeader)) / sizeof(ImageEntry) && header->stringTableOffset <= size &&
+				 header->stringTableSize <= size - header->stringTableOffset;
+
+	for (uint i = 0; valid && i < header->numPrograms; i++) {
+		const ImageEntry& entry = entries[i];
+
+		valid = entry.nameOffset <= header->stringTableSize && entry.nameLength <= header->stringTableSize - entry.nameOffset &&
+				entry.instructionOffset % alignof(Instruction) == 0 && entry.instructionOffset <= size &&
+				entry.length <= (size - entry.instructionOffset) / sizeof(Instruction) && entry.costKind <= COST_UNKNOWN;
+
+		// Only valid instructions, so the CPU never runs off into an unknown opcode or register, or jumps out of the program
+		const Instruction* instructions = (const Instruction*)(image + entry.instructionOffset);
+		for (uint j = 0; valid && j < entry.length; j++) {
+			valid = validInstruction(instructions, entry.length, j);
+		}
+	}
+
+	if (!valid) {
+		cerr << "Debug: " << path << " is not a valid (version " << IMAGE_VERSION << ") program image" << endl;
+		munmap(mapping, size);
+		return 0;
+	}
+
+	// Each program shares ownership of the mapping, which is unmapped along with the last of them
+	shared_ptr<const char> owner(image, [size](const char* mapped) { munmap((void*)mapped, size); });
+	uint loaded = 0;
+
+	for (uint i = 0; i < header->numPrograms; i++) {
+		const ImageEntry& entry = entries[i];
+		string name(image + header->stringTableOffset + entry.nameOffset, entry.nameLength);
+
+		if (state->programs.count(name)) {
+			cerr << "Debug: skipping program " << name << " in " << path << ", since a program of that name is already loaded" << endl;
+			continue;
+		}
+
+		// The CPU only ever reads instructions, so they can stay in the read-only mapping
+		Program program{name, entry.length, shared_ptr<const Instruction>(owner, (const Instruction*)(image + entry.instructionOffset))};
+		program.cost = entry.cost;
+		program.costKind = (CostKind)entry.costKind;
+		program.tickets = entry.tickets;
+		program.predictedBurst = entry.cost;
+		placeProgram(program);
+
+		state->programs.emplace(name, std::move(program));
+		loaded++;
+	}
+
+	flushFusedBlocks();	 // The image may have been mapped where an old program's translated code was
+	return loaded;
+}
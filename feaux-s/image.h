@@ -0,0 +1,47 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <cstdint>
+
+#include "decls.h"
+
+// Program images: a library of already assembled (and analyzed) programs in one file, which is mapped into memory and executed in place
+// Layout (all fields are little-endian 32-bit words):
+//   ImageHeader
+//   ImageEntry[numPrograms]
+//   the instructions of each program (Instruction structs, exactly as the CPU reads them, aligned for them)
+//   the string table (the program names, not null-terminated)
+#define IMAGE_MAGIC 0x49505346	// "FSPI"
+#define IMAGE_VERSION 1
+
+struct ImageHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numPrograms;
+	uint32_t stringTableOffset;	 // From the start of the image
+	uint32_t stringTableSize;
+};
+
+// The directory entry of a program in an image
+struct ImageEntry {
+	uint32_t nameOffset;  // Into the string table
+	uint32_t nameLength;
+	uint32_t instructionOffset;	 // From the start of the image
+	uint32_t length;			 // Number of instructions
+	uint32_t cost;				 // See Program::cost/costKind (so the program doesn't need analyzing again)
+	uint32_t costKind;
+	uint32_t tickets;
+};
+
+// Writes every loaded program into an image at the given path
+// Returns false if the file can't be written
+bool writeProgramImage(const char* path);
+
+// Maps the image at the given path and loads its programs, with their instructions left in the mapping instead of being copied
+// Any program whose name is already taken is skipped (and reported), leaving the loaded one in place
+// The whole image is rejected if any instruction has an unknown opcode, a register past R15 or a jump out of its program
+// The programs share the mapping, so the image stays mapped until the last of them is gone
+// Returns the number of programs loaded (0 if the image can't be mapped or is malformed)
+uint loadProgramImage(const char* path);
+
+#endif
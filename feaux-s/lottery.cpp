@@ -0,0 +1,77 @@
+#include "lottery.h"
+
+#include "machine.h"
+#include "process.h"
+
+using namespace std;
+
+LotteryTree::LotteryTree() : _tree(17, 0), _procs(16, nullptr), _size(0), _total(0), _rng(0x5EED) {
+	for (uint i = 16; i > 0; i--) _freeSlots.push_back(i - 1);
+}
+
+void LotteryTree::insert(PCB* proc) {
+	if (_freeSlots.empty()) {
+		_grow();
+	}
+
+	uint slot = _freeSlots.back();
+	_freeSlots.pop_back();
+
+	_procs[slot] = proc;
+	proc->lotterySlot = slot;
+	_add(slot, proc->tickets);
+	_size++;
+	_total += proc->tickets;
+}
+
+PCB* LotteryTree::draw() {
+	if (_size == 0) {
+		return nullptr;
+	}
+
+	// Descend the tree looking for the slot whose ticket range contains the winner (the capacity is always a power of 2)
+	unsigned long long winner = sampleBelow(_rng, _total);
+	uint pos = 0;
+	for (uint step = _procs.size(); step > 0; step >>= 1) {
+		if (pos + step < _tree.size() && _tree[pos + step] <= winner) {
+			pos += step;
+			winner -= _tree[pos];
+		}
+	}
+
+	PCB* proc = _procs[pos];  // pos is the number of slots entirely before the winner, ie. the winning slot's 0-based index
+
+	_add(pos, -(long long)proc->tickets);
+	_procs[pos] = nullptr;
+	_freeSlots.push_back(pos);
+	_size--;
+	_total -= proc->tickets;
+
+	return proc;
+}
+
+void LotteryTree::_add(uint slot, long long delta) {
+	for (uint i = slot + 1; i < _tree.size(); i += i & -i) {
+		_tree[i] += delta;
+	}
+}
+
+void LotteryTree::_grow() {
+	uint oldSize = _procs.size();
+
+	_procs.resize(oldSize * 2, nullptr);
+	for (uint i = oldSize * 2; i > oldSize; i--) _freeSlots.push_back(i - 1);
+
+	// Rebuild: each node takes its own slot's tickets, then passes its sum up to its parent
+	_tree.assign(oldSize * 2 + 1, 0);
+	for (uint i = 1; i < _tree.size(); i++) {
+		if (_procs[i - 1] != nullptr) {
+			_tree[i] += _procs[i - 1]->tickets;
+		}
+
+		uint parent = i + (i & -i);
+		if (parent < _tree.size()) {
+			_tree[parent] += _tree[i];
+		}
+	}
+}
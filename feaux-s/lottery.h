@@ -0,0 +1,42 @@
+#ifndef LOTTERY_H
+#define LOTTERY_H
+
+#include <random>
+#include <vector>
+
+#include "decls.h"
+
+// The ready list for lottery scheduling: a Fenwick (binary indexed) tree over the tickets of the ready processes, so that drawing a winner,
+// inserting and removing a process are all O(log n)
+// Each process keeps the slot it occupies in the tree (PCB::lotterySlot) while it is in the list
+class LotteryTree {
+public:
+	LotteryTree();
+
+	// Adds a process to the draw (with as many tickets as it holds)
+	void insert(PCB* proc);
+
+	// Draws a winning ticket, removing and returning the process holding it (nullptr if the list is empty)
+	PCB* draw();
+
+	bool empty() const { return _size == 0; }
+	uint size() const { return _size; }
+	unsigned long long totalTickets() const { return _total; }
+
+	// The process in each slot (nullptr for free slots), for exporting the list
+	const std::vector<PCB*>& slots() const { return _procs; }
+
+private:
+	std::vector<unsigned long long> _tree;	// 1-based Fenwick tree over slot tickets (_tree[0] is unused)
+	std::vector<PCB*> _procs;				// The process in each slot
+	std::vector<uint> _freeSlots;
+	uint _size;
+	unsigned long long _total;
+	std::mt19937 _rng;	// Seeded with a constant, so that simulations are repeatable
+
+	void _add(uint slot, long long delta);
+	// Doubles the number of slots (rebuilding the tree in O(n))
+	void _grow();
+};
+
+#endif
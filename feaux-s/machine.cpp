@@ -1,15 +1,30 @@
 #include "machine.h"
 
+#include <cmath>
 #include <iostream>
 
+#include "devices.h"
+#include "memory.h"
 #include "os.h"
+#include "process.h"
 #include "utils.h"
 
 using namespace std;
 
 MachineState* machine = nullptr;
 
-CPU::CPU(uint8_t id) : _id(id) {
+CPU::CPU(uint8_t id)
+	: _id(id),
+	  _stall(0),
+	  _fusion(true),
+	  _blocks(FUSED_BLOCK_CACHE_SIZE),
+	  _fusedLength(0),
+	  _fusedRemaining(0),
+	  _cacheConfig(defaultCacheConfig()),
+	  _asid(0),
+	  _cacheStallTicks(0) {
+	flushBlocks();
+
 	// Init to NOOP registers (see CPU::_readyNextInstruction)
 	_instruction = nullptr;
 #if FEAUX_S_BENCHMARKING
@@ -21,13 +36,70 @@ CPU::CPU(uint8_t id) : _id(id) {
 
 bool CPU::free() const { return _registers.rip == 0; }
 
-Registers CPU::regstate() const { return _registers; }
+Registers CPU::regstate() const {
+	if (_fusedRemaining == 0) {
+		return _registers;
+	}
+
+	// Part way through a block, so replay the instructions already charged for (blocks only jump at the end, so they're consecutive)
+	Registers regs = _fusedEntry;
+	for (uint i = 0; i < _fusedLength - _fusedRemaining; i++) {
+		const Instruction& instruction = *(const Instruction*)(uintptr_t)regs.rip;
 
-void CPU::load(Registers regState) { _registers = regState; }
+		regs.rip += sizeof(Instruction);
+		executeRegisterOp(regs, instruction);
+	}
+	return regs;
+}
+
+void CPU::load(Registers regState) {
+	_registers = regState;
+	_stall = 0;			 // A stall belongs to the process that caused it, so don't charge it to the next one
+	_fusedRemaining = 0;  // Likewise the rest of a fused block (regstate() gave the process back its registers as of where it got to)
+}
 
 void CPU::tick() {
+	if (_stall > 0) {  // Still waiting on memory
+		_stall--;
+		return;
+	}
+
+	if (_fusedRemaining > 0) {	// Still being charged for a fused block (its effects were all applied when it started)
+		_fusedRemaining--;
+		return;
+	}
+
+#ifndef FEAUX_S_NO_FUSION
+	// Fuse runs of register-only instructions into one step (not with caches enabled, since every instruction fetch then goes through them)
+	// (and only for a process's own code, whose end the block mustn't run past)
+	PCB* running = state->runningProcess[_id];
+	if (_fusion && _registers.rip != 0 && !_cacheConfig.enabled && running != nullptr) {
+		FusedBlock& block = _blocks[(_registers.rip / sizeof(Instruction)) % FUSED_BLOCK_CACHE_SIZE];
+
+		if (block.address != (uint64_t)_registers.rip) {
+			translateBlock((const Instruction*)(uintptr_t)_registers.rip, (const Instruction*)(uintptr_t)running->codeEnd, block);
+		}
+
+		if (block.length >= 2) {
+			_fusedEntry = _registers;
+			_fusedLength = block.length;
+			_fusedRemaining = block.length - 1;
+			runBlock(block, _registers);
+			return;
+		}
+	}
+#endif
+
 	_readNextInstruction();
 
+	if (_instruction != nullptr && _cacheConfig.enabled) {
+		_checkContextSwitch();
+		PCB* proc = state->runningProcess[_id];
+
+		// Instruction fetch (code is shared by all processes running a program)
+		_stall += _access(0, (uint64_t)(uintptr_t)_instruction + (proc != nullptr ? proc->codeOffset : 0), false);
+	}
+
 	if (_instruction != nullptr) {
 		switch (_instruction->opcode) {
 			case Opcode::NOP:
@@ -35,18 +107,9 @@ void CPU::tick() {
 				break;
 			case Opcode::IO:
 				state->pendingSyscalls[_id] = Syscall::SYS_IO;
-				_registers.rdi = _instruction->operand1;
+				_registers.rdi = _instruction->operand1;  // Size of the request
+				_registers.rsi = _instruction->operand2;  // Block address (or NO_BLOCK)
 				break;
-			case Opcode::LOAD: {
-				uint* dest = getRegister(_registers, (Regs)_instruction->operand2);
-				*dest = _instruction->operand1;
-				break;
-			}
-			case Opcode::MOVE: {
-				uint *dest = getRegister(_registers, (Regs)_instruction->operand2), *src = getRegister(_registers, (Regs)_instruction->operand1);
-				*dest = *src;
-				break;
-			}
 			case Opcode::EXIT:
 				state->pendingSyscalls[_id] = Syscall::SYS_EXIT;
 				break;
@@ -56,89 +119,129 @@ void CPU::tick() {
 			case Opcode::FREE:
 				state->pendingSyscalls[_id] = Syscall::SYS_FREE;
 				break;
-			case Opcode::SW: {
-				uint8_t data = *getRegister(_registers, (Regs)_instruction->operand1),
-						*loc = (uint8_t*)*getRegister(_registers, (Regs)_instruction->operand2);
-
-				*loc = data;
+			case Opcode::AIO:
+				state->pendingSyscalls[_id] = Syscall::SYS_AIO_SUBMIT;
+				_registers.rdi = _instruction->operand1;  // Size of each request
+				_registers.rsi = 1;						  // Number of requests
 				break;
-			}
-			case Opcode::CMP: {
-				uint a = *getRegister(_registers, (Regs)_instruction->operand1), b = *getRegister(_registers, (Regs)_instruction->operand2);
-
-				_registers.flags &= (~FLAG_CY & ~FLAG_ZF);
-				if (a == b) {
-					_registers.flags |= (FLAG_CY | FLAG_ZF);
-				} else if (a < b) {
-					_registers.flags |= FLAG_CY;
-				}
+			case Opcode::AIOBATCH:
+				state->pendingSyscalls[_id] = Syscall::SYS_AIO_SUBMIT;
+				_registers.rdi = _instruction->operand1;
+				_registers.rsi = _instruction->operand2;
 				break;
-			}
-			case Opcode::JL:
-				if (_registers.flags & FLAG_CY && !(_registers.flags & FLAG_ZF))
-					// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
-					_registers.rip = (_registers.rip - sizeof(Instruction)) + (int)_instruction->operand1;
+			case Opcode::AIOPOLL:
+				state->pendingSyscalls[_id] = Syscall::SYS_AIO_POLL;
+				_registers.rdi = *getRegister(_registers, (Regs)_instruction->operand1);  // The handle
 				break;
-			case Opcode::JLE:
-				if (_registers.flags & FLAG_CY)
-					// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
-					_registers.rip = (_registers.rip - sizeof(Instruction)) + (int)_instruction->operand1;
+			case Opcode::AIOWAIT:
+				state->pendingSyscalls[_id] = Syscall::SYS_AIO_WAIT;
+				_registers.rdi = *getRegister(_registers, (Regs)_instruction->operand1);
 				break;
-			case Opcode::JE:
-				if (_registers.flags & FLAG_ZF)
-					// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
-					_registers.rip = (_registers.rip - sizeof(Instruction)) + (int)_instruction->operand1;
+			case Opcode::LOCK:
+				state->pendingSyscalls[_id] = Syscall::SYS_LOCK;
+				_registers.rdi = _instruction->operand1;  // The mutex
 				break;
-			case Opcode::JGE:
-				if (!(_registers.flags & FLAG_CY))
-					// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
-					_registers.rip = (_registers.rip - sizeof(Instruction)) + (int)_instruction->operand1;
+			case Opcode::UNLOCK:
+				state->pendingSyscalls[_id] = Syscall::SYS_UNLOCK;
+				_registers.rdi = _instruction->operand1;
 				break;
-			case Opcode::JG:
-				if (!(_registers.flags & FLAG_CY) && !(_registers.flags & FLAG_ZF))
-					// subtract sizeof(Instruction) to correct for the fact that we have already advanced the instruction pointer
-					_registers.rip = (_registers.rip - sizeof(Instruction)) + (int)_instruction->operand1;
+			case Opcode::SEMWAIT:
+				state->pendingSyscalls[_id] = Syscall::SYS_SEM_WAIT;
+				_registers.rdi = _instruction->operand1;  // The semaphore
 				break;
-			case Opcode::INC: {
-				uint* loc = getRegister(_registers, (Regs)_instruction->operand1);
-
-				(*loc)++;
+			case Opcode::SEMPOST:
+				state->pendingSyscalls[_id] = Syscall::SYS_SEM_POST;
+				_registers.rdi = _instruction->operand1;
 				break;
-			}
-			case Opcode::ADD: {
-				uint *src = getRegister(_registers, (Regs)_instruction->operand1), *dest = getRegister(_registers, (Regs)_instruction->operand2);
+			case Opcode::SEMINIT:
+				state->pendingSyscalls[_id] = Syscall::SYS_SEM_INIT;
+				_registers.rdi = _instruction->operand1;
+				_registers.rsi = _instruction->operand2;  // Its count
+				break;
+			case Opcode::SW: {
+				uint8_t data = *getRegister(_registers, (Regs)_instruction->operand1);
+				uint address = *getRegister(_registers, (Regs)_instruction->operand2), stall = 0;
+				PCB* process = state->runningProcess[_id];
+				AccessResult result =
+					process != nullptr && process->addressSpace != nullptr ? machine->memory->write(*process->addressSpace, address, data, stall) : ACCESS_SEGFAULT;
 
-				_registers.flags &= (~FLAG_CY & ~FLAG_ZF);
-				if (*dest > numeric_limits<uint>::max() - *src) {
-					if (*src != 0 && *dest == numeric_limits<uint>::max() - *src + 1) {
-						_registers.flags |= FLAG_ZF;
+				if (result == ACCESS_SEGFAULT) {
+					state->pendingSyscalls[_id] = Syscall::SYS_FAULT;
+				} else {
+					if (result != ACCESS_OK) {	// Page fault, so stall while the kernel brings the page in
+						process->pageFaults++;
+						process->pageFaultTicks += stall;
+						_stall += stall;
 					}
 
-					_registers.flags |= FLAG_CY;
+					if (_cacheConfig.enabled) {
+						_stall += _access(_cacheConfig.flushOnSwitch ? 0 : _asid, address, true);
+					}
 				}
-
-				*dest += *src;
 				break;
 			}
-			case Opcode::SUB: {
-				uint *src = getRegister(_registers, (Regs)_instruction->operand1), *dest = getRegister(_registers, (Regs)_instruction->operand2);
+			case Opcode::LOAD:
+			case Opcode::MOVE:
+			case Opcode::CMP:
+			case Opcode::JL:
+			case Opcode::JLE:
+			case Opcode::JE:
+			case Opcode::JGE:
+			case Opcode::JG:
+			case Opcode::INC:
+			case Opcode::ADD:
+			case Opcode::SUB:
+				executeRegisterOp(_registers, *_instruction);
+				break;
+		}
+	}
+}
 
-				_registers.flags &= (~FLAG_CY & ~FLAG_ZF);
-				if (*dest >= *src) {
-					if (*dest == *src) {
-						_registers.flags |= FLAG_ZF;
-					}
+void CPU::configureCaches(const CacheConfig& config) {
+	_cacheConfig = config;
+	_l1 = Cache(config.l1Sets, config.l1Ways);
+	_l2 = Cache(config.l2Sets, config.l2Ways);
+	_tlb = Cache(config.tlbSets, config.tlbWays);
+	_asid = 0;
+	_cacheStallTicks = 0;
+}
 
-					_registers.flags |= FLAG_CY;
-				}
+void CPU::flushBlocks() {
+	for (FusedBlock& block : _blocks) {
+		block.address = 0;
+	}
+}
 
-				*dest -= *src;
-				break;
-			}
+void CPU::_checkContextSwitch() {
+	PCB* process = state->runningProcess[_id];
+	uint pid = process == nullptr ? 0 : process->pid;
+
+	if (pid != _asid) {
+		if (_cacheConfig.flushOnSwitch) {
+			_l1.flush();
+			_tlb.flush();
 		}
+
+		_asid = pid;
 	}
 }
 
+uint CPU::_access(uint asid, uint64_t address, bool translate) {
+	uint stall = 0;
+
+	if (translate && !_tlb.access(asid, address / PAGE_SIZE)) {
+		stall += _cacheConfig.tlbMissTicks;
+	}
+
+	uint64_t line = address / _cacheConfig.lineSize;
+	if (!_l1.access(asid, line)) {
+		stall += _l2.access(asid, line) ? _cacheConfig.l2HitTicks : _cacheConfig.memoryTicks;
+	}
+
+	_cacheStallTicks += stall;
+	return stall;
+}
+
 void CPU::_readNextInstruction() {
 	if (_registers.rip == 0) {
 		_instruction = nullptr;	 // NOOP (NOTE: DO NOT INCREMENT RIP REGISTER)
@@ -148,39 +251,200 @@ void CPU::_readNextInstruction() {
 	}
 }
 
+IODevice::IODevice(uint8_t id, const IODeviceConfig& config)
+	: _id(id),
+	  _config(config),
+	  _rng(config.seed + id),
+	  _head(0),
+	  _ascending(true),
+	  _channels(config.channels == 0 ? 1 : config.channels),
+	  _active(0),
+	  _completed(0),
+	  _totalWait(0),
+	  _totalService(0),
+	  _maxWait(0) {
+	clear();
+}
+
 void IODevice::tick() {
-	if (_pid != 0) {
-		_progress++;
+	for (Channel& channel : _channels) {
+		if (channel.pid != 0) {
+			channel.progress++;
+
+			if (channel.progress > channel.duration) {	// The I/O request completed
+				IOInterrupt* interrupt = new IOInterrupt(channel.pid, channel.req.handle);
+
+				handleInterrupt(interrupt);
+				_completed++;
+				_totalService += channel.duration;
 
-		if (_progress > _duration) {  // The I/O request completed
-			IOInterrupt* interrupt = new IOInterrupt(_pid);
+				channel.pid = 0;
+				channel.duration = 0;
+				channel.progress = 0;
+				_active--;
 
-			handleInterrupt(interrupt);
-			clear();
+				// The device holds its own queue, so it can move straight on to the next request
+				if (!_queue.empty()) {
+					uint next = _pickNext();
+					IORequest req = _queue[next];
+
+					_queue.erase(_queue.begin() + next);
+					_start(channel, req);
+				}
+			}
 		}
 	}
 }
 
 void IODevice::handle(const IORequest& req) {
-	if (_pid != 0) {
-		cerr << "IO Device " << _id << " asked to handle request from process " << req.pid << " while busy" << endl;
+	if (busy()) {
+		cerr << "IO Device " << (uint)_id << " asked to handle request from process " << req.pid << " while busy" << endl;
 		return;
 	}
 
-	// Load request data to begin processing
-	_pid = req.pid;
-	_duration = req.duration;
-	_progress = 0;
+	IORequest normalized = req;
+	if (normalized.block == NO_BLOCK) {
+		normalized.block = req.pid * 2654435761u;  // Spread processes' data across the device (Knuth's multiplicative hash)
+	}
+	normalized.block %= _config.numBlocks;
+
+	if (_active < _channels.size()) {
+		for (Channel& channel : _channels) {
+			if (channel.pid == 0) {
+				_start(channel, normalized);
+				return;
+			}
+		}
+	}
+
+	_queue.push_back(normalized);
 }
 
 void IODevice::clear() {
-	_pid = 0;
-	_duration = 0;
-	_progress = 0;
+	for (Channel& channel : _channels) {
+		channel.pid = 0;
+		channel.duration = 0;
+		channel.progress = 0;
+	}
+
+	_queue.clear();
+	_active = 0;
+	_head = 0;
+	_ascending = true;
+
+	_completed = 0;
+	_totalWait = 0;
+	_totalService = 0;
+	_maxWait = 0;
+}
+
+uint IODevice::_serviceTime(const IORequest& req) { return req.duration; }
+
+double sampleUniform(mt19937& rng) { return rng() / 4294967296.0; }
+
+double sampleExponential(mt19937& rng) { return -log(1 - sampleUniform(rng)); }
+
+unsigned long long sampleBelow(mt19937& rng, unsigned long long n) {
+	// 64 random bits, redrawn while they're among the lowest 2^64 mod n values (which would make the lowest values likelier)
+	unsigned long long bits, skip = -n % n;
+	do {
+		bits = (unsigned long long)rng() << 32;
+		bits |= rng();
+	} while (bits < skip);
+
+	return bits % n;
+}
+
+double IODevice::_sample(const Distribution& dist) {
+	switch (dist.type) {
+		case DistributionType::CONSTANT:
+			return dist.a;
+		case DistributionType::UNIFORM:
+			return dist.a + sampleUniform(_rng) * (dist.b - dist.a);
+		case DistributionType::EXPONENTIAL:
+			return dist.a * sampleExponential(_rng);
+		default:
+			cerr << "IO Device " << (uint)_id << ": unknown distribution type " << dist.type << endl;
+			return 0;
+	}
+}
+
+uint IODevice::_pickNext() {
+	switch (_config.policy) {
+		case IOSchedulingPolicy::IO_FIFO:
+			return 0;
+		case IOSchedulingPolicy::IO_SSTF: {
+			uint best = 0, bestDistance = numeric_limits<uint>::max();
+
+			for (uint i = 0; i < _queue.size(); i++) {
+				uint distance = _queue[i].block > _head ? _queue[i].block - _head : _head - _queue[i].block;
+
+				if (distance < bestDistance) {
+					best = i;
+					bestDistance = distance;
+				}
+			}
+
+			return best;
+		}
+		case IOSchedulingPolicy::IO_DEADLINE:
+			if (state->time - _queue.front().submitTime >= _config.deadlineExpiry) {  // The oldest request has expired, so serve it first
+				return 0;
+			}
+			// fall through
+		case IOSchedulingPolicy::IO_ELEVATOR:
+			// Look for the closest request in the direction of the sweep, and turn around if there are none left
+			for (int attempt = 0; attempt < 2; attempt++) {
+				int best = -1;
+				uint bestDistance = numeric_limits<uint>::max();
+
+				for (uint i = 0; i < _queue.size(); i++) {
+					uint block = _queue[i].block;
+
+					if (_ascending ? block >= _head : block <= _head) {
+						uint distance = _ascending ? block - _head : _head - block;
+
+						if (distance < bestDistance) {
+							best = i;
+							bestDistance = distance;
+						}
+					}
+				}
+
+				if (best != -1) {
+					return best;
+				}
+
+				_ascending = !_ascending;
+			}
+
+			return 0;
+		default:
+			cerr << "IO Device " << (uint)_id << ": unknown scheduling policy " << _config.policy << endl;
+			return 0;
+	}
+}
+
+void IODevice::_start(Channel& channel, const IORequest& req) {
+	uint wait = state->time - req.submitTime;
+
+	_totalWait += wait;
+	if (wait > _maxWait) {
+		_maxWait = wait;
+	}
+
+	// Compute the service time before moving the head, since it may depend on where the head was
+	channel.pid = req.pid;
+	channel.req = req;
+	channel.duration = _serviceTime(req);
+	channel.progress = 0;
+	_active++;
+
+	_head = req.block;
 }
 
 void initMachine(uint8_t numCores, uint8_t numIODevices) {
-	machine = new MachineState{numCores, numIODevices, 500, nullptr, nullptr};
+	machine = new MachineState{numCores, numIODevices, 500, nullptr, nullptr, new PhysicalMemory(defaultMemoryConfig())};
 
 	machine->cores = new CPU*[numCores];
 	for (uint8_t i = 0; i < numCores; i++) {
@@ -189,7 +453,23 @@ void initMachine(uint8_t numCores, uint8_t numIODevices) {
 
 	machine->ioDevices = new IODevice*[numIODevices];
 	for (uint8_t i = 0; i < numIODevices; i++) {
-		machine->ioDevices[i] = new IODevice(i);
+		machine->ioDevices[i] = new IODevice(i, defaultIODeviceConfig(IODeviceClass::GENERIC));
+	}
+}
+
+void configureCaches(const CacheConfig& config) {
+	for (uint8_t i = 0; i < machine->numCores; i++) {
+		machine->cores[i]->configureCaches(config);
+	}
+}
+
+void flushFusedBlocks() {
+	if (machine == nullptr) {
+		return;
+	}
+
+	for (uint8_t i = 0; i < machine->numCores; i++) {
+		machine->cores[i]->flushBlocks();
 	}
 }
 
@@ -203,5 +483,6 @@ void cleanupMachine() {
 		delete machine->ioDevices[i];
 	}
 	delete[] machine->ioDevices;
+	delete machine->memory;
 	delete machine;
 }
\ No newline at end of file
@@ -1,9 +1,14 @@
 #ifndef MACHINE_H
 #define MACHINE_H
 
+#include <deque>
 #include <limits>
+#include <random>
+#include <vector>
 
+#include "cache.h"
 #include "decls.h"
+#include "fusion.h"
 #include "signals.h"
 
 struct CPUState;
@@ -21,52 +26,148 @@ public:
 	bool free() const;
 
 	// Gets the current register state of the CPU (ie. before removing a process from execution)
+	// (part way through a fused block, that's rebuilt as of the last instruction the process has been charged a tick for)
 	Registers regstate() const;
 
 	// Runs a tick of the simulation
 	void tick();
 
+	// Keeps the CPU from executing instructions for the given number of ticks
+	void stall(uint ticks) { _stall += ticks; }
+
+	// Sets up the core's caches and TLB (cold, with fresh statistics)
+	void configureCaches(const CacheConfig& config);
+
+	// Forgets every translated block (for when new code may have been loaded where old code was)
+	void flushBlocks();
+
+	// Turns superinstructions on or off (off, every instruction is fetched and dispatched on a tick of its own)
+	void setFusion(bool enabled) { _fusion = enabled; }
+
+	const CacheConfig& cacheConfig() const { return _cacheConfig; }
+	const Cache& l1() const { return _l1; }
+	const Cache& l2() const { return _l2; }
+	const Cache& tlb() const { return _tlb; }
+	unsigned long long cacheStallTicks() const { return _cacheStallTicks; }
+
 	friend void exportCPU(const CPU& src, CPUState& dest);
 
 	// The kernel is your friend :D
 	// but only use this power sparingly
-	friend int main();
+	friend int kernelTick();
 
 private:
 	uint8_t _id;
 	Instruction* _instruction;
 	Registers _registers;
+	uint _stall;  // Ticks left before the CPU can execute the next instruction (waiting on memory)
+
+	// Superinstructions (see fusion.h)
+	bool _fusion;
+	std::vector<FusedBlock> _blocks;  // Translated blocks, direct-mapped by address
+	Registers _fusedEntry;			  // The registers as they were before the block being worked through
+	uint _fusedLength;				  // The length of that block
+	uint _fusedRemaining;			  // The ticks still owed for it (0 = not in a block)
+
+	CacheConfig _cacheConfig;
+	Cache _l1;
+	Cache _l2;
+	Cache _tlb;
+	uint _asid;	 // The PID of the process whose accesses the core last made
+	unsigned long long _cacheStallTicks;
 
 	void _readNextInstruction();
+
+	// Notices when a different process has started running on the core, flushing the core's state if the config says so
+	void _checkContextSwitch();
+	// Runs an access through the TLB (data accesses only) and caches, returning the number of ticks it stalls the core
+	uint _access(uint asid, uint64_t address, bool translate);
 };
 
+// Random sampling for the simulation (the I/O devices' service times, generated workloads, lottery draws), done by hand from the raw output
+// of an mt19937 rather than with <random>'s distributions, whose output differs between standard libraries (native vs WASM), so that a seed
+// gives the same simulation on either
+// Uniform in [0, 1)
+double sampleUniform(std::mt19937& rng);
+// Exponential, with a mean of 1
+double sampleExponential(std::mt19937& rng);
+// Uniform in [0, n), without modulo bias (n > 0)
+unsigned long long sampleBelow(std::mt19937& rng, unsigned long long n);
+
 // Class for simulating the operations of an I/O device
+// The base class models a GENERIC device (each request takes exactly its duration); subclasses in devices.h model other kinds of device
 class IODevice {
 public:
-	IODevice(uint8_t id) : _id(id), _pid(0), _duration(0), _progress(0) {}
+	IODevice(uint8_t id, const IODeviceConfig& config);
+	virtual ~IODevice() {}
 
 	// Runs a tick of the simulation
 	void tick();
 
-	// Informs the I/O device of the request and starts processing
+	// Informs the I/O device of the request (starts processing if a channel is free, otherwise queues it)
 	void handle(const IORequest& req);
 
-	// Resets the state of the I/O device to not processing
+	// Resets the state of the I/O device to not processing (drops any queued requests)
 	void clear();
 
-	// Checks whether the I/O device is currently free
-	bool busy() const { return _pid != 0; }
+	// Checks whether the I/O device can't accept any more requests
+	bool busy() const { return outstanding() >= _config.queueDepth; }
+
+	// The number of requests the device is holding (in service + queued)
+	uint outstanding() const { return _active + _queue.size(); }
+
+	const IODeviceConfig& config() const { return _config; }
+
+	// Statistics
+	uint completed() const { return _completed; }
+	unsigned long long totalWait() const { return _totalWait; }	// Ticks requests spent queued on the device before service began
+	unsigned long long totalService() const { return _totalService; }
+	uint maxWait() const { return _maxWait; }
 
 	friend void exportIODevice(const IODevice& src, DeviceState& dest);
 
-private:
+protected:
+	// A request currently being serviced
+	struct Channel {
+		uint pid;
+		uint duration;
+		uint progress;
+		IORequest req;
+	};
+
 	uint8_t _id;
-	uint _pid;
-	uint _duration;
-	uint _progress;
+	IODeviceConfig _config;
+	std::mt19937 _rng;
+	uint _head;	 // The block the device last serviced (the head position, for devices that have one)
+	bool _ascending;  // The current sweep direction for IO_ELEVATOR/IO_DEADLINE
+
+	// Computes the number of ticks needed to service the request
+	virtual uint _serviceTime(const IORequest& req);
+
+	// Samples a latency from the given distribution
+	double _sample(const Distribution& dist);
+
+private:
+	std::vector<Channel> _channels;
+	std::deque<IORequest> _queue;  // Kept in submission order (IO_DEADLINE relies on the front being the oldest request)
+	uint _active;
+
+	uint _completed;
+	unsigned long long _totalWait;
+	unsigned long long _totalService;
+	uint _maxWait;
+
+	// Picks the index of the next queued request to service according to the device's scheduling policy
+	uint _pickNext();
+	// Starts servicing the given request on the given channel
+	void _start(Channel& channel, const IORequest& req);
 };
 
 void initMachine(uint8_t numCores, uint8_t numIODevices);
+// Sets up the caches and TLB of every core
+void configureCaches(const CacheConfig& config);
+// Forgets the translated blocks of every core (call whenever a program is loaded)
+void flushFusedBlocks();
 void cleanupMachine();
 
 #endif
\ No newline at end of file
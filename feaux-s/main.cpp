@@ -7,9 +7,12 @@
 
 #include "browser-api.h"
 #include "decls.h"
+#include "lottery.h"
 #include "machine.h"
 #include "os.h"
 #include "process.h"
+#include "profiler.h"
+#include "sync.h"
 #include "utils.h"
 
 #if FEAUX_S_BENCHMARKING
@@ -25,427 +28,586 @@ EM_JS(void, jssleep, (int milis), { Asyncify.handleSleep(wakeUp => { setTimeout(
 
 #define PRINT_SIZE(type) cout << #type ": " << sizeof(type) << endl
 
-// The kernel of our "OS"
-int main() {
-#if FEAUX_S_BENCHMARKING
-	for (int strategy = SchedulingStrategy::FIFO; strategy <= SchedulingStrategy::MLF; strategy++) {
-#endif
+// Runs one tick of the kernel: ticks the hardware, then has each core carry out whatever the OS needs of it next
+// Returns 1 if the kernel ended up in a state it can't recover from
+int kernelTick() {
+	// If in RT mode, check RT jobs
+	if (state->strategy == SchedulingStrategy::RT_FIFO || state->strategy == SchedulingStrategy::RT_LST ||
+		state->strategy == SchedulingStrategy::RT_EDF || state->strategy == SchedulingStrategy::RT_PEDF) {
+		PROFILE_BEGIN(PHASE_RT_RELEASE);
+		for (RTJob* job : state->jobList) {
+			if ((state->time - job->delay) % job->period == 0) {
+				releaseJob(*job);
+			}
+		}
+		PROFILE_END(PHASE_RT_RELEASE);
+	}
 
-		initMachine(2, 1);
-#if FEAUX_S_BENCHMARKING
-		initOS(machine->numCores, (SchedulingStrategy)strategy);
-#else
-	initOS(machine->numCores, SchedulingStrategy::FIFO);
-#endif
+	// Periodically boost every MLF process back to the top level (lazily, see os.cpp#highestMLFLevel)
+	if (state->strategy == SchedulingStrategy::MLF && state->mlfConfig.boostPeriod != 0 && state->time % state->mlfConfig.boostPeriod == 0) {
+		state->mlfEpoch++;
+	}
 
-#if FEAUX_S_BENCHMARKING
-		bool processesComing = true;
-#endif
+	// Tick the CPUs and I/O devices
+	for (uint8_t i = 0; i < machine->numCores; i++) {
+		PROFILE_BEGIN(PHASE_CPU_TICK);
+		machine->cores[i]->tick();
+		PROFILE_END_CORE(PHASE_CPU_TICK, i);
+	}
+	PROFILE_BEGIN(PHASE_IO_TICK);
+	for (uint8_t i = 0; i < machine->numIODevices; i++) machine->ioDevices[i]->tick();
+	PROFILE_END(PHASE_IO_TICK);
+
+	// Under global EDF/LST, decide which cores to preempt across all of them at once (and under partitioned EDF, each on its own)
+	if (state->strategy == SchedulingStrategy::RT_EDF || state->strategy == SchedulingStrategy::RT_LST ||
+		state->strategy == SchedulingStrategy::RT_PEDF) {
+		PROFILE_BEGIN(PHASE_DECIDE);
+		pickRTPreemptions();
+		PROFILE_END(PHASE_DECIDE);
+	}
 
-		while (true) {
-			if (state->paused) {
-				goto skip;	// Skip all the normal operations of the OS and just do a NOOP this tick
-			}
+	for (uint core = 0; core < machine->numCores; core++) {	 // For each core in our simulated device
+		PROFILE_BEGIN(PHASE_DECIDE);
+		PCB* runningProcess = state->runningProcess[core];	 // The currently running process on this core
 
-			// Update our current time step
-			state->time++;
+		state->stepAction[core] = StepAction::NOOP;	 // Initialize action to NOOP, update later
 
-#if FEAUX_S_BENCHMARKING
-			processesComing = simulate();
-#endif
+		if (machine->cores[core]->free()) {	 // If the core isn't running anything atm
+			// If there was an I/O request issued, but all the I/O devices at the time were busy, and there is now a device available, service
+			// that request
+			if (!state->pendingRequests.empty() && pickIODevice() != -1) {
+				state->stepAction[core] = StepAction::SERVICE_REQUEST;
+			}
 
-			// If in RT mode, check RT jobs
-			if (state->strategy == SchedulingStrategy::RT_FIFO || state->strategy == SchedulingStrategy::RT_LST ||
-				state->strategy == SchedulingStrategy::RT_EDF) {
-				for (RTJob* job : state->jobList) {
-					if ((state->time - job->delay) % job->period == 0) {
-						spawn(job->program.c_str(), state->time + job->deadline);
+			if (state->stepAction[core] == StepAction::NOOP) {	// If the core is not servicing an I/O request
+				if (!state->interrupts.empty()) {
+					state->stepAction[core] = StepAction::HANDLE_INTERRUPT;	 // handle an interrupt
+				} else {
+					switch (state->strategy) {
+						case SchedulingStrategy::FIFO:
+						case SchedulingStrategy::RT_FIFO:
+							if (!state->fifoReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::SJF:
+						case SchedulingStrategy::SJF_PREDICTED:
+							if (!state->sjfReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::SRT:
+						case SchedulingStrategy::SRT_PREDICTED:
+							if (!state->srtReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::MLF:
+							if (highestMLFLevel() != -1) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::RT_EDF:
+							if (!state->edfReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;
+								break;
+							}
+							break;
+						case SchedulingStrategy::RT_LST:
+							if (!state->lstReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;
+								break;
+							}
+							break;
+						case SchedulingStrategy::RT_PEDF:
+							if (!state->coreEDFReadyLists[core].empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;
+							}
+							break;
+						case SchedulingStrategy::CFS:
+							if (!state->cfsReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::LOTTERY:
+							if (!state->lotteryReadyList->empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						case SchedulingStrategy::STRIDE:
+							if (!state->strideReadyList.empty()) {
+								state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
+							}
+							break;
+						default:
+							cerr << "Debug: unrecognized scheduling strategy " << state->strategy << endl;
+							break;
 					}
 				}
 			}
+		} else {													  // The CPU is currently running a process
+			if (state->switchRemaining[core] > 0) {					  // The core is still paying the cost of switching to the process
+				state->stepAction[core] = StepAction::CONTEXT_SWITCH;
+				state->switchRemaining[core]--;
+			} else if (state->pendingSyscalls[core] != Syscall::SYS_NONE) {	 // The currently running process issued a syscall
+				state->stepAction[core] = StepAction::HANDLE_SYSCALL;
+			} else if (state->strategy == SchedulingStrategy::MLF) {  // Might need to reschedule if using Multi-level Feedback scheduling (if a
+																	  // process was just spawned)
+				// Check whether there exists an available core
+				bool coreAvailable = false;
+				for (uint i = 0; i < machine->numCores; i++) {
+					if (machine->cores[i]->free()) {
+						coreAvailable = true;
+						break;
+					}
+				}
+
+				if (!coreAvailable) {  // if not, then the new process (if it exists) will pre-empt the process running on this core
+					refreshMLFLevel(runningProcess);
 
-			// Tick the CPUs and I/O devices
-			for (uint8_t i = 0; i < machine->numCores; i++) machine->cores[i]->tick();
-			for (uint8_t i = 0; i < machine->numIODevices; i++) machine->ioDevices[i]->tick();
+					int level = highestMLFPriority();
+					if (level != -1 && (uint)level < runningProcess->level()) {
+						state->stepAction[core] = StepAction::BEGIN_RUN;  // If a process was found on a higher priority level than the currently
+																		  // running process, then pre-empt the process running on this core
+					}
+				}
 
-			for (uint core = 0; core < machine->numCores; core++) {	 // For each core in our simulated device
-				PCB* runningProcess = state->runningProcess[core];	 // The currently running process on this core
+				if (state->stepAction[core] != StepAction::BEGIN_RUN) {	 // If no such process was found, then continue execution
+					state->stepAction[core] = StepAction::CONTINUE_RUN;
+				}
+			} else if (state->strategy == SchedulingStrategy::CFS) {  // Might need to reschedule if using CFS (if a process that has fallen far
+																	  // enough behind in virtual runtime was just woken)
+				// Check whether there exists an available core
+				bool coreAvailable = false;
+				for (uint i = 0; i < machine->numCores; i++) {
+					if (machine->cores[i]->free()) {
+						coreAvailable = true;
+						break;
+					}
+				}
 
-				state->stepAction[core] = StepAction::NOOP;	 // Initialize action to NOOP, update later
+				if (!coreAvailable && !state->cfsReadyList.empty() &&
+					state->cfsReadyList.top()->vruntime + ((unsigned long long)CFS_WAKEUP_GRANULARITY << CFS_VRUNTIME_SHIFT) <
+						runningProcess->vruntime) {
+					state->stepAction[core] = StepAction::BEGIN_RUN;  // pre-empt the process running on this core
+				} else {
+					state->stepAction[core] = StepAction::CONTINUE_RUN;
+				}
+			} else if (state->rtPreempt[core]) {  // EDF/LST picked this core's process to make way for a ready one (see pickRTPreemptions)
+				PCB* preProc = schedule(core);
+
+				// (it takes the best ready process that may run on the core, which with affinity masks or a core busy with an interrupt may not be
+				// the one pickRTPreemptions had in mind, nor ahead of the running one)
+				if (preProc != nullptr && !rtPrecedes(preProc, runningProcess)) {
+					requeueRT(preProc);
+					preProc = nullptr;
+				}
 
-				if (machine->cores[core]->free()) {	 // If the core isn't running anything atm
-					if (!state->pendingRequests
-							 .empty()) {  // If there was an I/O request issued, but all the I/O devices at the time were busy at the time...
-						bool deviceAvailable = false;
-						for (uint i = 0; i < machine->numIODevices; i++) {
-							if (!machine->ioDevices[i]->busy()) {
-								deviceAvailable = true;
-								break;
-							}
-						}
+				if (preProc == nullptr) {
+					state->stepAction[core] = StepAction::CONTINUE_RUN;
+				} else {
+					// Reset state
+					runningProcess->state() = ready;
+					runningProcess->processorTime()++;
 
-						if (deviceAvailable) {	// If there is now a device available, service that request
-							state->stepAction[core] = StepAction::SERVICE_REQUEST;
-						}
-					}
+					// Save register state
+					Registers regstate = machine->cores[core]->regstate();
+					runningProcess->regstate = regstate;
 
-					if (state->stepAction[core] == StepAction::NOOP) {	// If the core is not servicing an I/O request
-						if (!state->interrupts.empty()) {
-							state->stepAction[core] = StepAction::HANDLE_INTERRUPT;	 // handle an interrupt
-						} else {
-							switch (state->strategy) {
-								case SchedulingStrategy::FIFO:
-								case SchedulingStrategy::RT_FIFO:
-									if (!state->fifoReadyList.empty()) {
-										state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
-									}
-									break;
-								case SchedulingStrategy::SJF:
-									if (!state->sjfReadyList.empty()) {
-										state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
-									}
-									break;
-								case SchedulingStrategy::SRT:
-									if (!state->srtReadyList.empty()) {
-										state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
-									}
-									break;
-								case SchedulingStrategy::MLF:
-									for (int i = 0; i < NUM_LEVELS; i++) {
-										if (!state->mlfLists[i].empty()) {
-											state->stepAction[core] = StepAction::BEGIN_RUN;  // start running a process
-											break;
-										}
-									}
-									break;
-								case SchedulingStrategy::RT_EDF:
-									if (!state->edfReadyList.empty()) {
-										state->stepAction[core] = StepAction::BEGIN_RUN;
-										break;
-									}
-									break;
-								case SchedulingStrategy::RT_LST:
-									if (!state->lstReadyList.empty()) {
-										state->stepAction[core] = StepAction::BEGIN_RUN;
-										break;
+					// Load preempting process (modeling no dispatch tick, only the configured context switch cost; alternatively, resetting
+					// core to no process would model an extra 1-tick dispatch)
+					requeueRT(runningProcess);
+
+					runningProcess = preProc;
+					dispatchProcess(core, preProc);
+					state->preemptions++;
+
+					// The core's tick went to the preempted process, so the preempting process is first charged on the next one
+					state->stepAction[core] = StepAction::CONTEXT_SWITCH;
+				}
+			} else {
+				state->stepAction[core] = StepAction::CONTINUE_RUN;	 // runnning process is still running
+			}
+		}
+		PROFILE_END_CORE(PHASE_DECIDE, core);
+
+		PROFILE_BEGIN(PHASE_ACTION);
+		switch (state->stepAction[core]) {
+			case StepAction::HANDLE_INTERRUPT: {
+				if (!state->interrupts.empty()) {
+					Interrupt* interrupt = state->interrupts.front();
+					state->interrupts.pop_front();
+
+					switch (interrupt->type()) {
+						case InterruptType::IO_COMPLETION: {
+							IOInterrupt* ioInterrupt = (IOInterrupt*)interrupt;
+
+							// Find the process for whom the I/O operation completed
+							auto origin = state->processTable.find(ioInterrupt->pid());
+							PCB* originProcess = origin != state->processTable.end() ? origin->second : nullptr;
+
+							if (originProcess == nullptr) {
+								cerr << "Debug, core " << core << ": unable to find origin process of IOEvent" << endl;
+								return 1;
+							} else if (ioInterrupt->handle() == 0) {  // A blocking request, so the process was waiting on it
+								originProcess->state() = ready;
+								promoteMLF(originProcess);
+								state->reentryList.push_back(originProcess);
+							} else {
+								auto pending = originProcess->pendingIO.find(ioInterrupt->handle());
+
+								if (pending != originProcess->pendingIO.end() && --pending->second == 0) {	// The last request under this handle completed
+									originProcess->pendingIO.erase(pending);
+
+									if (originProcess->state() == blocked && originProcess->waitingIOHandle == ioInterrupt->handle()) {
+										originProcess->state() = ready;
+										originProcess->waitingIOHandle = 0;
+										promoteMLF(originProcess);
+										state->reentryList.push_back(originProcess);
 									}
-									break;
-								default:
-									cerr << "Debug: unrecognized scheduling strategy " << state->strategy << endl;
-									break;
+								}
 							}
+							break;
 						}
+						default:
+							cerr << "Debug, core " << core << ": Unknown interrupt type " << interrupt->type() << endl;
+							break;
 					}
-				} else {													  // The CPU is currently running a process
-					if (state->pendingSyscalls[core] != Syscall::SYS_NONE) {  // The currently running process issued a syscall
-						state->stepAction[core] = StepAction::HANDLE_SYSCALL;
-					} else if (state->strategy == SchedulingStrategy::MLF) {  // Might need to reschedule if using Multi-level Feedback scheduling (if a
-																			  // process was just spawned)
-						// Check whether there exists an available core
-						bool coreAvailable = false;
-						for (uint i = 0; i < machine->numCores; i++) {
-							if (machine->cores[i]->free()) {
-								coreAvailable = true;
-								break;
-							}
-						}
 
-						if (!coreAvailable) {  // if not, then the new process (if it exists) will pre-empt the process running on this core
-							for (uint i = 0; i < runningProcess->level; i++) {
-								if (!state->mlfLists[i].empty()) {
-									state->stepAction[core] = StepAction::BEGIN_RUN;  // If a process was found on a higher priority level than the currently
-																					  // running process, then pre-empt the process running on this core
-									break;
-								}
-							}
-						}
+					delete interrupt;  // Free the memory allocated for this interrupt (see machine.cpp#IODevice::tick)
+				} else {
+					cerr << "Debug, core " << core << ": trying to handle nonexistent interrupt" << endl;
+					return 1;
+				}
+				break;
+			}
+			case StepAction::CONTEXT_SWITCH:
+				break;
+			case StepAction::BEGIN_RUN: {
+				PCB* proc = schedule(core);	 // Pick a process to run
+
+				if (proc != nullptr) {
+					runningProcess = proc;
+					dispatchProcess(core, runningProcess);	// Load the process's registers into the CPU, paying the context switch cost
+					break;
+				} else if (!state->pinning) {
+					cerr << "Debug, core " << core << ": Attempting to run a nonexistent process" << endl;
+					return 1;
+				} else if (runningProcess == nullptr) {	 // None of the ready processes may run on this core
+					break;
+				}
 
-						if (state->stepAction[core] != StepAction::BEGIN_RUN) {	 // If no such process was found, then continue execution
-							state->stepAction[core] = StepAction::CONTINUE_RUN;
-						}
-					} else if (state->strategy == SchedulingStrategy::RT_EDF && state->edfReadyList.top()->deadline != -1 &&
-							   (runningProcess->deadline == -1 || state->edfReadyList.top()->deadline < runningProcess->deadline)) {
+				// None of the ready processes that may run on this core can preempt its running process, which carries on
+				state->stepAction[core] = StepAction::CONTINUE_RUN;
+			}
+			// fall through
+			case StepAction::CONTINUE_RUN:
+				if (runningProcess != nullptr) {
+					runningProcess->processorTime()++;  // Tick the simulation times
+					if (state->strategy == SchedulingStrategy::MLF) {
+						refreshMLFLevel(runningProcess);
+						runningProcess->processorTimeOnLevel++;	 // Tick the simulation times
+					} else if (state->strategy == SchedulingStrategy::CFS) {
+						runningProcess->processorTimeOnLevel++;
+						runningProcess->vruntime += ((unsigned long long)NICE_0_WEIGHT << CFS_VRUNTIME_SHIFT) / runningProcess->weight;
+					} else if (state->strategy == SchedulingStrategy::LOTTERY || state->strategy == SchedulingStrategy::STRIDE) {
+						runningProcess->processorTimeOnLevel++;
+						runningProcess->pass += STRIDE_1 / runningProcess->tickets;
+					}
+
+					if (state->strategy == SchedulingStrategy::MLF						  // If we are using MLF scheduling
+						&& runningProcess->level() < state->mlfConfig.numLevels - 1	  // If the current process is not on the lowest level
+																					  // (ie. the process does have a level time limit)
+						&& runningProcess->processorTimeOnLevel >
+							   state->mlfConfig.quanta[runningProcess->level()]  // If the process has received the limit of CPU time
+					) {
 						// Reset state
-						runningProcess->state = ready;
-						runningProcess->processorTime++;
+						runningProcess->state() = ready;
+						runningProcess->level()++;
+						runningProcess->processorTimeOnLevel = 0;
 
 						// Save register state
 						Registers regstate = machine->cores[core]->regstate();
 						runningProcess->regstate = regstate;
-
-						// Load preempting process (modeling 0 context-switching time; alternatively, resetting core to no process would model 1-tick
-						// context-switching cost)
-						PCB* preProc = schedule(core);
-						state->edfReadyList.push(runningProcess);
-
-						runningProcess = preProc;
-						state->runningProcess[core] = preProc;
-						machine->cores[core]->load(preProc->regstate);
-
-						state->stepAction[core] = StepAction::CONTINUE_RUN;
-					} else if (state->strategy == SchedulingStrategy::RT_LST && state->lstReadyList.top()->deadline != -1 &&
-							   (runningProcess->deadline == -1 ||
-								// very verbose way of writing slack time
-								state->lstReadyList.top()->deadline -
-										(state->time + (state->lstReadyList.top()->reqProcessorTime - state->lstReadyList.top()->processorTime + 1)) <
-									runningProcess->deadline - (state->time + (runningProcess->reqProcessorTime - runningProcess->processorTime + 1)))) {
+						state->reentryList.push_back(runningProcess);
+
+						// Clear CPU and running process entry
+						state->runningProcess[core] = nullptr;
+						machine->cores[core]->load(NOPROC);
+					} else if ((state->strategy == SchedulingStrategy::CFS					// If we are using CFS scheduling
+								&& !state->cfsReadyList.empty()								// If there is another process waiting to run
+								&& runningProcess->processorTimeOnLevel >= cfsSlice(runningProcess))	// If the process has used up its slice
+							   || (state->strategy == SchedulingStrategy::LOTTERY && !state->lotteryReadyList->empty() &&
+								   runningProcess->processorTimeOnLevel >= PROPORTIONAL_QUANTUM)
+							   || (state->strategy == SchedulingStrategy::STRIDE && !state->strideReadyList.empty() &&
+								   runningProcess->processorTimeOnLevel >= PROPORTIONAL_QUANTUM)) {
 						// Reset state
-						runningProcess->state = ready;
-						runningProcess->processorTime++;
+						runningProcess->state() = ready;
 
 						// Save register state
 						Registers regstate = machine->cores[core]->regstate();
 						runningProcess->regstate = regstate;
+						state->reentryList.push_back(runningProcess);
 
-						// Load preempting process (modeling 0 context-switching time; alternatively, resetting core to no process would model 1-tick
-						// context-switching cost)
-						PCB* preProc = schedule(core);
-						state->lstReadyList.push(runningProcess);
-
-						runningProcess = preProc;
-						state->runningProcess[core] = preProc;
-						machine->cores[core]->load(preProc->regstate);
-
-						state->stepAction[core] = StepAction::CONTINUE_RUN;
-					} else {
-						state->stepAction[core] = StepAction::CONTINUE_RUN;	 // runnning process is still running
+						// Clear CPU and running process entry
+						state->runningProcess[core] = nullptr;
+						machine->cores[core]->load(NOPROC);
 					}
+				} else {
+					cerr << "Debug, core " << core << ": trying to run a nonexistent process" << endl;
+					return 1;
 				}
+				break;
+			case StepAction::HANDLE_SYSCALL:
+				if (runningProcess != nullptr) {
+					switch (state->pendingSyscalls[core]) {
+						case Syscall::SYS_NONE:
+							cerr << "Debug, core " << core << ": handling nonexistent syscall" << endl;
+							return 1;
+						case Syscall::SYS_IO: {
+							// Mark the process as blocked
+							runningProcess->state() = blocked;
+							runningProcess->regstate = machine->cores[core]->regstate();
+
+							submitIORequest(IORequest{runningProcess->pid, runningProcess->regstate.rdi, runningProcess->regstate.rsi, state->time, 0});
+
+							runningProcess->processorTime()++;
+							endBurst(runningProcess);
+							runningProcess = nullptr;
+							state->runningProcess[core] = nullptr;
+							machine->cores[core]->load(NOPROC);
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						}
+						case Syscall::SYS_EXIT:
+							terminateProcess(core, false);
+							runningProcess = nullptr;
+							break;
+						case Syscall::SYS_FAULT:  // Kill the process for touching memory it doesn't own
+							terminateProcess(core, true);
+							runningProcess = nullptr;
+							break;
+						case Syscall::SYS_ALLOC: {
+							uint size = machine->cores[core]->regstate().rdi, destRegister = machine->cores[core]->regstate().rsi;
+							uint address = runningProcess->addressSpace->alloc(size);  // Pages are only backed by frames once touched
+
+							uint* dest = getRegister(machine->cores[core]->_registers, (Regs)destRegister);
+							*dest = address;
+							machine->cores[core]->_registers.rax = address == 0 ? 0 : size;
+
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						}
+						case Syscall::SYS_FREE: {
+							uint address = *getRegister(machine->cores[core]->_registers, (Regs)machine->cores[core]->regstate().rdi);
 
-				switch (state->stepAction[core]) {
-					case StepAction::HANDLE_INTERRUPT: {
-						if (!state->interrupts.empty()) {
-							Interrupt* interrupt = state->interrupts.front();
-							state->interrupts.pop_front();
-
-							switch (interrupt->type()) {
-								case InterruptType::IO_COMPLETION: {
-									IOInterrupt* ioInterrupt = (IOInterrupt*)interrupt;
-
-									// Find the process for whom the I/O operation completed
-									PCB* originProcess = nullptr;
-									for (auto it = state->processList.begin(); it != state->processList.end(); it++) {
-										if ((*it)->pid == ioInterrupt->pid()) {
-											originProcess = *it;
-										}
-									}
+							machine->cores[core]->_registers.rax = runningProcess->addressSpace->free(address) ? 0 : -1;
 
-									if (originProcess == nullptr) {
-										cerr << "Debug, core " << core << ": unable to find origin process of IOEvent" << endl;
-										return 1;
-									} else {
-										originProcess->state = ready;
-										state->reentryList.push_back(originProcess);
-									}
-									break;
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						}
+						case Syscall::SYS_AIO_SUBMIT: {
+							// Submit the requests under a new handle, but let the process keep running
+							uint size = machine->cores[core]->regstate().rdi, count = machine->cores[core]->regstate().rsi;
+							uint handle = runningProcess->nextIOHandle++;
+
+							if (count > 0) {
+								runningProcess->pendingIO[handle] = count;
+								for (uint i = 0; i < count; i++) {
+									submitIORequest(IORequest{runningProcess->pid, size, NO_BLOCK, state->time, handle});
 								}
-								default:
-									cerr << "Debug, core " << core << ": Unknown interrupt type " << interrupt->type() << endl;
-									break;
 							}
+							machine->cores[core]->_registers.rax = handle;
 
-							delete interrupt;  // Free the memory allocated for this interrupt (see machine.cpp#IODevice::tick)
-						} else {
-							cerr << "Debug, core " << core << ": trying to handle nonexistent interrupt" << endl;
-							return 1;
-						}
-						break;
-					}
-					case StepAction::BEGIN_RUN:
-						runningProcess = schedule(core);  // Pick a process to run
-
-						if (runningProcess == nullptr) {
-							cerr << "Debug, core " << core << ": Attempting to run a nonexistent process" << endl;
-							return 1;
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
 						}
-
-						runningProcess->state = processing;					   // Mark the process as running
-						state->runningProcess[core] = runningProcess;		   // Keep track of the process in the OS state
-						machine->cores[core]->load(runningProcess->regstate);  // Load the process's registers into the CPU to execute the program
-						break;
-					case StepAction::CONTINUE_RUN:
-						if (runningProcess != nullptr) {
-							runningProcess->processorTime++;  // Tick the simulation times
-							if (state->strategy == SchedulingStrategy::MLF) {
-								runningProcess->processorTimeOnLevel++;	 // Tick the simulation times
+						case Syscall::SYS_AIO_POLL:
+							// 1 if all the requests under the handle have completed
+							machine->cores[core]->_registers.rax = !runningProcess->pendingIO.count(machine->cores[core]->regstate().rdi);
+
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						case Syscall::SYS_AIO_WAIT: {
+							uint handle = machine->cores[core]->regstate().rdi;
+
+							machine->cores[core]->_registers.rax = 0;
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+
+							if (runningProcess->pendingIO.count(handle)) {	// Still outstanding, so block until the last request completes
+								endBurst(runningProcess);
+								runningProcess->state() = blocked;
+								runningProcess->waitingIOHandle = handle;
+								runningProcess->regstate = machine->cores[core]->regstate();
+
+								runningProcess = nullptr;
+								state->runningProcess[core] = nullptr;
+								machine->cores[core]->load(NOPROC);
 							}
-
-							if (state->strategy == SchedulingStrategy::MLF	// If we are using MLF scheduling
-								&& runningProcess->level < NUM_LEVELS - 1	// If the current process is not on the lowest level
-																			// (ie. the process does have a level time limit)
-								&&
-								runningProcess->processorTimeOnLevel > (0b10 << runningProcess->level)	// If the process has received the limit of CPU time
-																										// (0b10 left-shifted by the level is a
-																										// tricky way of doing 2^level)
-							) {
-								// Reset state
-								runningProcess->state = ready;
-								runningProcess->level++;
-								runningProcess->processorTimeOnLevel = 0;
-
-								// Save register state
-								Registers regstate = machine->cores[core]->regstate();
-								runningProcess->regstate = regstate;
-								state->reentryList.push_back(runningProcess);
-
-								// Clear CPU and running process entry
+							break;
+						}
+						case Syscall::SYS_LOCK:
+						case Syscall::SYS_SEM_WAIT: {
+							uint id = machine->cores[core]->regstate().rdi, result = 0;
+							bool blocks = state->pendingSyscalls[core] == Syscall::SYS_LOCK ? lockMutex(runningProcess, id, result)
+																							 : waitSemaphore(runningProcess, id);
+
+							machine->cores[core]->_registers.rax = result;
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+
+							if (blocks) {  // Held/no units left, so block until it's handed over (see sync.h)
+								endBurst(runningProcess);
+								runningProcess->state() = blocked;
+								runningProcess->regstate = machine->cores[core]->regstate();
+
+								runningProcess = nullptr;
 								state->runningProcess[core] = nullptr;
 								machine->cores[core]->load(NOPROC);
 							}
-						} else {
-							cerr << "Debug, core " << core << ": trying to run a nonexistent process" << endl;
-							return 1;
+							break;
 						}
-						break;
-					case StepAction::HANDLE_SYSCALL:
-						if (runningProcess != nullptr) {
-							switch (state->pendingSyscalls[core]) {
-								case Syscall::SYS_NONE:
-									cerr << "Debug, core " << core << ": handling nonexistent syscall" << endl;
-									return 1;
-								case Syscall::SYS_IO: {
-									// Check whether there is a free I/O device to handle the request
-									int freeDevice = -1;
-									for (int i = 0; i < machine->numIODevices; i++) {
-										if (!machine->ioDevices[i]->busy()) {
-											freeDevice = i;
-											break;
-										}
-									}
+						case Syscall::SYS_UNLOCK:
+							machine->cores[core]->_registers.rax = unlockMutex(runningProcess, machine->cores[core]->regstate().rdi);
+
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						case Syscall::SYS_SEM_POST:
+							postSemaphore(machine->cores[core]->regstate().rdi);
+							machine->cores[core]->_registers.rax = 0;
+
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+						case Syscall::SYS_SEM_INIT:
+							machine->cores[core]->_registers.rax =
+								initSemaphore(machine->cores[core]->regstate().rdi, machine->cores[core]->regstate().rsi);
+
+							runningProcess->processorTime()++;
+							state->pendingSyscalls[core] = Syscall::SYS_NONE;
+							break;
+					}
+				} else {
+					cerr << "Debug, core " << core << ": No running process... somehow" << endl;
+					return 1;
+				}
+				break;
+			case StepAction::SERVICE_REQUEST: {
+				// Find the I/O device that is free
+				int freeDevice = pickIODevice();
+
+				if (freeDevice == -1) {
+					cerr << "Debug, core " << core << ": attempting to service request, but no available device" << endl;
+					return 1;
+				} else {
+					IORequest req = state->pendingRequests.front();
+					state->pendingRequests.pop();
+					machine->ioDevices[freeDevice]->handle(req);
+				}
+				break;
+			}
+			case StepAction::NOOP:
+				break;
+		}
+		PROFILE_END_ACTION(core, state->stepAction[core]);
+	}
 
-									// Mark the process as blocked
-									runningProcess->state = blocked;
-									if (freeDevice == -1) {	 // If there is no I/O device available
-										runningProcess->regstate = machine->cores[core]->regstate();
-										state->pendingRequests.push(IORequest{runningProcess->pid, (uint8_t)runningProcess->regstate.rdi});
-									} else {
-										if (state->pendingRequests.empty()) {  // If this is the only I/O request pending, just pass it to the I/O device
-											runningProcess->regstate = machine->cores[core]->regstate();
-											machine->ioDevices[freeDevice]->handle(IORequest{runningProcess->pid, (uint8_t)runningProcess->regstate.rdi});
-										} else {
-											// If there were other I/O requests made previously, save the register states and I/O request details
-											runningProcess->regstate = machine->cores[core]->regstate();
-											state->pendingRequests.push(IORequest{runningProcess->pid, (uint8_t)runningProcess->regstate.rdi});
-
-											// Service the first I/O request to be submitted
-											IORequest req = state->pendingRequests.front();
-											state->pendingRequests.pop();
-											machine->ioDevices[freeDevice]->handle(req);
-										}
-									}
+	// For all the processes that were unblocked during this step, insert them into the appropriate ready list
+	PROFILE_BEGIN(PHASE_REENTRY);
+	for (auto it = state->reentryList.begin(); it != state->reentryList.end(); it++) {
+		switch (state->strategy) {
+			case SchedulingStrategy::FIFO:
+			case SchedulingStrategy::RT_FIFO:
+				state->fifoReadyList.emplace(*it);
+				break;
+			case SchedulingStrategy::SJF:
+			case SchedulingStrategy::SJF_PREDICTED:
+				state->sjfReadyList.emplace((*it)->slot);
+				break;
+			case SchedulingStrategy::SRT:
+			case SchedulingStrategy::SRT_PREDICTED:
+				enqueueSRT(*it);
+				break;
+			case SchedulingStrategy::MLF:
+				refreshMLFLevel(*it);
+				state->mlfLists[(*it)->level()].emplace(*it);
+				break;
+			case SchedulingStrategy::RT_EDF:
+				state->edfReadyList.emplace((*it)->slot);
+				break;
+			case SchedulingStrategy::RT_LST:
+				enqueueLST(*it);
+				break;
+			case SchedulingStrategy::RT_PEDF:
+				enqueuePEDF(*it);
+				break;
+			case SchedulingStrategy::CFS:
+				enqueueCFS(*it, false);
+				break;
+			case SchedulingStrategy::LOTTERY:
+				state->lotteryReadyList->insert(*it);
+				break;
+			case SchedulingStrategy::STRIDE:
+				enqueueStride(*it);
+				break;
+		}
+	}
+	state->reentryList.clear();
+	PROFILE_END(PHASE_REENTRY);
 
-									runningProcess->processorTime++;
-									runningProcess = nullptr;
-									state->runningProcess[core] = nullptr;
-									machine->cores[core]->load(NOPROC);
-									state->pendingSyscalls[core] = Syscall::SYS_NONE;
-									break;
-								}
-								case Syscall::SYS_EXIT:
-									// Mark processs as done and save final register state
-									runningProcess->state = (runningProcess->deadline == -1 || state->time <= runningProcess->deadline) ? done : dead;
-									runningProcess->doneTime = state->time;
-									runningProcess->regstate = machine->cores[core]->regstate();
-
-									runningProcess->processorTime++;
-									runningProcess = nullptr;
-									state->runningProcess[core] = nullptr;
-									machine->cores[core]->load(NOPROC);
-									state->pendingSyscalls[core] = Syscall::SYS_NONE;
-									break;
-								case Syscall::SYS_ALLOC: {
-									uint size = machine->cores[core]->regstate().rdi, destRegister = machine->cores[core]->regstate().rsi;
-									char* memory = new char[size];
-
-									uint* dest = getRegister(machine->cores[core]->_registers, (Regs)destRegister);
-									*dest = (uint)memory;
-									machine->cores[core]->_registers.rax = size;
-
-									runningProcess->processorTime++;
-									state->pendingSyscalls[core] = Syscall::SYS_NONE;
-									break;
-								}
-								case Syscall::SYS_FREE: {
-									char* ptr = (char*)*getRegister(machine->cores[core]->_registers, (Regs)machine->cores[core]->regstate().rdi);
+	return 0;
+}
 
-									delete[] ptr;
-									machine->cores[core]->_registers.rax = 0;
+#ifndef FEAUX_S_MICROBENCHMARKING  // (the microbenchmarks drive the kernel themselves)
+// The kernel of our "OS"
+#if FEAUX_S_BENCHMARKING
+int main(int argc, char** argv) {
+	if (!startBenchmarks(argc, argv)) {
+		return 1;
+	}
 
-									runningProcess->processorTime++;
-									state->pendingSyscalls[core] = Syscall::SYS_NONE;
-									break;
-								}
-							}
-						} else {
-							cerr << "Debug, core " << core << ": No running process... somehow" << endl;
-							return 1;
-						}
-						break;
-					case StepAction::SERVICE_REQUEST: {
-						// Find the I/O device that is free
-						int freeDevice = -1;
-						for (int i = 0; i < machine->numIODevices; i++) {
-							if (!machine->ioDevices[i]->busy()) {
-								freeDevice = i;
-								break;
-							}
-						}
+	uint8_t numCores, numIODevices;
+	SchedulingStrategy strategy;
+	while (nextBenchmark(numCores, numIODevices, strategy)) {
+		initMachine(numCores, numIODevices);
+		initOS(machine->numCores, strategy);
+#else
+int main() {
+	initMachine(2, 1);
+	initOS(machine->numCores, SchedulingStrategy::FIFO);
+#endif
 
-						if (freeDevice == -1) {
-							cerr << "Debug, core " << core << ": attempting to service request, but no available device" << endl;
-							return 1;
-						} else {
-							IORequest req = state->pendingRequests.front();
-							state->pendingRequests.pop();
-							machine->ioDevices[freeDevice]->handle(req);
-						}
-						break;
-					}
-					case StepAction::NOOP:
-						break;
-				}
-			}
+#if FEAUX_S_BENCHMARKING
+		bool processesComing = true;
+#endif
 
-			// For all the processes that were unblocked during this step, insert them into the appropriate ready list
-			for (auto it = state->reentryList.begin(); it != state->reentryList.end(); it++) {
-				switch (state->strategy) {
-					case SchedulingStrategy::FIFO:
-					case SchedulingStrategy::RT_FIFO:
-						state->fifoReadyList.emplace(*it);
-						break;
-					case SchedulingStrategy::SJF:
-						state->sjfReadyList.emplace(*it);
-						break;
-					case SchedulingStrategy::SRT:
-						state->srtReadyList.emplace(*it);
-						break;
-					case SchedulingStrategy::MLF:
-						state->mlfLists[(*it)->level].emplace(*it);
-						break;
-					case SchedulingStrategy::RT_EDF:
-						state->edfReadyList.emplace(*it);
-						break;
-					case SchedulingStrategy::RT_LST:
-						state->lstReadyList.emplace(*it);
-						break;
-				}
+		while (true) {
+			if (state->paused) {
+				goto skip;	// Skip all the normal operations of the OS and just do a NOOP this tick
 			}
-			state->reentryList.clear();
+
+			// Update our current time step
+			state->time++;
 
 #if FEAUX_S_BENCHMARKING
-			if (!processesComing) {
-				bool shouldBreak = true;
+			processesComing = simulate();
+#endif
 
-				for (auto it = state->processList.begin(); it != state->processList.end(); it++) {
-					if ((*it)->state != done) {
-						shouldBreak = false;
-						break;
-					}
-				}
+			PROFILE_BEGIN(PHASE_TICK);
+			if (kernelTick() != 0) {
+				return 1;
+			}
+			PROFILE_END(PHASE_TICK);
 
-				if (shouldBreak) {
-					break;
-				}
+#if FEAUX_S_BENCHMARKING
+			if (!processesComing && state->finishedProcesses == state->processList.size()) {
+				break;
 			}
 #endif
 
@@ -462,7 +624,12 @@ int main() {
 		cleanupOS();
 		cleanupMachine();
 	}
+
+	if (!finishBenchmarks()) {
+		return 1;
+	}
 #endif
 
 	return 0;
 }
+#endif
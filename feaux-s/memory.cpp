@@ -0,0 +1,211 @@
+#include "memory.h"
+
+#include <iostream>
+
+using namespace std;
+
+PhysicalMemory::PhysicalMemory(const MemoryConfig& config)
+	: _config(config),
+	  _data(config.numFrames * PAGE_SIZE, 0),
+	  _frames(config.numFrames, Frame{nullptr, 0}),
+	  _clockHand(0),
+	  _addressSpaces(0),
+	  _minorFaults(0),
+	  _majorFaults(0),
+	  _evictions(0),
+	  _faultTicks(0) {
+	// Hand out low frames first
+	for (uint i = config.numFrames; i > 0; i--) {
+		_freeFrames.push_back(i - 1);
+	}
+}
+
+AccessResult PhysicalMemory::write(AddressSpace& space, uint vaddr, uint8_t data, uint& stall) {
+	AccessResult result;
+	uint8_t* byte = _locate(space, vaddr, result, stall);
+
+	if (byte != nullptr) {
+		*byte = data;
+		space._pageTable[(vaddr - HEAP_BASE) / PAGE_SIZE].dirty = true;
+	}
+
+	return result;
+}
+
+AccessResult PhysicalMemory::read(AddressSpace& space, uint vaddr, uint8_t& data, uint& stall) {
+	AccessResult result;
+	uint8_t* byte = _locate(space, vaddr, result, stall);
+
+	if (byte != nullptr) {
+		data = *byte;
+	}
+
+	return result;
+}
+
+uint8_t* PhysicalMemory::_locate(AddressSpace& space, uint vaddr, AccessResult& result, uint& stall) {
+	stall = 0;
+
+	if (vaddr < HEAP_BASE || (vaddr - HEAP_BASE) / PAGE_SIZE >= space._pageTable.size() ||
+		!space._pageTable[(vaddr - HEAP_BASE) / PAGE_SIZE].valid) {
+		result = ACCESS_SEGFAULT;
+		return nullptr;
+	}
+
+	uint page = (vaddr - HEAP_BASE) / PAGE_SIZE;
+
+	result = space._pageTable[page].present ? ACCESS_OK : _fault(space, page, stall);
+
+	AddressSpace::PageTableEntry& entry = space._pageTable[page];
+	entry.referenced = true;
+
+	return &_data[entry.frame * PAGE_SIZE + (vaddr - HEAP_BASE) % PAGE_SIZE];
+}
+
+AccessResult PhysicalMemory::_fault(AddressSpace& space, uint page, uint& stall) {
+	AccessResult result;
+	uint frame;
+
+	if (!_freeFrames.empty()) {
+		frame = _freeFrames.back();
+		_freeFrames.pop_back();
+	} else {
+		frame = _evict(stall);
+	}
+
+	_frames[frame] = Frame{&space, page};
+
+	AddressSpace::PageTableEntry& entry = space._pageTable[page];
+	auto swapped = space._swap.find(page);
+
+	if (swapped != space._swap.end()) {	 // The page was evicted earlier, so read it back in
+		copy(swapped->second.begin(), swapped->second.end(), _data.begin() + frame * PAGE_SIZE);
+		space._swap.erase(swapped);
+
+		entry.dirty = true;	 // The swap copy is gone, so the page must be written out again if it is evicted
+		stall += _config.majorFaultTicks;
+		_majorFaults++;
+		result = ACCESS_MAJOR_FAULT;
+	} else {
+		fill(_data.begin() + frame * PAGE_SIZE, _data.begin() + (frame + 1) * PAGE_SIZE, 0);
+
+		entry.dirty = false;
+		stall += _config.minorFaultTicks;
+		_minorFaults++;
+		result = ACCESS_MINOR_FAULT;
+	}
+
+	entry.frame = frame;
+	entry.present = true;
+	_faultTicks += stall;
+
+	return result;
+}
+
+uint PhysicalMemory::_evict(uint& stall) {
+	// Only called when there are no free frames, so every frame has an owner
+	while (true) {
+		Frame& frame = _frames[_clockHand];
+		AddressSpace::PageTableEntry& entry = frame.owner->_pageTable[frame.page];
+		uint victim = _clockHand;
+
+		_clockHand = (_clockHand + 1) % _config.numFrames;
+
+		if (entry.referenced) {	 // Give the page a second chance
+			entry.referenced = false;
+		} else {
+			if (entry.dirty) {
+				frame.owner->_swap[frame.page].assign(_data.begin() + victim * PAGE_SIZE, _data.begin() + (victim + 1) * PAGE_SIZE);
+				stall += _config.writebackTicks;
+			}
+
+			entry.present = false;
+			frame.owner = nullptr;
+			_evictions++;
+
+			return victim;
+		}
+	}
+}
+
+void PhysicalMemory::_release(AddressSpace& space, uint page) {
+	AddressSpace::PageTableEntry& entry = space._pageTable[page];
+
+	if (entry.present) {
+		_frames[entry.frame].owner = nullptr;
+		_freeFrames.push_back(entry.frame);
+		entry.present = false;
+	}
+
+	space._swap.erase(page);
+}
+
+AddressSpace::AddressSpace(PhysicalMemory* memory) : _memory(memory) { _memory->_addressSpaces++; }
+
+AddressSpace::~AddressSpace() {
+	for (uint page = 0; page < _pageTable.size(); page++) {
+		_memory->_release(*this, page);
+	}
+
+	_memory->_addressSpaces--;
+}
+
+uint AddressSpace::alloc(uint size) {
+	uint pages = size / PAGE_SIZE + (size % PAGE_SIZE != 0);
+
+	if (pages == 0 || pages > _memory->_config.maxVirtualPages - _pageTable.size()) {
+		return 0;
+	}
+
+	uint first = _pageTable.size();
+
+	_pageTable.resize(first + pages, PageTableEntry{0, true, false, false, false});
+	_allocations[first] = pages;
+
+	return HEAP_BASE + first * PAGE_SIZE;
+}
+
+bool AddressSpace::free(uint vaddr) {
+	if (vaddr < HEAP_BASE || (vaddr - HEAP_BASE) % PAGE_SIZE != 0) {
+		return false;
+	}
+
+	auto allocation = _allocations.find((vaddr - HEAP_BASE) / PAGE_SIZE);
+
+	if (allocation == _allocations.end()) {
+		return false;
+	}
+
+	for (uint page = allocation->first; page < allocation->first + allocation->second; page++) {
+		_memory->_release(*this, page);
+		_pageTable[page].valid = false;
+	}
+	_allocations.erase(allocation);
+
+	return true;
+}
+
+uint AddressSpace::residentPages() const {
+	uint resident = 0;
+
+	for (const PageTableEntry& entry : _pageTable) {
+		resident += entry.present;
+	}
+
+	return resident;
+}
+
+MemoryConfig defaultMemoryConfig() { return MemoryConfig{64, 1, 20, 20, 4096}; }
+
+void configureMemory(const MemoryConfig& config) {
+	if (machine->memory->inUse()) {
+		cerr << "Debug: attempting to reconfigure memory while processes are using it" << endl;
+		return;
+	} else if (config.numFrames == 0 || config.maxVirtualPages == 0) {
+		cerr << "Debug: attempting to configure memory with no frames or no pages per address space" << endl;
+		return;
+	}
+
+	delete machine->memory;
+	machine->memory = new PhysicalMemory(config);
+}
@@ -0,0 +1,106 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <map>
+#include <vector>
+
+#include "decls.h"
+
+#define PAGE_SIZE 256	   // Bytes per page (small, so that the simple programs we run span several pages)
+#define HEAP_BASE 0x10000  // The virtual address of the first page of every address space (so that 0 is never a valid address)
+
+// The pool of physical page frames shared by all processes
+// Frames are handed out on first touch, and when none are free the clock algorithm picks a victim to evict (dirty pages go to swap)
+class PhysicalMemory {
+public:
+	PhysicalMemory(const MemoryConfig& config);
+
+	// Writes a byte to a virtual address, faulting the page in if needed (stall is set to the extra ticks the access cost)
+	AccessResult write(AddressSpace& space, uint vaddr, uint8_t data, uint& stall);
+
+	// Reads a byte from a virtual address, faulting the page in if needed (stall is set to the extra ticks the access cost)
+	AccessResult read(AddressSpace& space, uint vaddr, uint8_t& data, uint& stall);
+
+	const MemoryConfig& config() const { return _config; }
+	uint freeFrames() const { return _freeFrames.size(); }
+	bool inUse() const { return _addressSpaces > 0; }
+
+	// Statistics
+	uint minorFaults() const { return _minorFaults; }
+	uint majorFaults() const { return _majorFaults; }
+	uint evictions() const { return _evictions; }
+	unsigned long long faultTicks() const { return _faultTicks; }
+
+	friend class AddressSpace;
+
+private:
+	// Which page is held in a frame
+	struct Frame {
+		AddressSpace* owner;  // nullptr if the frame is free
+		uint page;
+	};
+
+	MemoryConfig _config;
+	std::vector<uint8_t> _data;
+	std::vector<Frame> _frames;
+	std::vector<uint> _freeFrames;
+	uint _clockHand;
+	uint _addressSpaces;  // The number of address spaces using this memory
+
+	uint _minorFaults;
+	uint _majorFaults;
+	uint _evictions;
+	unsigned long long _faultTicks;
+
+	// Finds the byte backing a virtual address, faulting its page in if needed (nullptr on segfault)
+	uint8_t* _locate(AddressSpace& space, uint vaddr, AccessResult& result, uint& stall);
+	// Gives the page a frame, filling it from swap (major fault) or with zeroes (minor fault)
+	AccessResult _fault(AddressSpace& space, uint page, uint& stall);
+	// Picks a frame to take from its current page (clock algorithm), writing the page out to swap if it is dirty
+	uint _evict(uint& stall);
+	// Returns the frame backing the page (if any) to the free pool
+	void _release(AddressSpace& space, uint page);
+};
+
+// The virtual address space of a process
+// Allocations are whole pages, handed out in increasing address order and never reused
+class AddressSpace {
+public:
+	AddressSpace(PhysicalMemory* memory);
+	~AddressSpace();
+
+	// Reserves enough pages for the given number of bytes, returning the virtual address of the first (0 if the space is exhausted)
+	// Pages are not backed by frames until they are first touched
+	uint alloc(uint size);
+
+	// Releases an allocation (vaddr must be an address that alloc returned)
+	bool free(uint vaddr);
+
+	// The number of pages currently backed by frames
+	uint residentPages() const;
+
+	friend class PhysicalMemory;
+
+private:
+	struct PageTableEntry {
+		uint frame;
+		bool valid;		  // Part of an allocation
+		bool present;	  // Backed by a frame
+		bool referenced;  // Accessed since the clock hand last passed it
+		bool dirty;		  // Written since it was brought in (needs writing to swap on eviction)
+	};
+
+	PhysicalMemory* _memory;
+	std::vector<PageTableEntry> _pageTable;		 // Indexed by page number (relative to HEAP_BASE)
+	std::map<uint, uint> _allocations;			 // The first page of each allocation -> its number of pages
+	std::map<uint, std::vector<uint8_t>> _swap;	 // The contents of evicted dirty pages, by page number
+};
+
+// Gets the default parameters of the simulated memory
+MemoryConfig defaultMemoryConfig();
+
+// Replaces the simulated physical memory with one built from the config (only possible while no process has an address space, and with
+// at least one frame and one page per address space)
+void configureMemory(const MemoryConfig& config);
+
+#endif
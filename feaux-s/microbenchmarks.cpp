@@ -0,0 +1,297 @@
+#include "microbenchmarks.h"
+
+#if FEAUX_S_MICROBENCHMARKING
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "browser-api.h"
+#include "machine.h"
+#include "memory.h"
+#include "os.h"
+#include "process.h"
+
+using namespace std;
+
+Microbenchmark::Microbenchmark(unsigned long long iterations)
+	: _iterations(iterations), _remaining(iterations), _items(0), _started(false), _running(false), _elapsed(0) {}
+
+bool Microbenchmark::keepRunning() {
+	if (!_started) {
+		_started = true;
+		resumeTiming();
+	}
+
+	if (_remaining > 0) {
+		_remaining--;
+		return true;
+	}
+
+	pauseTiming();
+	return false;
+}
+
+void Microbenchmark::pauseTiming() {
+	if (_running) {
+		_elapsed += chrono::duration<double, nano>(Clock::now() - _start).count();
+		_running = false;
+	}
+}
+
+void Microbenchmark::resumeTiming() {
+	if (!_running) {
+		_running = true;
+		_start = Clock::now();
+	}
+}
+
+// The length of the program the CPU::tick benchmarks run through (before starting it over)
+#define TICK_PROGRAM_LENGTH 1024
+
+static const SchedulingStrategy STRATEGIES[] = {SchedulingStrategy::FIFO,	  SchedulingStrategy::SJF,	   SchedulingStrategy::SRT,
+												SchedulingStrategy::MLF,	  SchedulingStrategy::RT_EDF,  SchedulingStrategy::RT_LST,
+												SchedulingStrategy::CFS,	  SchedulingStrategy::LOTTERY, SchedulingStrategy::STRIDE};
+static const char* const STRATEGY_NAMES[] = {"FIFO", "SJF", "SRT", "MLF", "EDF", "LST", "CFS", "LOTTERY", "STRIDE"};
+
+// A tiny program for processes that only need to exist (sitting on ready lists, being exported)
+static void loadTinyProgram() {
+	Instruction tiny[2] = {{Opcode::WORK, 0, 0}, {Opcode::EXIT, 0, 0}};
+	loadProgram(tiny, 2, "tiny");
+}
+
+static void setup(uint8_t numCores, SchedulingStrategy strategy) {
+	initMachine(numCores, 1);
+	initOS(machine->numCores, strategy);
+	loadTinyProgram();
+}
+
+static void teardown() {
+	cleanupOS();
+	cleanupMachine();
+}
+
+// CPU::tick on a straight run of one instruction (register instructions run as fused blocks, as they would in a simulation)
+static void benchTick(Microbenchmark& bench, Instruction instruction) {
+	setup(1, SchedulingStrategy::FIFO);
+
+	vector<Instruction> program(TICK_PROGRAM_LENGTH, instruction);
+	program.back() = Instruction{Opcode::EXIT, 0, 0};
+	loadProgram(program.data(), program.size(), "tick");
+
+	// Run it as a process, so that SW has memory to write to (touched beforehand, so it never faults while being timed)
+	PCB* proc = state->processTable.at(spawn("tick", -1));
+	schedule(0);
+	state->runningProcess[0] = proc;
+
+	uint address = proc->addressSpace->alloc(64), stall;
+	machine->memory->write(*proc->addressSpace, address, 0, stall);
+
+	Registers start = proc->regstate;
+	start.rbx = address;
+	start.flags = FLAG_CY;	// So that JL is always taken
+	machine->cores[0]->load(start);
+
+	uint remaining = TICK_PROGRAM_LENGTH - 1;  // Ticks before reaching the EXIT
+	while (bench.keepRunning()) {
+		machine->cores[0]->tick();
+
+		if (--remaining == 0) {
+			machine->cores[0]->load(start);
+			remaining = TICK_PROGRAM_LENGTH - 1;
+		}
+	}
+
+	state->runningProcess[0] = nullptr;
+	teardown();
+}
+
+// Picking the next process and putting it back, with the given number of processes ready
+static void benchSchedule(Microbenchmark& bench, SchedulingStrategy strategy, uint ready) {
+	setup(1, strategy);
+	spawnBatch("tiny", ready, -1);
+
+	vector<PCB*> requeue(1);
+	while (bench.keepRunning()) {
+		requeue[0] = schedule(0);
+		enqueueBatch(requeue);
+	}
+
+	teardown();
+}
+
+// Spawning a process (the simulation is started over every so often, so that the ready list doesn't grow without bound)
+static void benchSpawn(Microbenchmark& bench, SchedulingStrategy strategy) {
+	uint spawned = 0;
+
+	setup(1, strategy);
+	while (bench.keepRunning()) {
+		spawn("tiny", -1);
+
+		if (++spawned % 16384 == 0) {
+			bench.pauseTiming();
+			teardown();
+			setup(1, strategy);
+			bench.resumeTiming();
+		}
+	}
+
+	teardown();
+}
+
+static void benchSpawnBatch(Microbenchmark& bench, SchedulingStrategy strategy, uint count) {
+	uint spawned = 0;
+
+	bench.setItemsPerIteration(count);
+	setup(1, strategy);
+	while (bench.keepRunning()) {
+		spawnBatch("tiny", count, -1);
+
+		if ((spawned += count) >= 65536) {
+			bench.pauseTiming();
+			teardown();
+			setup(1, strategy);
+			spawned = 0;
+			bench.resumeTiming();
+		}
+	}
+
+	teardown();
+}
+
+// A kernel tick that handles an I/O completion (waking the process that was blocked on it)
+static void benchInterrupt(Microbenchmark& bench, uint processes) {
+	setup(1, SchedulingStrategy::FIFO);
+	spawnBatch("tiny", processes, -1);
+
+	while (bench.keepRunning()) {
+		// Block the process at the front of the ready list (the tick puts it back at the end)
+		bench.pauseTiming();
+		PCB* proc = state->fifoReadyList.front();
+		state->fifoReadyList.pop();
+		proc->state() = blocked;
+		bench.resumeTiming();
+
+		handleInterrupt(new IOInterrupt(proc->pid));
+		state->time++;
+		kernelTick();
+	}
+
+	teardown();
+}
+
+// Exporting the OS state for the browser
+static void benchExport(Microbenchmark& bench, uint processes) {
+	setup(2, SchedulingStrategy::FIFO);
+	spawnBatch("tiny", processes, -1);
+
+	while (bench.keepRunning()) {
+		getOSState();
+	}
+
+	teardown();
+}
+
+static vector<MicrobenchmarkCase> microbenchmarks() {
+	static const Instruction instructions[] = {
+		{Opcode::NOP, 0, 0},		   {Opcode::WORK, 0, 0},		   {Opcode::LOAD, 7, Regs::RAX},
+		{Opcode::MOVE, Regs::RAX, Regs::RCX}, {Opcode::CMP, Regs::RAX, Regs::RCX}, {Opcode::INC, Regs::RAX, 0},
+		{Opcode::ADD, Regs::RAX, Regs::RCX},  {Opcode::SUB, Regs::RAX, Regs::RCX}, {Opcode::JL, sizeof(Instruction), 0},
+		{Opcode::SW, Regs::RAX, Regs::RBX},
+	};
+	static const char* const instructionNames[] = {"NOP", "WORK", "LOAD", "MOVE", "CMP", "INC", "ADD", "SUB", "JL", "SW"};
+	static const uint sizes[] = {16, 1024, 65536};
+	vector<MicrobenchmarkCase> cases;
+
+	for (uint i = 0; i < sizeof(instructions) / sizeof(Instruction); i++) {
+		Instruction instruction = instructions[i];
+		cases.push_back({string("CPU::tick/") + instructionNames[i], [instruction](Microbenchmark& bench) { benchTick(bench, instruction); }});
+	}
+
+	for (uint i = 0; i < sizeof(STRATEGIES) / sizeof(SchedulingStrategy); i++) {
+		SchedulingStrategy strategy = STRATEGIES[i];
+
+		for (uint size : sizes) {
+			cases.push_back({string("schedule/") + STRATEGY_NAMES[i] + "/" + to_string(size),
+							 [strategy, size](Microbenchmark& bench) { benchSchedule(bench, strategy, size); }});
+		}
+	}
+
+	for (uint i = 0; i < sizeof(STRATEGIES) / sizeof(SchedulingStrategy); i++) {
+		SchedulingStrategy strategy = STRATEGIES[i];
+
+		cases.push_back({string("spawn/") + STRATEGY_NAMES[i], [strategy](Microbenchmark& bench) { benchSpawn(bench, strategy); }});
+		cases.push_back({string("spawnBatch/") + STRATEGY_NAMES[i] + "/1024",
+						 [strategy](Microbenchmark& bench) { benchSpawnBatch(bench, strategy, 1024); }});
+	}
+
+	for (uint size : sizes) {
+		cases.push_back({"interrupt/" + to_string(size), [size](Microbenchmark& bench) { benchInterrupt(bench, size); }});
+	}
+
+	for (uint size : sizes) {
+		cases.push_back({"getOSState/" + to_string(size), [size](Microbenchmark& bench) { benchExport(bench, size); }});
+	}
+
+	return cases;
+}
+
+// Reruns the benchmark with more iterations until it takes at least the minimum time, then reports it
+static void runMicrobenchmark(const MicrobenchmarkCase& benchmark, double minTime) {
+	unsigned long long iterations = 1;
+
+	while (true) {
+		Microbenchmark bench(iterations);
+		benchmark.run(bench);
+
+		double seconds = bench.elapsedNanoseconds() / 1e9;
+		if (seconds >= minTime || iterations >= MICROBENCHMARK_MAX_ITERATIONS) {
+			double perIteration = bench.elapsedNanoseconds() / iterations;
+
+			printf("%-32s %12.1f ns %14llu", benchmark.name.c_str(), perIteration, iterations);
+			if (bench.itemsPerIteration() > 0) {
+				printf(" %10.1f ns/item", perIteration / bench.itemsPerIteration());
+			}
+			printf("\n");
+			fflush(stdout);
+			return;
+		}
+
+		// Aim a little past the minimum time (at most 10x more iterations at once, in case the first runs were dominated by noise)
+		double multiplier = seconds <= minTime / 10 ? 10 : minTime * 1.4 / seconds;
+		unsigned long long next = iterations * multiplier;
+
+		iterations = next > iterations ? next : iterations + 1;
+		if (iterations > MICROBENCHMARK_MAX_ITERATIONS) {
+			iterations = MICROBENCHMARK_MAX_ITERATIONS;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* filter = "";
+	double minTime = 0.1;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--filter=", 9) == 0) {
+			filter = argv[i] + 9;
+		} else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+			minTime = atof(argv[i] + 11);
+		} else {
+			fprintf(stderr, "Usage: %s [--filter=SUBSTRING] [--min-time=SECONDS]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("%-32s %15s %14s\n", "Benchmark", "Time", "Iterations");
+	printf("%s\n", string(63, '-').c_str());
+
+	for (const MicrobenchmarkCase& benchmark : microbenchmarks()) {
+		if (benchmark.name.find(filter) != string::npos) {
+			runMicrobenchmark(benchmark, minTime);
+		}
+	}
+
+	return 0;
+}
+#endif
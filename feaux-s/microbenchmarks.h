@@ -0,0 +1,54 @@
+#ifndef MICROBENCHMARKS_H
+#define MICROBENCHMARKS_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "decls.h"
+
+// The microbenchmarks (make run-microbench) time the simulator's hot paths in isolation, in the style of Google Benchmark: a benchmark does
+// its setup, then runs the operation being timed once per pass of `while (bench.keepRunning())`, and is rerun with more and more iterations
+// until it has run long enough to time reliably
+// Usage: feaux-s/bin/microbench [--filter=SUBSTRING] [--min-time=SECONDS]
+
+// The most iterations a benchmark is run for, however fast it is
+#define MICROBENCHMARK_MAX_ITERATIONS 1000000000ull
+
+class Microbenchmark {
+public:
+	Microbenchmark(unsigned long long iterations);
+
+	// Whether to run another iteration (the first call starts the clock, and the last stops it)
+	bool keepRunning();
+
+	// Stops/restarts the clock around work that shouldn't be timed (like resetting the simulation part way through)
+	void pauseTiming();
+	void resumeTiming();
+
+	// Sets the number of items (eg. the processes in a batch) each iteration handles, so that the time per item is reported too
+	void setItemsPerIteration(unsigned long long items) { _items = items; }
+
+	unsigned long long iterations() const { return _iterations; }
+	unsigned long long itemsPerIteration() const { return _items; }
+	double elapsedNanoseconds() const { return _elapsed; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	unsigned long long _iterations;
+	unsigned long long _remaining;
+	unsigned long long _items;	// 0 = not reported
+	bool _started;
+	bool _running;
+	Clock::time_point _start;
+	double _elapsed;
+};
+
+// A microbenchmark, by the name it's reported (and filtered) under
+struct MicrobenchmarkCase {
+	std::string name;
+	std::function<void(Microbenchmark&)> run;
+};
+
+#endif
@@ -1,7 +1,12 @@
 #include "os.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "lottery.h"
 #include "machine.h"
 #include "process.h"
+#include "sync.h"
 
 using namespace std;
 
@@ -16,6 +21,32 @@ void initOS(uint numCores, SchedulingStrategy strategy) {
 	for (uint i = 0; i < numCores; i++) state->pendingSyscalls[i] = Syscall::SYS_NONE;
 	state->runningProcess = new PCB*[numCores];
 	for (uint i = 0; i < numCores; i++) state->runningProcess[i] = nullptr;
+	state->switchRemaining = new uint[numCores];
+	for (uint i = 0; i < numCores; i++) state->switchRemaining[i] = 0;
+	state->lastProcess = new uint[numCores];
+	for (uint i = 0; i < numCores; i++) state->lastProcess[i] = 0xFFFFFFFF;  // No process has run yet
+	state->rtPreempt = new bool[numCores];
+	for (uint i = 0; i < numCores; i++) state->rtPreempt[i] = false;
+	state->switchCost = ContextSwitchConfig{0, 0, 0};
+	state->contextSwitches = 0;
+	state->preemptions = 0;
+	state->migrations = 0;
+	state->switchTicks = 0;
+	state->cfsMinVruntime = 0;
+	state->cfsReadyWeight = 0;
+	state->lotteryReadyList = new LotteryTree();
+	state->strideGlobalPass = 0;
+	state->burstPredictionError = 0;
+	state->oracleBurstError = 0;
+	state->predictedBursts = 0;
+	state->mlfConfig = defaultMLFConfig();
+	state->mlfEpoch = 0;
+	state->partitionHeuristic = PartitionHeuristic::FIRST_FIT_DECREASING;
+	state->pinning = false;
+	state->priorityInheritance = false;
+	state->syncStats = SyncStats{0, 0, 0, 0, 0, 0, 0, 0};
+	state->finishedProcesses = 0;
+	state->nextCodeAddress = CODE_BASE_ADDRESS;
 	state->time = 0;
 	state->paused = false;
 
@@ -25,12 +56,18 @@ void initOS(uint numCores, SchedulingStrategy strategy) {
 	} else {
 		state->mlfLists = nullptr;
 	}
+	if (strategy == SchedulingStrategy::RT_PEDF) {
+		state->coreEDFReadyLists.resize(numCores);
+	}
 }
 
 void cleanupOS() {
 	for (auto it = state->processList.begin(); it != state->processList.end(); it++) {
 		delete *it;
 	}
+	for (RTJob* job : state->jobList) {
+		delete job;
+	}
 
 	if (state->strategy == SchedulingStrategy::MLF) {
 		delete[] state->mlfLists;
@@ -39,80 +76,749 @@ void cleanupOS() {
 	delete[] state->stepAction;
 	delete[] state->pendingSyscalls;
 	delete[] state->runningProcess;	 // should not delete contained pointers since they are deleted when all the processes are deleted
+	delete[] state->switchRemaining;
+	delete[] state->lastProcess;
+	delete[] state->rtPreempt;
+	delete state->lotteryReadyList;
 	delete state;
 }
 
+void placeProgram(Program& program) {
+	program.codeAddress = state->nextCodeAddress;
+	state->nextCodeAddress += (program.length * sizeof(Instruction) + CODE_PAGE_SIZE - 1) / CODE_PAGE_SIZE * CODE_PAGE_SIZE;
+}
+
+// The process a ready list entry stands for (the lists ordered by the process columns hold its slot)
+template <class Entry>
+static PCB* entryProcess(Entry entry);
+template <>
+PCB* entryProcess<PCB*>(PCB* proc) {
+	return proc;
+}
+template <>
+PCB* entryProcess<uint>(uint slot) {
+	return state->columns.pcb[slot];
+}
+
+// Exposes the container under a priority queue (which the standard library keeps protected), so that a batch can be heapified in place (or
+// a FIFO ready list walked)
+template <class Queue>
+struct HeapAccess : Queue {
+	static typename Queue::container_type& container(Queue& queue) { return queue.*&HeapAccess::c; }
+};
+
+// Takes the best process that may run on the core off a ready list (nullptr if there's none)
+// The ones ahead of it that may not are set aside and put back, so it's only slower than taking the top when affinity masks get in the way
+template <class Entry, class Comparator>
+static PCB* popReady(priority_queue<Entry, vector<Entry>, Comparator>& list, uint core) {
+	static vector<Entry> skipped;
+	PCB* proc = nullptr;
+
+	skipped.clear();
+	while (proc == nullptr && !list.empty()) {
+		Entry entry = list.top();
+		list.pop();
+
+		if (!state->pinning || entryProcess(entry)->mayRunOn(core)) {
+			proc = entryProcess(entry);
+		} else {
+			skipped.push_back(entry);
+		}
+	}
+	for (Entry entry : skipped) list.push(entry);
+
+	return proc;
+}
+
+// The same for a FIFO ready list (going once around it, so that the ones passed over keep their order)
+static PCB* popReady(queue<PCB*>& list, uint core) {
+	PCB* proc = nullptr;
+
+	if (!state->pinning) {
+		if (!list.empty()) {
+			proc = list.front();
+			list.pop();
+		}
+		return proc;
+	}
+
+	for (size_t i = list.size(); i > 0; i--) {
+		PCB* next = list.front();
+		list.pop();
+
+		if (proc == nullptr && next->mayRunOn(core)) {
+			proc = next;
+		} else {
+			list.push(next);
+		}
+	}
+
+	return proc;
+}
+
+// Takes the process on the best level that may run on the core, from above the given level, off the MLF lists (nullptr if there's none)
+// For when affinity masks get in the way: the first process a core may run needn't be at the front of its list, so every list is walked
+// (the processes queued before the last boost count as being on the top level whichever list they're on, see highestMLFLevel)
+static PCB* popMLF(uint core, uint above) {
+	deque<PCB*>* best = nullptr;
+	deque<PCB*>::iterator bestAt;
+
+	for (uint i = 0; i < state->mlfConfig.numLevels; i++) {
+		deque<PCB*>& list = HeapAccess<queue<PCB*>>::container(state->mlfLists[i]);
+
+		for (auto it = list.begin(); it != list.end(); it++) {
+			uint level = (*it)->mlfEpoch != state->mlfEpoch ? 0 : (*it)->level();
+
+			if (level < above && (*it)->mayRunOn(core)) {
+				best = &list;
+				bestAt = it;
+				above = level;
+			}
+		}
+	}
+
+	if (best == nullptr) {
+		return nullptr;
+	}
+
+	PCB* proc = *bestAt;
+	best->erase(bestAt);
+	return proc;
+}
+
 PCB* schedule(uint core) {
 	switch (state->strategy) {
 		case SchedulingStrategy::FIFO:
 		case SchedulingStrategy::RT_FIFO:
-			if (!state->fifoReadyList.empty()) {
-				PCB* proc = state->fifoReadyList.front();
-				state->fifoReadyList.pop();
+			return popReady(state->fifoReadyList, core);
+		case SchedulingStrategy::SJF:
+		case SchedulingStrategy::SJF_PREDICTED:
+			return popReady(state->sjfReadyList, core);
+		case SchedulingStrategy::SRT:
+		case SchedulingStrategy::SRT_PREDICTED:
+			return popReady(state->srtReadyList, core);
+		case SchedulingStrategy::MLF: {
+			PCB* proc;
 
-				return proc;
+			if (!state->pinning) {
+				int level = highestMLFLevel();
+				proc = level != -1 ? popReady(state->mlfLists[level], core) : nullptr;
+			} else if (machine->cores[core]->free()) {
+				proc = popMLF(core, NUM_LEVELS);
+			} else {  // (a busy core only takes a process from a higher level than its running process's)
+				refreshMLFLevel(state->runningProcess[core]);
+				proc = popMLF(core, state->runningProcess[core]->level());
 			}
-			break;
-		case SchedulingStrategy::SJF:
-			if (!state->sjfReadyList.empty()) {
-				PCB* proc = state->sjfReadyList.top();
-				state->sjfReadyList.pop();
+
+			if (proc != nullptr) {
+				refreshMLFLevel(proc);
+
+				if (!machine->cores[core]->free()) {  // If the selected core is currently running a process (the case where a new process arrived and
+													  // pre-empts the currently running process of a core)
+					PCB* runningProcess = state->runningProcess[core];	// The currently running process
+
+					// Reset the states
+					refreshMLFLevel(runningProcess);
+					runningProcess->state() = ready;
+					runningProcess->processorTime()++;  // It ran this tick's instruction
+					runningProcess->processorTimeOnLevel = 0;
+					runningProcess->regstate = machine->cores[core]->regstate();  // save the CPU registers
+					state->mlfLists[runningProcess->level()].emplace(runningProcess);
+
+					// Reset the CPU
+					state->runningProcess[core] = nullptr;
+					machine->cores[core]->load(NOPROC);
+					state->preemptions++;
+				}
 
 				return proc;
 			}
 			break;
-		case SchedulingStrategy::SRT:
-			if (!state->srtReadyList.empty()) {
-				PCB* proc = state->srtReadyList.top();
-				state->srtReadyList.pop();
+		}
+		case SchedulingStrategy::RT_EDF:
+			return popReady(state->edfReadyList, core);
+		case SchedulingStrategy::RT_LST:
+			return popReady(state->lstReadyList, core);
+		case SchedulingStrategy::RT_PEDF:
+			return popReady(state->coreEDFReadyLists[core], core);
+		case SchedulingStrategy::CFS: {
+			PCB* proc = popReady(state->cfsReadyList, core);
+
+			// The process that was to preempt the running one may not run on this core, and the one that may can't preempt it
+			if (proc != nullptr && !machine->cores[core]->free() &&
+				proc->vruntime + ((unsigned long long)CFS_WAKEUP_GRANULARITY << CFS_VRUNTIME_SHIFT) >= state->runningProcess[core]->vruntime) {
+				state->cfsReadyList.push(proc);
+				proc = nullptr;
+			}
+
+			if (proc != nullptr) {
+				state->cfsReadyWeight -= proc->weight;
+
+				if (proc->vruntime > state->cfsMinVruntime) {
+					state->cfsMinVruntime = proc->vruntime;
+				}
+				proc->processorTimeOnLevel = 0;	 // Start a new slice
+
+				if (!machine->cores[core]->free()) {  // If the selected core is currently running a process (the case where a woken process
+													  // pre-empts the currently running process of a core)
+					PCB* runningProcess = state->runningProcess[core];	// The currently running process
+
+					// Reset the states
+					runningProcess->state() = ready;
+					runningProcess->processorTime()++;  // It ran this tick's instruction
+					runningProcess->regstate = machine->cores[core]->regstate();  // save the CPU registers
+					enqueueCFS(runningProcess, false);
+
+					// Reset the CPU
+					state->runningProcess[core] = nullptr;
+					machine->cores[core]->load(NOPROC);
+					state->preemptions++;
+				}
 
 				return proc;
 			}
 			break;
-		case SchedulingStrategy::MLF:
-			for (int i = 0; i < NUM_LEVELS; i++) {
-				if (!state->mlfLists[i].empty()) {
-					PCB* proc = state->mlfLists[i].front();
-					state->mlfLists[i].pop();
-
-					if (!machine->cores[core]->free()) {  // If the selected core is currently running a process (the case where a new process arrived and
-														  // pre-empts the currently running process of a core)
-						PCB* runningProcess = state->runningProcess[core];	// The currently running process
-
-						// Reset the states
-						runningProcess->state = ready;
-						runningProcess->processorTimeOnLevel = 0;
-						runningProcess->regstate = machine->cores[core]->regstate();  // save the CPU registers
-						state->mlfLists[runningProcess->level].emplace(runningProcess);
-
-						// Reset the CPU
-						state->runningProcess[core] = nullptr;
-						machine->cores[core]->load(NOPROC);
-					}
-
-					return proc;
+		}
+		case SchedulingStrategy::LOTTERY: {
+			static vector<PCB*> skipped;  // Drawn, but kept off this core by their affinity masks (put back after the draw)
+			PCB* proc = state->lotteryReadyList->draw();
+
+			skipped.clear();
+			while (proc != nullptr && state->pinning && !proc->mayRunOn(core)) {
+				skipped.push_back(proc);
+				proc = state->lotteryReadyList->draw();
+			}
+			for (PCB* skip : skipped) state->lotteryReadyList->insert(skip);
+
+			if (proc != nullptr) {
+				proc->processorTimeOnLevel = 0;	 // Start a new quantum
+			}
+			return proc;
+		}
+		case SchedulingStrategy::STRIDE: {
+			PCB* proc = popReady(state->strideReadyList, core);
+
+			if (proc != nullptr) {
+				if (proc->pass > state->strideGlobalPass) {
+					state->strideGlobalPass = proc->pass;
 				}
+				proc->processorTimeOnLevel = 0;	 // Start a new quantum
 			}
-			break;
+			return proc;
+		}
+	}
+
+	return nullptr;
+}
+
+MLFConfig defaultMLFConfig() {
+	MLFConfig config;
+
+	config.numLevels = NUM_LEVELS;
+	for (uint i = 0; i < NUM_LEVELS; i++) config.quanta[i] = 2 << i;
+	config.boostPeriod = 0;
+	config.ioPromotion = false;
+
+	return config;
+}
+
+void refreshMLFLevel(PCB* proc) {
+	if (proc->mlfEpoch != state->mlfEpoch) {
+		proc->level() = 0;
+		proc->processorTimeOnLevel = 0;
+		proc->mlfEpoch = state->mlfEpoch;
+	}
+}
+
+int highestMLFLevel() {
+	// Boosting doesn't move anything: the lists are FIFO, so any process queued before the last boost sits at the front of its list, where it
+	// counts as being on the top level (the first list is still served first, so this only approximates the order a real sweep would give)
+	for (uint i = 0; i < state->mlfConfig.numLevels; i++) {
+		if (!state->mlfLists[i].empty() && (i == 0 || state->mlfLists[i].front()->mlfEpoch != state->mlfEpoch)) {
+			return i;
+		}
+	}
+
+	for (uint i = 1; i < state->mlfConfig.numLevels; i++) {
+		if (!state->mlfLists[i].empty()) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int highestMLFPriority() {
+	int level = highestMLFLevel();
+
+	return level > 0 && state->mlfLists[level].front()->mlfEpoch != state->mlfEpoch ? 0 : level;
+}
+
+void promoteMLF(PCB* proc) {
+	if (state->strategy == SchedulingStrategy::MLF && state->mlfConfig.ioPromotion) {
+		refreshMLFLevel(proc);
+
+		if (proc->level() > 0) {
+			proc->level()--;
+			proc->processorTimeOnLevel = 0;
+		}
+	}
+}
+
+void enqueueCFS(PCB* proc, bool spawned) {
+	unsigned long long floor = state->cfsMinVruntime;
+
+	if (!spawned) {
+		unsigned long long credit = (unsigned long long)(CFS_TARGET_LATENCY / 2) << CFS_VRUNTIME_SHIFT;
+		floor = floor > credit ? floor - credit : 0;
+	}
+	if (proc->vruntime < floor) {
+		proc->vruntime = floor;
+	}
+
+	state->cfsReadyList.push(proc);
+	state->cfsReadyWeight += proc->weight;
+}
+
+void enqueueStride(PCB* proc) {
+	if (proc->pass < state->strideGlobalPass) {
+		proc->pass = state->strideGlobalPass;
+	}
+
+	state->strideReadyList.push(proc);
+}
+
+void enqueueSRT(PCB* proc) {
+	state->columns.setReadyKeys(proc->slot, proc->slot + 1, state->strategy);
+	state->srtReadyList.push(proc->slot);
+}
+
+void enqueueLST(PCB* proc) {
+	state->columns.setReadyKeys(proc->slot, proc->slot + 1, state->strategy);
+	state->lstReadyList.push(proc->slot);
+}
+
+void enqueuePEDF(PCB* proc) {
+	vector<priority_queue<uint, vector<uint>, EDFComparator>>& lists = state->coreEDFReadyLists;
+
+	if (proc->partition == -1) {
+		for (uint core = 0; core < machine->numCores; core++) {
+			if (proc->mayRunOn(core) && (proc->partition == -1 || lists[core].size() < lists[proc->partition].size())) {
+				proc->partition = core;
+			}
+		}
+	}
+
+	lists[proc->partition].push(proc->slot);
+}
+
+void requeueRT(PCB* proc) {
+	switch (state->strategy) {
 		case SchedulingStrategy::RT_EDF:
-			if (!state->edfReadyList.empty()) {
-				PCB* proc = state->edfReadyList.top();
-				state->edfReadyList.pop();
+			state->edfReadyList.push(proc->slot);
+			break;
+		case SchedulingStrategy::RT_LST:
+			enqueueLST(proc);
+			break;
+		case SchedulingStrategy::RT_PEDF:
+			enqueuePEDF(proc);
+			break;
+		default:
+			cerr << "Debug: requeueing a process under the non-RT strategy " << state->strategy << endl;
+			break;
+	}
+}
 
-				return proc;
+bool rtPrecedes(const PCB* ready, const PCB* running) {
+	if (state->strategy == SchedulingStrategy::RT_LST) {
+		return state->columns.lstKey(ready->slot) < state->columns.lstKey(running->slot);
+	}
+
+	return state->columns.edfKey(ready->slot) < state->columns.edfKey(running->slot);
+}
+
+// Restores the heap order of a ready list after the process (slot) on it moved (does nothing if it isn't on it)
+template <class Comparator>
+static void reorderReadyList(priority_queue<uint, vector<uint>, Comparator>& list, uint slot) {
+	// (a deadline only changes when a mutex changes hands, so finding the process and heapifying again is cheap enough)
+	vector<uint>& heap = HeapAccess<priority_queue<uint, vector<uint>, Comparator>>::container(list);
+
+	if (find(heap.begin(), heap.end(), slot) != heap.end()) {
+		make_heap(heap.begin(), heap.end(), Comparator());
+	}
+}
+
+void reorderRT(PCB* proc) {
+	switch (state->strategy) {
+		case SchedulingStrategy::RT_EDF:
+			reorderReadyList(state->edfReadyList, proc->slot);
+			break;
+		case SchedulingStrategy::RT_LST:
+			state->columns.setReadyKeys(proc->slot, proc->slot + 1, state->strategy);
+			reorderReadyList(state->lstReadyList, proc->slot);
+			break;
+		case SchedulingStrategy::RT_PEDF:
+			if (proc->partition != -1) {
+				reorderReadyList(state->coreEDFReadyLists[proc->partition], proc->slot);
 			}
 			break;
+		default:
+			break;
+	}
+}
+
+// What a ready list holds for a process (the lists ordered by the process columns hold its slot)
+template <class Entry>
+static Entry readyEntry(PCB* proc);
+template <>
+PCB* readyEntry<PCB*>(PCB* proc) {
+	return proc;
+}
+template <>
+uint readyEntry<uint>(PCB* proc) {
+	return proc->slot;
+}
+
+template <class Entry, class Comparator>
+static void pushBatch(priority_queue<Entry, vector<Entry>, Comparator>& list, const vector<PCB*>& procs) {
+	// Sifting in k processes costs O(k log n) and rebuilding the heap O(n + k), so only rebuild when the batch isn't tiny next to the list
+	if (procs.size() * 8 < list.size()) {
+		for (PCB* proc : procs) list.push(readyEntry<Entry>(proc));
+		return;
+	}
+
+	vector<Entry>& heap = HeapAccess<priority_queue<Entry, vector<Entry>, Comparator>>::container(list);
+	for (PCB* proc : procs) heap.push_back(readyEntry<Entry>(proc));
+	make_heap(heap.begin(), heap.end(), Comparator());
+}
+
+// Sets the ready keys of a batch in runs of consecutive slots (a spawned batch is a single run)
+static void setBatchReadyKeys(const vector<PCB*>& procs) {
+	for (size_t first = 0, last; first < procs.size(); first = last) {
+		for (last = first + 1; last < procs.size() && procs[last]->slot == procs[last - 1]->slot + 1; last++) {
+		}
+
+		state->columns.setReadyKeys(procs[first]->slot, procs[last - 1]->slot + 1, state->strategy);
+	}
+}
+
+bool hasReadyList(SchedulingStrategy strategy) {
+	switch (strategy) {
+		case SchedulingStrategy::FIFO:
+		case SchedulingStrategy::RT_FIFO:
+		case SchedulingStrategy::SJF:
+		case SchedulingStrategy::SJF_PREDICTED:
+		case SchedulingStrategy::SRT:
+		case SchedulingStrategy::SRT_PREDICTED:
+		case SchedulingStrategy::MLF:
+		case SchedulingStrategy::RT_EDF:
 		case SchedulingStrategy::RT_LST:
-			if (!state->lstReadyList.empty()) {
-				PCB* proc = state->lstReadyList.top();
-				state->lstReadyList.pop();
+		case SchedulingStrategy::RT_PEDF:
+		case SchedulingStrategy::CFS:
+		case SchedulingStrategy::LOTTERY:
+		case SchedulingStrategy::STRIDE:
+			return true;
+		default:
+			return false;
+	}
+}
 
-				return proc;
+bool enqueueBatch(const vector<PCB*>& procs) {
+	switch (state->strategy) {
+		case SchedulingStrategy::FIFO:
+		case SchedulingStrategy::RT_FIFO:
+			for (PCB* proc : procs) state->fifoReadyList.push(proc);
+			break;
+		case SchedulingStrategy::SJF:
+		case SchedulingStrategy::SJF_PREDICTED:
+			pushBatch(state->sjfReadyList, procs);
+			break;
+		case SchedulingStrategy::SRT:
+		case SchedulingStrategy::SRT_PREDICTED:
+			setBatchReadyKeys(procs);
+			pushBatch(state->srtReadyList, procs);
+			break;
+		case SchedulingStrategy::MLF:
+			for (PCB* proc : procs) state->mlfLists[0].push(proc);
+			break;
+		case SchedulingStrategy::RT_EDF:
+			pushBatch(state->edfReadyList, procs);
+			break;
+		case SchedulingStrategy::RT_LST:
+			setBatchReadyKeys(procs);
+			pushBatch(state->lstReadyList, procs);
+			break;
+		case SchedulingStrategy::RT_PEDF:
+			for (PCB* proc : procs) enqueuePEDF(proc);
+			break;
+		case SchedulingStrategy::CFS:
+			// The same placement as enqueueCFS (spawned processes start at the minimum virtual runtime)
+			for (PCB* proc : procs) {
+				if (proc->vruntime < state->cfsMinVruntime) {
+					proc->vruntime = state->cfsMinVruntime;
+				}
+				state->cfsReadyWeight += proc->weight;
 			}
+			pushBatch(state->cfsReadyList, procs);
+			break;
+		case SchedulingStrategy::LOTTERY:
+			for (PCB* proc : procs) state->lotteryReadyList->insert(proc);
 			break;
+		case SchedulingStrategy::STRIDE:
+			for (PCB* proc : procs) {
+				if (proc->pass < state->strideGlobalPass) {
+					proc->pass = state->strideGlobalPass;
+				}
+			}
+			pushBatch(state->strideReadyList, procs);
+			break;
+		default:
+			return false;
 	}
 
-	return nullptr;
+	return true;
+}
+
+bool setProcessAffinity(PCB* proc, uint64_t mask) {
+	uint64_t previous = proc->affinity;
+	bool anyCore = false, allCores = true;
+
+	proc->affinity = mask;
+	for (uint core = 0; core < machine->numCores; core++) {
+		anyCore = anyCore || proc->mayRunOn(core);
+		allCores = allCores && proc->mayRunOn(core);
+	}
+	if (!anyCore) {
+		proc->affinity = previous;
+		return false;
+	}
+	state->pinning = state->pinning || !allCores;
+
+	if (proc->partition != -1 && !proc->mayRunOn(proc->partition)) {
+		priority_queue<uint, vector<uint>, EDFComparator>& list = state->coreEDFReadyLists[proc->partition];
+		vector<uint>& heap = HeapAccess<priority_queue<uint, vector<uint>, EDFComparator>>::container(list);
+		auto it = find(heap.begin(), heap.end(), proc->slot);
+
+		proc->partition = -1;  // (one that isn't on the list is bound again when it's next put on one)
+		if (it != heap.end()) {
+			heap.erase(it);
+			make_heap(heap.begin(), heap.end(), EDFComparator());
+			enqueuePEDF(proc);
+		}
+	}
+
+	return true;
+}
+
+void partitionJobs() {
+	static vector<pair<double, RTJob*>> jobs;  // Each job with its utilization
+	static vector<double> load;				   // The utilization of the jobs on each core so far
+
+	jobs.clear();
+	for (RTJob* job : state->jobList) {
+		// Each release runs the program's instructions (cost leaves out the EXIT), and takes a tick each to dispatch it and to exit
+		jobs.emplace_back((state->programs.at(job->program).cost + 2) / (double)job->period, job);
+	}
+	stable_sort(jobs.begin(), jobs.end(), [](const pair<double, RTJob*>& a, const pair<double, RTJob*>& b) { return a.first > b.first; });
+
+	load.assign(machine->numCores, 0);
+	for (const pair<double, RTJob*>& job : jobs) {
+		int core = -1;
+		uint leastLoaded = 0;
+
+		for (uint i = 0; i < machine->numCores; i++) {
+			if (load[i] < load[leastLoaded]) {
+				leastLoaded = i;
+			}
+			if (core == -1 && state->partitionHeuristic == PartitionHeuristic::FIRST_FIT_DECREASING && load[i] + job.first <= 1) {
+				core = i;
+			}
+		}
+		if (core == -1) {  // Worst fit, or the job doesn't fit on any core
+			core = leastLoaded;
+		}
+
+		job.second->core = core;
+		load[core] += job.first;
+	}
+}
+
+// The processes (slots) at the top of a ready list, best first, without taking them off: a walk down the heap from its root that keeps the
+// frontier in a small heap of its own, so that it costs O(count log count) however long the list is
+template <class Comparator>
+static void topOfReadyList(priority_queue<uint, vector<uint>, Comparator>& list, size_t count, vector<uint>& top) {
+	const vector<uint>& heap = HeapAccess<priority_queue<uint, vector<uint>, Comparator>>::container(list);
+	Comparator comparator;
+	auto worse = [&heap, &comparator](size_t a, size_t b) { return comparator(heap[a], heap[b]); };
+	priority_queue<size_t, vector<size_t>, decltype(worse)> frontier(worse);
+
+	top.clear();
+	if (!heap.empty()) {
+		frontier.push(0);
+	}
+	while (!frontier.empty() && top.size() < count) {
+		size_t node = frontier.top();
+		frontier.pop();
+		top.push_back(heap[node]);
+
+		// (the children of a node of a standard library heap are at 2n + 1 and 2n + 2)
+		for (size_t child = 2 * node + 1; child <= 2 * node + 2 && child < heap.size(); child++) {
+			frontier.push(child);
+		}
+	}
+}
+
+void pickRTPreemptions() {
+	static vector<pair<long, uint>> running;  // The key and core of each process that could be preempted
+	static vector<uint> top;
+	bool edf = state->strategy == SchedulingStrategy::RT_EDF;
+
+	for (uint core = 0; core < machine->numCores; core++) state->rtPreempt[core] = false;
+	if (state->strategy == SchedulingStrategy::RT_PEDF) {
+		for (uint core = 0; core < machine->numCores; core++) {
+			PCB* proc = state->runningProcess[core];
+			const priority_queue<uint, vector<uint>, EDFComparator>& list = state->coreEDFReadyLists[core];
+
+			state->rtPreempt[core] = !machine->cores[core]->free() && proc != nullptr && state->switchRemaining[core] == 0 &&
+									 state->pendingSyscalls[core] == Syscall::SYS_NONE && !list.empty() &&
+									 state->columns.edfKey(list.top()) < state->columns.edfKey(proc->slot);
+		}
+		return;
+	}
+	if (!edf && state->strategy != SchedulingStrategy::RT_LST) {
+		return;
+	}
+
+	// The free cores take the best ready processes; only the running ones that aren't switching in or making a syscall can be preempted
+	uint freeCores = 0;
+	running.clear();
+	for (uint core = 0; core < machine->numCores; core++) {
+		PCB* proc = state->runningProcess[core];
+
+		if (machine->cores[core]->free()) {
+			freeCores++;
+		} else if (proc != nullptr && state->switchRemaining[core] == 0 && state->pendingSyscalls[core] == Syscall::SYS_NONE) {
+			running.emplace_back(edf ? state->columns.edfKey(proc->slot) : state->columns.lstKey(proc->slot), core);
+		}
+	}
+
+	size_t ready = edf ? state->edfReadyList.size() : state->lstReadyList.size();
+	if (running.empty() || ready <= freeCores) {
+		return;
+	}
+
+	// The latest deadline/most slack first (ties to the lowest core)
+	stable_sort(running.begin(), running.end(), [](const pair<long, uint>& a, const pair<long, uint>& b) { return a.first > b.first; });
+
+	if (edf) {
+		topOfReadyList(state->edfReadyList, freeCores + running.size(), top);
+	} else {
+		topOfReadyList(state->lstReadyList, freeCores + running.size(), top);
+	}
+
+	// Past the ones the free cores take, each ready process displaces the worst running process left, until one doesn't beat it (so the
+	// cores end up running the best processes, with as few preemptions as that takes)
+	for (size_t i = 0; i < running.size() && freeCores + i < top.size(); i++) {
+		uint slot = top[freeCores + i];
+		long key = edf ? state->columns.edfKey(slot) : state->columns.readyKey[slot];
+
+		if (key >= running[i].first) {
+			break;
+		}
+		state->rtPreempt[running[i].second] = true;
+	}
+}
+
+void endBurst(PCB* proc) {
+	long burst = proc->processorTime() - proc->burstStart;
+	Program& program = state->programs.at(proc->name);
+
+	state->burstPredictionError += fabs(proc->predictedBurst - burst);
+	state->oracleBurstError += fabs((proc->reqProcessorTime() - proc->burstStart) - burst);
+	state->predictedBursts++;
+
+	program.predictedBurst = BURST_ALPHA * burst + (1 - BURST_ALPHA) * program.predictedBurst;
+	proc->predictedBurst = program.predictedBurst;	// The next burst is predicted to be like the program's past ones
+	proc->burstStart = proc->processorTime();
+}
+
+long cfsSlice(const PCB* proc) {
+	long slice = CFS_TARGET_LATENCY * proc->weight / (state->cfsReadyWeight + proc->weight);
+
+	return slice > CFS_MIN_GRANULARITY ? slice : CFS_MIN_GRANULARITY;
+}
+
+void dispatchProcess(uint core, PCB* proc) {
+	uint extra = state->switchCost.fixedTicks + state->switchCost.registerTicks +
+				 (state->lastProcess[core] != proc->pid ? state->switchCost.cacheWarmupTicks : 0);
+
+	proc->state() = processing;					// Mark the process as running
+	state->runningProcess[core] = proc;			// Keep track of the process in the OS state
+	machine->cores[core]->load(proc->regstate);	// Load the process's registers into the CPU to execute the program
+
+	// The process only starts executing once the core has paid the extra cost
+	machine->cores[core]->stall(extra);
+	state->switchRemaining[core] = extra;
+	state->lastProcess[core] = proc->pid;
+
+	if (proc->lastCore != -1 && (uint)proc->lastCore != core) {
+		state->migrations++;
+	}
+	proc->lastCore = core;
+
+	state->contextSwitches++;
+	state->switchTicks += extra;
+}
+
+void terminateProcess(uint core, bool killed) {
+	PCB* proc = state->runningProcess[core];
+
+	releaseMutexes(proc);  // (handing them to their waiters, and giving the process its own deadline back)
+
+	// Mark the process as done and save final register state
+	proc->state() = !killed && (proc->deadline() == -1 || state->time <= proc->deadline()) ? done : dead;
+	proc->doneTime() = state->time;
+	proc->regstate = machine->cores[core]->regstate();
+	state->finishedProcesses++;
+
+	// Give the process's frames back for other processes to use
+	delete proc->addressSpace;
+	proc->addressSpace = nullptr;
+
+	proc->processorTime()++;
+	endBurst(proc);
+	state->runningProcess[core] = nullptr;
+	machine->cores[core]->load(NOPROC);
+	state->pendingSyscalls[core] = Syscall::SYS_NONE;
+}
+
+int pickIODevice() {
+	int device = -1;
+
+	for (int i = 0; i < machine->numIODevices; i++) {
+		if (!machine->ioDevices[i]->busy() && (device == -1 || machine->ioDevices[i]->outstanding() < machine->ioDevices[device]->outstanding())) {
+			device = i;
+		}
+	}
+
+	return device;
+}
+
+void submitIORequest(const IORequest& req) {
+	int freeDevice = pickIODevice();
+
+	if (freeDevice == -1) {	 // If there is no I/O device available
+		state->pendingRequests.push(req);
+	} else if (state->pendingRequests.empty()) {  // If this is the only I/O request pending, just pass it to the I/O device
+		machine->ioDevices[freeDevice]->handle(req);
+	} else {
+		// If there were other I/O requests made previously, save the I/O request details and service the first I/O request to be submitted
+		state->pendingRequests.push(req);
+
+		IORequest first = state->pendingRequests.front();
+		state->pendingRequests.pop();
+		machine->ioDevices[freeDevice]->handle(first);
+	}
 }
 
 void handleInterrupt(Interrupt* interrupt) {
@@ -2,6 +2,7 @@
 #define OS_H
 
 #include <queue>
+#include <vector>
 
 #include "decls.h"
 #include "signals.h"
@@ -11,10 +12,97 @@ void initOS(uint numCores, SchedulingStrategy strategy);
 // Clearns up the OS (deallocates memory and stuff)
 void cleanupOS();
 
+// Gives a program being loaded the next place in the simulated address space for its code (see Program::codeAddress)
+void placeProgram(Program& program);
+
 // Picks a process to execute next according to the OS scheduling strategy
+// Only processes whose affinity masks let them run on the core are picked, so with masks set it returns nullptr if none of the ready
+// processes may run there
 PCB* schedule(uint core);
 
+// Sets the cores the process may run on (see PCB::affinity)
+// Under RT_PEDF, a process bound to a core it may no longer run on is bound to another (moving to its list, if it's waiting on the old one's)
+// Returns false (leaving the mask as it was) if the mask leaves the process no core of the machine to run on
+bool setProcessAffinity(PCB* proc, uint64_t mask);
+
+// Inserts the process into the CFS ready list, placing its virtual runtime near the others' so that it neither monopolizes the CPU nor starves
+// (newly spawned processes start at the minimum; woken ones keep up to half a target latency of credit for having slept)
+void enqueueCFS(PCB* proc, bool spawned);
+// The number of ticks the process may run under CFS before yielding to the ready list (its weighted share of the target latency)
+long cfsSlice(const PCB* proc);
+
+// The default MLF parameters (6 levels with quanta of 2^(level + 1), no boosting or promotion)
+MLFConfig defaultMLFConfig();
+// Moves the process to the top MLF level if there has been a priority boost since its level was set
+void refreshMLFLevel(PCB* proc);
+// The MLF list holding the highest-priority process ready to run (processes queued before the last boost count as being on the top level,
+// wherever they sit), or -1
+int highestMLFLevel();
+// The level that process is logically on (0 if it was queued before the last boost), or -1, to compare with a running process's level
+int highestMLFPriority();
+// Moves a process that just woke from blocking I/O up a level, if the MLF config says so
+void promoteMLF(PCB* proc);
+
+// Inserts the process into the SRT/LST ready list, keyed by its remaining time/slack as it is now (see ProcessColumns::setReadyKeys)
+void enqueueSRT(PCB* proc);
+void enqueueLST(PCB* proc);
+// Inserts the process into the RT_PEDF ready list of the core it's bound to, first binding it to the core it may run on with the fewest
+// processes ready if it isn't bound to one (a process stays on its core from then on)
+void enqueuePEDF(PCB* proc);
+// Puts a process back on the ready list of the EDF/LST/PEDF strategy (eg. when it's preempted)
+void requeueRT(PCB* proc);
+// Puts a ready process back in its place on the EDF/LST/PEDF ready list after its deadline changed (by priority inheritance, see sync.h)
+// (a process that isn't on the list yet, eg. one on the reentry list, is placed when it's put on it)
+void reorderRT(PCB* proc);
+// Whether the EDF/LST/PEDF strategy runs the ready process ahead of the running one (an earlier deadline/less slack)
+bool rtPrecedes(const PCB* ready, const PCB* running);
+
+// Binds each real-time job to a core for RT_PEDF (RTJob::core), with the OS's bin-packing heuristic (see PartitionHeuristic)
+// The jobs are packed by decreasing utilization (the ticks each release keeps a core busy over the period), each onto a core it fits on
+// (one whose utilization stays at most 1) if there is one, and otherwise onto the least loaded core (the task set can't be partitioned
+// without some core being overloaded, so it's spread as evenly as it can be)
+// Called whenever a job is dispatched (binding every job again, so that the packing sees them all)
+void partitionJobs();
+
+// Inserts the process into the STRIDE ready list, moving its pass up to the smallest dispatched pass if it's behind (so that a process that
+// was blocked or just arrived can't monopolize the CPU catching up)
+void enqueueStride(PCB* proc);
+
+// Whether the scheduling strategy has a ready list (processes can only be spawned under one that does)
+bool hasReadyList(SchedulingStrategy strategy);
+
+// Puts newly spawned processes on the ready list of the scheduling strategy all at once (for a priority queue, appending them and
+// heapifying once instead of sifting each one in, when the batch isn't small next to what's already there)
+// Returns false if the strategy has no ready list to put them on
+bool enqueueBatch(const std::vector<PCB*>& procs);
+
+// Decides which cores global EDF/LST preempts this tick (state->rtPreempt): the best ready processes go to the free cores first, then
+// each of the rest displaces the running process with the latest deadline/most slack left, for as long as it has an earlier deadline/less
+// slack, so that the cores run the best processes of all with the fewest preemptions
+// Under RT_PEDF, each core is preempted if the best process on its own ready list has an earlier deadline than its running one
+// Called after the hardware has ticked, before the cores' step actions are decided
+void pickRTPreemptions();
+
+// Ends the process's current CPU burst (it blocked on I/O or exited), folding the burst into its program's prediction
+void endBurst(PCB* proc);
+
+// Starts running the process on the core, charging the context switch cost
+void dispatchProcess(uint core, PCB* proc);
+
+// Takes the process running on the core off it for good, after the instruction that exited (done, or dead if it missed its deadline) or
+// got it killed (dead): hands its mutexes on, ends its burst and gives its frames back
+void terminateProcess(uint core, bool killed);
+
+// Picks the I/O device that a new request should go to (the least loaded device that can accept it), or -1 if all are busy
+int pickIODevice();
+
+// Passes an I/O request to a device, or holds it in the pending list if all the devices are busy
+void submitIORequest(const IORequest& req);
+
 // Informs the OS that an interrupt has occured
 void handleInterrupt(Interrupt* interrupt);
 
+// Runs one tick of the kernel (the body of its main loop, in main.cpp), returning 1 if it failed
+int kernelTick();
+
 #endif
\ No newline at end of file
@@ -17,44 +17,114 @@ it should enter a blocked state for IOEvent::duration time steps.
 #include <iomanip>
 #include <iostream>
 #include <list>
+#include <map>
 #include <sstream>
 #include <vector>
 
 #include "decls.h"
+#include "memory.h"
 
 using namespace std;
 
 struct PCB {
 	PCB()
 		: pid(999999),
-		  arrivalTime(-1),
-		  deadline(-1),
-		  doneTime(-1),
-		  reqProcessorTime(0),
-		  processorTime(0),
-		  level(-1),
+		  columns(nullptr),
+		  slot(0),
 		  processorTimeOnLevel(0),
-		  state(ready),
-		  regstate(NOPROC) {}
+		  mlfEpoch(0),
+		  nice(0),
+		  weight(NICE_0_WEIGHT),
+		  vruntime(0),
+		  tickets(DEFAULT_TICKETS),
+		  lotterySlot(0),
+		  pass(0),
+		  predictedBurst(0),
+		  burstStart(0),
+		  regstate(NOPROC),
+		  nextIOHandle(1),
+		  waitingIOHandle(0),
+		  addressSpace(nullptr),
+		  pageFaults(0),
+		  pageFaultTicks(0),
+		  codeOffset(0),
+		  codeEnd(0),
+		  affinity(AFFINITY_ALL),
+		  partition(-1),
+		  lastCore(-1),
+		  waitingMutex(nullptr),
+		  blockedSince(0),
+		  inheriting(false),
+		  baseDeadline(-1) {}
+	~PCB() { delete addressSpace; }
+	PCB(const PCB&) = delete;
+	PCB& operator=(const PCB&) = delete;
+
+	// The hot scheduling fields, kept in the OS's process columns (see ProcessColumns)
+	// When the process was spawned
+	long& arrivalTime() { return columns->arrivalTime[slot]; }
+	long arrivalTime() const { return columns->arrivalTime[slot]; }
+	// The time that the process completed execution
+	long& doneTime() { return columns->doneTime[slot]; }
+	long doneTime() const { return columns->doneTime[slot]; }
+	// The deadline of the task that this process represents (absolute deadline; only used on RT schedulers)
+	long& deadline() { return columns->deadline[slot]; }
+	long deadline() const { return columns->deadline[slot]; }
+	// Total amount of processor time needed (number of instructions)
+	long& reqProcessorTime() { return columns->reqProcessorTime[slot]; }
+	long reqProcessorTime() const { return columns->reqProcessorTime[slot]; }
+	// Total amount of processor time this process has received
+	long& processorTime() { return columns->processorTime[slot]; }
+	long processorTime() const { return columns->processorTime[slot]; }
+	// The level the process is on (for MLF processing)
+	uint& level() { return columns->level[slot]; }
+	uint level() const { return columns->level[slot]; }
+	// State of the process
+	State& state() { return columns->state[slot]; }
+	State state() const { return columns->state[slot]; }
+
+	// Whether the process's affinity mask lets it run on the core
+	bool mayRunOn(uint core) const { return core >= 64 || (affinity >> core & 1); }
 
 	uint pid;					// The process ID, assigned when the process is admitted to the system
+	ProcessColumns* columns;	// The columns holding the process's hot scheduling fields (set by ProcessColumns::add)
+	uint slot;					// The process's entry in them
 	string name;				// The name of the process (same as program name)
-	long arrivalTime;			// When the process was spawned
-	long deadline;				// The deadline of the task that this process represents (absolute deadline; only used on RT schedulers)
-	long doneTime;				// The time that the process completed execution
-	long reqProcessorTime;		// Total amount of processor time needed (number of instructions)
-	long processorTime;			// Total amount of processor time this process has received
-	uint level;					// The level the process is on (for MLF processing)
-	long processorTimeOnLevel;	// The amount of CPU time the process has received on the current level (for MLF processing)
-	State state;				// State of the process
+	long processorTimeOnLevel;	// The amount of CPU time the process has received on the current level (for MLF processing; on the current slice for CFS/LOTTERY/STRIDE)
+	uint mlfEpoch;				// The boost epoch the process's level was last set in (for MLF processing)
+	int nice;					// The niceness of the process (-20 to 19; higher means a smaller share of the CPU under CFS)
+	uint weight;				// The CFS weight of the process (from its niceness)
+	unsigned long long vruntime;  // The virtual runtime of the process (CPU time scaled inversely by weight, for CFS processing)
+	uint tickets;				// The process's share of the CPU (for LOTTERY/STRIDE processing)
+	uint lotterySlot;			// The slot the process occupies in the lottery tree while it is ready (for LOTTERY processing)
+	unsigned long long pass;	// The process's pass value (CPU time scaled inversely by tickets, for STRIDE processing)
+	double predictedBurst;		// The predicted length of the process's current CPU burst (for SJF_PREDICTED/SRT_PREDICTED processing)
+	long burstStart;			// The processor time the process had when its current CPU burst began
 	Registers regstate;			// The saved state of registers of the process
+	uint nextIOHandle;			// The handle that the next asynchronous I/O submission will get
+	map<uint, uint> pendingIO;	// The number of requests still outstanding for each asynchronous I/O handle
+	uint waitingIOHandle;		// The handle the process is blocked waiting on (0 if none)
+	AddressSpace* addressSpace;	// The process's virtual memory (freed when the process exits)
+	uint pageFaults;			// The number of page faults the process has taken
+	long pageFaultTicks;		// The number of ticks the process has stalled on page faults
+	uint64_t codeOffset;		// Added to the instruction pointer to get the simulated address of the instruction (see Program::codeAddress)
+	uint64_t codeEnd;			// The instruction pointer just past the program's last instruction (the CPU doesn't fuse past it)
+	uint64_t affinity;			// The cores the process may run on (see AFFINITY_ALL; set through setAffinity)
+	int partition;				// The core whose ready list the process goes on under RT_PEDF (-1 = not bound yet, see enqueuePEDF)
+	int lastCore;				// The core the process last ran on (-1 = it hasn't run yet)
+	vector<Mutex*> heldMutexes;	// The mutexes the process holds
+	Mutex* waitingMutex;		// The mutex the process is blocked on (nullptr if none)
+	long blockedSince;			// When the process last blocked on a mutex/semaphore
+	bool inheriting;			// Whether the process's deadline was moved up by priority inheritance (see sync.h)
+	long baseDeadline;			// Its own deadline, while it is
 };
 
 struct RTJob {
-	RTJob() : period(-1), deadline(-1), delay(-1) {}
+	RTJob() : period(-1), deadline(-1), delay(-1), core(-1) {}
 
 	string program;
 	uint period;
 	uint deadline;
 	uint delay;
+	int core;  // The core the job's processes are bound to under RT_PEDF (-1 = none yet, see partitionJobs)
 };
\ No newline at end of file
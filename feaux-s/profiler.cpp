@@ -0,0 +1,141 @@
+#include "profiler.h"
+
+#ifdef FEAUX_S_PROFILING
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const char* const PHASE_NAMES[NUM_PROFILE_PHASES] = {"tick", "RT job release", "CPU::tick", "IODevice::tick", "decide", "step action",
+															"reentry"};
+static const char* const ACTION_NAMES[] = {"NOOP", "HANDLE_INTERRUPT", "BEGIN_RUN", "CONTINUE_RUN", "HANDLE_SYSCALL", "SERVICE_REQUEST",
+										   "CONTEXT_SWITCH"};
+#define NUM_ACTIONS (sizeof(ACTION_NAMES) / sizeof(const char*))
+
+struct PhaseStats {
+	unsigned long long count;
+	double total;  // ns
+	double max;
+};
+
+// A phase as a trace event
+struct TraceEvent {
+	uint8_t phase;
+	int8_t action;
+	int16_t core;
+	double start;  // ns since the first phase
+	double duration;
+};
+
+static PhaseStats phaseStats[NUM_PROFILE_PHASES], actionStats[NUM_ACTIONS];
+static Clock::time_point phaseStarts[NUM_PROFILE_PHASES], origin;
+static bool started = false;
+static vector<TraceEvent> trace;
+
+static void record(PhaseStats& stats, double duration) {
+	stats.count++;
+	stats.total += duration;
+	if (duration > stats.max) {
+		stats.max = duration;
+	}
+}
+
+void profileBegin(ProfilePhase phase) {
+	Clock::time_point now = Clock::now();
+
+	if (!started) {
+		started = true;
+		origin = now;
+	}
+	phaseStarts[phase] = now;
+}
+
+void profileEnd(ProfilePhase phase, int core, int action) {
+	Clock::time_point now = Clock::now();
+	double duration = chrono::duration<double, nano>(now - phaseStarts[phase]).count();
+
+	record(phaseStats[phase], duration);
+	if (action >= 0 && (uint)action < NUM_ACTIONS) {
+		record(actionStats[action], duration);
+	}
+
+	if (trace.size() < PROFILE_TRACE_LIMIT) {
+		trace.push_back(TraceEvent{(uint8_t)phase, (int8_t)action, (int16_t)core,
+								   chrono::duration<double, nano>(phaseStarts[phase] - origin).count(), duration});
+	}
+}
+
+static void printStats(ostream& out, const char* name, const PhaseStats& stats, double tickTotal) {
+	out << left << setw(20) << name << right << setw(12) << stats.count << setw(12) << fixed << setprecision(2) << stats.total / 1e6 << setw(10)
+		<< setprecision(1) << (stats.count > 0 ? stats.total / stats.count : 0) << setw(12) << stats.max << setw(9)
+		<< (tickTotal > 0 ? stats.total / tickTotal * 100 : 0) << "%\n";
+}
+
+void printProfile(ostream& out) {
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	double tickTotal = phaseStats[PHASE_TICK].total;
+
+	out << left << setw(20) << "Phase" << right << setw(12) << "Count" << setw(12) << "Total ms" << setw(10) << "Mean ns" << setw(12) << "Max ns"
+		<< setw(10) << "Of ticks" << "\n";
+	for (uint i = 0; i < NUM_PROFILE_PHASES; i++) {
+		printStats(out, PHASE_NAMES[i], phaseStats[i], tickTotal);
+	}
+
+	out << "\nStep actions:\n";
+	for (uint i = 0; i < NUM_ACTIONS; i++) {
+		printStats(out, ACTION_NAMES[i], actionStats[i], tickTotal);
+	}
+
+	if (trace.size() == PROFILE_TRACE_LIMIT) {
+		out << "(the trace holds only the first " << PROFILE_TRACE_LIMIT << " phases)\n";
+	}
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+bool writeProfileTrace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		cerr << "Debug: unable to create profile trace " << path << endl;
+		return false;
+	}
+
+	// Each core is a thread of its own (tid = core + 1), next to the phases of the whole machine (tid 0)
+	int maxCore = -1;
+	for (const TraceEvent& event : trace) {
+		if (event.core > maxCore) {
+			maxCore = event.core;
+		}
+	}
+
+	fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+	fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"machine\"}}");
+	for (int core = 0; core <= maxCore; core++) {
+		fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"core %d\"}}", core + 1, core);
+	}
+
+	for (const TraceEvent& event : trace) {
+		const char* name = event.action >= 0 ? ACTION_NAMES[event.action] : PHASE_NAMES[event.phase];
+
+		// Timestamps are in microseconds
+		fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}", name,
+				PHASE_NAMES[event.phase], event.start / 1000, event.duration / 1000, event.core + 1);
+	}
+
+	fprintf(file, "\n]}\n");
+	bool ok = !ferror(file);
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok) {
+		cerr << "Debug: unable to write profile trace " << path << endl;
+	}
+	return ok;
+}
+#endif
@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <ostream>
+
+#include "decls.h"
+
+// The kernel's per-tick profiler: attributes host time to each phase of a tick, and the time spent carrying out each core's step action
+// to the StepAction, to find where the simulator spends its time
+// It's compiled in only with FEAUX_S_PROFILING (make benchmarks PROFILE=1); otherwise the PROFILE_* macros expand to nothing
+// Besides the totals (printProfile), the first PROFILE_TRACE_LIMIT phases are kept as Chrome trace events (writeProfileTrace), to be
+// looked at tick by tick in a trace viewer (chrome://tracing or Perfetto)
+
+// The most phases kept for the trace
+#define PROFILE_TRACE_LIMIT (1 << 20)
+
+// The phases of a tick
+// PHASE_TICK = the whole tick (the rest are parts of it)
+// PHASE_RT_RELEASE = releasing the RT jobs due this tick
+// PHASE_CPU_TICK/PHASE_IO_TICK = ticking the cores/I/O devices
+// PHASE_DECIDE = deciding a core's step action
+// PHASE_ACTION = carrying it out
+// PHASE_REENTRY = putting the processes unblocked this tick back on the ready list
+enum ProfilePhase { PHASE_TICK, PHASE_RT_RELEASE, PHASE_CPU_TICK, PHASE_IO_TICK, PHASE_DECIDE, PHASE_ACTION, PHASE_REENTRY, NUM_PROFILE_PHASES };
+
+#ifdef FEAUX_S_PROFILING
+#define PROFILE_BEGIN(phase) profileBegin(phase)
+#define PROFILE_END(phase) profileEnd(phase)
+#define PROFILE_END_CORE(phase, core) profileEnd(phase, core)
+#define PROFILE_END_ACTION(core, action) profileEnd(PHASE_ACTION, core, action)
+#else
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define PROFILE_END_CORE(phase, core) ((void)0)
+#define PROFILE_END_ACTION(core, action) ((void)0)
+#endif
+
+// Marks the start/end of a phase (phases of different kinds may nest, but not of the same kind)
+// core = the core the phase was for (-1 = the whole machine), action = the StepAction carried out in a PHASE_ACTION
+void profileBegin(ProfilePhase phase);
+void profileEnd(ProfilePhase phase, int core = -1, int action = -1);
+
+// Writes the number of times each phase/step action ran, and the host time it took
+void printProfile(std::ostream& out);
+
+// Writes the trace as Chrome trace-event JSON
+// Returns false if the file can't be written
+bool writeProfileTrace(const char* path);
+
+#endif
@@ -17,13 +17,17 @@ protected:
 // An I/O Interrupt (signals completion of an I/O operation)
 class IOInterrupt : public Interrupt {
 public:
-	IOInterrupt(uint pid) : Interrupt(InterruptType::IO_COMPLETION), _pid(pid) {}
+	IOInterrupt(uint pid, uint handle = 0) : Interrupt(InterruptType::IO_COMPLETION), _pid(pid), _handle(handle) {}
 
 	// Gets the PID of the process for which the I/O operation completed
 	uint pid() const { return _pid; }
 
+	// Gets the completion handle of the operation (0 if the process was blocked on it)
+	uint handle() const { return _handle; }
+
 private:
 	uint _pid;
+	uint _handle;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "sync.h"
+
+#include <algorithm>
+
+#include "os.h"
+#include "process.h"
+
+using namespace std;
+
+// Whether the strategy orders processes by deadline (so that waiters are woken, and priority is inherited, by deadline)
+static bool byDeadline() {
+	return state->strategy == SchedulingStrategy::RT_EDF || state->strategy == SchedulingStrategy::RT_LST ||
+		   state->strategy == SchedulingStrategy::RT_PEDF;
+}
+
+// Whether deadline a comes before deadline b (-1 = no deadline, which comes after any other)
+static bool earlier(long a, long b) { return a != -1 && (b == -1 || a < b); }
+
+static void block(PCB* proc, list<PCB*>& waiters) {
+	proc->blockedSince = state->time;
+	waiters.push_back(proc);
+}
+
+// Takes the waiter to hand the mutex/semaphore to off the wait queue, and wakes it
+static PCB* wakeNext(list<PCB*>& waiters) {
+	auto next = waiters.begin();
+
+	if (byDeadline()) {
+		for (auto it = waiters.begin(); it != waiters.end(); it++) {
+			if (earlier((*it)->deadline(), (*next)->deadline())) {
+				next = it;
+			}
+		}
+	}
+
+	PCB* proc = *next;
+	waiters.erase(next);
+	proc->state() = ready;
+	state->reentryList.push_back(proc);
+	return proc;
+}
+
+// Gives a mutex owner the earliest of its own deadline and those of the processes blocked on its mutexes, then does the same for the owner
+// of the mutex it's blocked on (if any), for as long as the deadlines change
+// (a cycle of processes blocked on each other's mutexes ends up with them all on its earliest deadline, so this always stops)
+void refreshInheritance(PCB* proc) {
+	bool inherit = state->priorityInheritance && byDeadline();
+
+	while (proc != nullptr && (inherit || proc->inheriting)) {
+		long own = proc->inheriting ? proc->baseDeadline : proc->deadline(), deadline = own;
+
+		if (inherit) {
+			for (Mutex* mutex : proc->heldMutexes) {
+				for (PCB* waiter : mutex->waiters) {
+					if (earlier(waiter->deadline(), deadline)) {
+						deadline = waiter->deadline();
+					}
+				}
+			}
+		}
+
+		proc->inheriting = deadline != own;
+		proc->baseDeadline = own;
+		if (deadline == proc->deadline()) {
+			return;
+		}
+
+		if (earlier(deadline, proc->deadline())) {
+			state->syncStats.inheritances++;
+		}
+		proc->deadline() = deadline;
+		if (proc->state() == ready) {
+			reorderRT(proc);
+		}
+
+		proc = proc->waitingMutex != nullptr ? proc->waitingMutex->owner : nullptr;
+	}
+}
+
+static void take(PCB* proc, Mutex& mutex) {
+	mutex.owner = proc;
+	mutex.acquiredAt = state->time;
+	proc->heldMutexes.push_back(&mutex);
+	state->syncStats.lockAcquisitions++;
+}
+
+static void release(PCB* proc, Mutex& mutex) {
+	state->syncStats.lockHoldTicks += state->time - mutex.acquiredAt;
+	proc->heldMutexes.erase(find(proc->heldMutexes.begin(), proc->heldMutexes.end(), &mutex));
+	mutex.owner = nullptr;
+
+	if (!mutex.waiters.empty()) {
+		PCB* next = wakeNext(mutex.waiters);
+		uint waited = state->time - next->blockedSince;
+
+		state->syncStats.lockWaitTicks += waited;
+		state->syncStats.maxLockWait = max(state->syncStats.maxLockWait, waited);
+		next->waitingMutex = nullptr;
+		take(next, mutex);
+		refreshInheritance(next);  // (it may inherit from the waiters left)
+	}
+
+	refreshInheritance(proc);
+}
+
+bool lockMutex(PCB* proc, uint id, uint& result) {
+	Mutex& mutex = state->mutexes[id];
+
+	mutex.id = id;
+	result = 0;
+	if (mutex.owner == proc) {
+		result = -1;
+		return false;
+	} else if (mutex.owner == nullptr) {
+		take(proc, mutex);
+		return false;
+	}
+
+	state->syncStats.contendedLocks++;
+	proc->waitingMutex = &mutex;
+	block(proc, mutex.waiters);
+	refreshInheritance(mutex.owner);
+	return true;
+}
+
+uint unlockMutex(PCB* proc, uint id) {
+	auto it = state->mutexes.find(id);
+
+	if (it == state->mutexes.end() || it->second.owner != proc) {
+		return -1;
+	}
+
+	release(proc, it->second);
+	return 0;
+}
+
+void releaseMutexes(PCB* proc) {
+	while (!proc->heldMutexes.empty()) {
+		release(proc, *proc->heldMutexes.back());
+	}
+}
+
+bool waitSemaphore(PCB* proc, uint id) {
+	Semaphore& semaphore = state->semaphores[id];
+
+	if (semaphore.count > 0) {
+		semaphore.count--;
+		return false;
+	}
+
+	state->syncStats.semaphoreWaits++;
+	block(proc, semaphore.waiters);
+	return true;
+}
+
+void postSemaphore(uint id) {
+	Semaphore& semaphore = state->semaphores[id];
+
+	if (semaphore.waiters.empty()) {
+		semaphore.count++;
+		return;
+	}
+
+	PCB* next = wakeNext(semaphore.waiters);
+	state->syncStats.semaphoreWaitTicks += state->time - next->blockedSince;
+}
+
+uint initSemaphore(uint id, uint count) {
+	Semaphore& semaphore = state->semaphores[id];
+
+	if (!semaphore.waiters.empty()) {
+		return -1;
+	}
+
+	semaphore.count = count;
+	return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include "decls.h"
+
+// The kernel's mutexes and counting semaphores, behind the LOCK/UNLOCK and SEMINIT/SEMWAIT/SEMPOST syscalls
+// Each is named by an id, and made the first time a process uses it (a semaphore starting with a count of 0, unless SEMINIT gives it one)
+// A process that has to wait is blocked on the mutex/semaphore's wait queue, and when it's released it's handed straight to one of the
+// waiters (so it can't be taken in between), which goes back on the ready list through the reentry list, like a process whose I/O completed
+// Under EDF/LST/PEDF, the waiter with the earliest deadline is woken first; under the other strategies, the one that has waited longest
+// With priority inheritance on (OSState::priorityInheritance), a mutex's owner under EDF/LST/PEDF runs with the earliest deadline of the
+// processes blocked on the mutexes it holds (and, through them, of the processes blocked on theirs), so that processes with later deadlines
+// than its waiters can't keep it from releasing the mutex (priority inversion); it gets its own deadline back once they're no longer waiting
+
+// Takes the mutex for the process, or blocks it until the mutex is handed to it
+// result is 0, or -1 if the process already holds the mutex
+// Returns whether the process blocked (the caller takes it off its core)
+bool lockMutex(PCB* proc, uint id, uint& result);
+
+// Releases a mutex the process holds, handing it to the next waiter (if any)
+// Returns 0, or -1 if the process doesn't hold the mutex
+uint unlockMutex(PCB* proc, uint id);
+
+// Releases every mutex the process holds (when it exits or is killed)
+void releaseMutexes(PCB* proc);
+
+// Takes a unit of the semaphore for the process, or blocks it until a unit is handed to it
+// Returns whether the process blocked (the caller takes it off its core)
+bool waitSemaphore(PCB* proc, uint id);
+
+// Gives a unit of the semaphore back, handing it to the next waiter (if any)
+void postSemaphore(uint id);
+
+// Gives the mutex owner the deadline priority inheritance calls for as things stand (eg. after it was turned on or off)
+void refreshInheritance(PCB* proc);
+
+// Sets the count of the semaphore
+// Returns 0, or -1 (leaving the count as it was) if processes are blocked on it
+uint initSemaphore(uint id, uint count);
+
+#endif
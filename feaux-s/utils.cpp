@@ -7,26 +7,36 @@ using namespace std;
 void exportProcess(const PCB& src, ProcessCompat& dest) {
 	dest.pid = src.pid;
 	dest.name = src.name.c_str();
-	dest.arrivalTime = src.arrivalTime;
-	dest.deadline = src.deadline;
-	dest.doneTime = src.doneTime;
-	dest.reqProcessorTime = src.reqProcessorTime;
-	dest.processorTime = src.processorTime;
-	dest.level = src.level;
+	dest.arrivalTime = src.arrivalTime();
+	dest.deadline = src.deadline();
+	dest.doneTime = src.doneTime();
+	dest.reqProcessorTime = src.reqProcessorTime();
+	dest.processorTime = src.processorTime();
+	dest.level = src.level();
 	dest.processorTimeOnLevel = src.processorTimeOnLevel;
-	dest.state = src.state;
+	dest.state = src.state();
 	dest.regstate = src.regstate;
 }
 
 void exportCPU(const CPU& src, CPUState& dest) {
 	dest.available = src.free();
-	dest.regstate = src._registers;
+	dest.regstate = src.regstate();
 }
 
 void exportIODevice(const IODevice& src, DeviceState& dest) {
-	dest.pid = src._pid;
-	dest.duration = src._duration;
-	dest.progress = src._progress;
+	// The compatibility layer only knows about one request per device, so export the first channel that is servicing one
+	dest.pid = 0;
+	dest.duration = 0;
+	dest.progress = 0;
+
+	for (const IODevice::Channel& channel : src._channels) {
+		if (channel.pid != 0) {
+			dest.pid = channel.pid;
+			dest.duration = channel.duration;
+			dest.progress = channel.progress;
+			break;
+		}
+	}
 }
 
 void exportInterrupt(const Interrupt& src, InterruptCompat& dest) {
@@ -0,0 +1,199 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+#include "browser-api.h"
+#include "machine.h"
+
+using namespace std;
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& config)
+	: _config(config), _rng(config.seed), _traceCursor(0), _nextArrival(0), _bursting(false), _generated(0) {
+	_nextArrival = _gap();
+}
+
+void WorkloadGenerator::addProgram(const char* name, uint weight) {
+	_programs.push_back(name);
+	_cumulativeWeights.push_back((_cumulativeWeights.empty() ? 0 : _cumulativeWeights.back()) + weight);
+	_counts.push_back(0);
+}
+
+uint WorkloadGenerator::_programIndex(const string& name) {
+	for (uint i = 0; i < _programs.size(); i++) {
+		if (_programs[i] == name) {
+			return i;
+		}
+	}
+
+	addProgram(name.c_str(), 0);
+	return _programs.size() - 1;
+}
+
+// Reads an (optionally negative) integer field, returning false if it isn't one
+static bool parseField(const string& field, long& value) {
+	const char* start = field.c_str();
+	char* end;
+
+	value = strtol(start, &end, 10);
+	while (*end == ' ' || *end == '\t' || *end == '\r') end++;
+	return end != start && *end == '\0';
+}
+
+bool WorkloadGenerator::loadTrace(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		cerr << "Debug: unable to open workload trace " << path << endl;
+		return false;
+	}
+
+	string contents;
+	char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) contents.append(buffer, read);
+	fclose(file);
+
+	uint line = 0;
+	for (size_t start = 0; start < contents.size();) {
+		size_t end = contents.find('\n', start);
+		if (end == string::npos) {
+			end = contents.size();
+		}
+
+		string text = contents.substr(start, end - start);
+		start = end + 1;
+		line++;
+
+		// Split the line into its fields (trimming the spaces around each)
+		vector<string> fields;
+		for (size_t from = 0; from <= text.size();) {
+			size_t comma = min(text.find(',', from), text.size());
+			string field = text.substr(from, comma - from);
+			size_t first = field.find_first_not_of(" \t\r"), last = field.find_last_not_of(" \t\r");
+
+			fields.push_back(first == string::npos ? "" : field.substr(first, last - first + 1));
+			from = comma + 1;
+		}
+
+		if (fields[0].empty() || fields[0][0] < '0' || fields[0][0] > '9') {	// A header, comment or blank line
+			continue;
+		}
+
+		TraceArrival arrival;
+		long time, deadline = -1, nice = 0, tickets = 0;
+		bool valid = fields.size() >= 2 && fields.size() <= 5 && parseField(fields[0], time) && time >= 0 && !fields[1].empty() &&
+					 (fields.size() < 3 || fields[2].empty() || parseField(fields[2], deadline)) &&
+					 (fields.size() < 4 || fields[3].empty() || parseField(fields[3], nice)) &&
+					 (fields.size() < 5 || fields[4].empty() || (parseField(fields[4], tickets) && tickets >= 0));
+
+		if (!valid) {
+			cerr << "Debug: malformed arrival on line " << line << " of workload trace " << path << endl;
+			return false;
+		}
+
+		arrival.time = time;
+		arrival.program = _programIndex(fields[1]);
+		arrival.deadline = deadline < 0 ? -1 : deadline;
+		arrival.nice = nice;
+		arrival.tickets = tickets;
+		_trace.push_back(arrival);
+	}
+
+	// Keep arrivals on the same tick in the order they're listed (so that they spawn, and get their pids, in that order)
+	stable_sort(_trace.begin(), _trace.end(), [](const TraceArrival& a, const TraceArrival& b) { return a.time < b.time; });
+	_traceCursor = 0;
+	return true;
+}
+
+double WorkloadGenerator::_gap() {
+	double rate = _bursting ? _config.burstRate : _config.rate;
+
+	if (rate <= 0) {
+		return numeric_limits<double>::infinity();
+	}
+
+	return sampleExponential(_rng) / rate;
+}
+
+uint WorkloadGenerator::_pickProgram() {
+	uint ticket = sampleBelow(_rng, _cumulativeWeights.back());
+
+	return upper_bound(_cumulativeWeights.begin(), _cumulativeWeights.end(), ticket) - _cumulativeWeights.begin();
+}
+
+uint WorkloadGenerator::_arriveTrace(uint time) {
+	uint spawned = 0;
+
+	// Spawn each run of identical arrivals on this tick as one batch
+	while (_traceCursor < _trace.size() && _trace[_traceCursor].time <= time) {
+		const TraceArrival& first = _trace[_traceCursor];
+		uint count = 1;
+
+		while (_traceCursor + count < _trace.size()) {
+			const TraceArrival& next = _trace[_traceCursor + count];
+
+			if (next.time != first.time || next.program != first.program || next.deadline != first.deadline || next.nice != first.nice ||
+				next.tickets != first.tickets) {
+				break;
+			}
+			count++;
+		}
+
+		if (spawnBatch(_programs[first.program].c_str(), count, first.deadline, first.nice, first.tickets) != (uint)-1) {
+			spawned += count;
+		}
+		_traceCursor += count;
+	}
+
+	_generated += spawned;
+	return spawned;
+}
+
+uint WorkloadGenerator::arrive(uint time) {
+	if (_config.arrivals == ARRIVALS_TRACE) {
+		return _arriveTrace(time);
+	}
+
+	if (time > _config.until || _cumulativeWeights.empty() || _cumulativeWeights.back() == 0) {
+		return 0;
+	}
+
+	if (_config.arrivals == ARRIVALS_MMPP) {
+		bool bursting = _bursting ? sampleUniform(_rng) >= _config.burstEnd : sampleUniform(_rng) < _config.burstStart;
+
+		// The gaps are memoryless, so the next arrival can simply be drawn again at the new rate
+		if (bursting != _bursting) {
+			_bursting = bursting;
+			_nextArrival = (time - 1) + _gap();
+		}
+	}
+
+	// This tick covers the arrivals in (time - 1, time]
+	uint arrivals = 0;
+	while (_nextArrival <= time) {
+		_counts[_pickProgram()]++;
+		arrivals++;
+		_nextArrival += _gap();
+	}
+
+	for (uint i = 0; i < _programs.size(); i++) {
+		if (_counts[i] > 0) {
+			spawnBatch(_programs[i].c_str(), _counts[i], _config.deadline);
+			_counts[i] = 0;
+		}
+	}
+
+	_generated += arrivals;
+	return arrivals;
+}
+
+bool WorkloadGenerator::done(uint time) const {
+	if (_config.arrivals == ARRIVALS_TRACE) {
+		return _traceCursor == _trace.size();
+	}
+
+	return time >= _config.until;
+}
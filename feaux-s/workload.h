@@ -0,0 +1,84 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "decls.h"
+
+// The ways a workload's arrivals can be generated
+// ARRIVALS_POISSON = a Poisson process (exponentially distributed gaps between arrivals) at a fixed rate
+// ARRIVALS_MMPP = a two-state Markov-modulated Poisson process: a Poisson process at the base rate that switches into bursts at the burst rate
+//                 (each tick, a burst starts with probability burstStart, and a running one ends with probability burstEnd)
+// ARRIVALS_TRACE = the arrivals listed in a trace file (see WorkloadGenerator::loadTrace)
+enum ArrivalProcess { ARRIVALS_POISSON, ARRIVALS_MMPP, ARRIVALS_TRACE };
+
+struct WorkloadConfig {
+	ArrivalProcess arrivals;
+	double rate;		 // The mean number of arrivals per tick
+	double burstRate;	 // The mean number of arrivals per tick during a burst (MMPP)
+	double burstStart;	 // The chance of a burst starting on each tick (MMPP)
+	double burstEnd;	 // The chance of a burst ending on each tick (MMPP)
+	uint deadline;		 // The relative deadline of each generated process (-1 = none)
+	uint until;			 // The last tick to generate arrivals on (traces end with their last arrival)
+	uint seed;			 // Seed for the generator's random number generator (so that workloads are repeatable)
+};
+
+// Generates the arrivals of a workload, spawning each tick's arrivals in batches (one spawnBatch per program, so they go onto the ready list
+// together)
+// Generated arrivals run a program picked at random in proportion to its weight
+class WorkloadGenerator {
+public:
+	WorkloadGenerator(const WorkloadConfig& config);
+
+	// Adds a program to the mix that generated arrivals pick from
+	void addProgram(const char* name, uint weight);
+
+	// Reads the arrivals of an ARRIVALS_TRACE workload from a CSV file, one per line:
+	//   time,program[,deadline[,nice[,tickets]]]
+	// (deadline is relative to the arrival, -1 or missing = none; lines that don't start with a time, like a header, are skipped)
+	// Returns false if the file can't be read or has a malformed line
+	bool loadTrace(const char* path);
+
+	// Spawns the processes arriving on the given tick (call it once per tick, in order)
+	// Returns the number of processes spawned
+	uint arrive(uint time);
+
+	// Whether every arrival has been spawned by the given tick
+	bool done(uint time) const;
+
+	// The number of processes spawned so far
+	unsigned long long generated() const { return _generated; }
+
+private:
+	// An arrival read from a trace
+	struct TraceArrival {
+		uint time;
+		uint program;  // Index into _programs
+		uint deadline;
+		int nice;
+		uint tickets;
+	};
+
+	WorkloadConfig _config;
+	std::mt19937 _rng;
+	std::vector<std::string> _programs;
+	std::vector<uint> _cumulativeWeights;  // The running total of the programs' weights, for picking one by binary search
+	std::vector<uint> _counts;			   // The arrivals of each program on the current tick
+	std::vector<TraceArrival> _trace;	   // Sorted by time
+	uint _traceCursor;					   // The next arrival of the trace to spawn
+	double _nextArrival;				   // The (fractional) time of the next generated arrival
+	bool _bursting;
+	unsigned long long _generated;
+
+	// The index of the program with the given name (adding it with no weight if it isn't in the mix)
+	uint _programIndex(const std::string& name);
+	// Samples the gap until the next arrival at the current rate
+	double _gap();
+	// Picks the program of a generated arrival
+	uint _pickProgram();
+	uint _arriveTrace(uint time);
+};
+
+#endif
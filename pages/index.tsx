@@ -41,7 +41,8 @@ const Index: NextPage = () => {
 	const [menuItems, setMenuItems] = useState<MenuItem[]>([]);
 
 	const rt = useMemo(
-		() => [SchedulingStrategy.RT_FIFO, SchedulingStrategy.RT_EDF, SchedulingStrategy.RT_LST].includes(schedulingStrategy),
+		() =>
+			[SchedulingStrategy.RT_FIFO, SchedulingStrategy.RT_EDF, SchedulingStrategy.RT_LST, SchedulingStrategy.RT_PEDF].includes(schedulingStrategy),
 		[schedulingStrategy]
 	);
 
@@ -265,10 +266,16 @@ const Index: NextPage = () => {
 							SchedulingStrategy.FIFO,
 							SchedulingStrategy.SJF,
 							SchedulingStrategy.SRT,
+							SchedulingStrategy.SJF_PREDICTED,
+							SchedulingStrategy.SRT_PREDICTED,
 							SchedulingStrategy.MLF,
 							SchedulingStrategy.RT_FIFO,
 							SchedulingStrategy.RT_EDF,
-							SchedulingStrategy.RT_LST
+							SchedulingStrategy.RT_LST,
+							SchedulingStrategy.RT_PEDF,
+							SchedulingStrategy.CFS,
+							SchedulingStrategy.LOTTERY,
+							SchedulingStrategy.STRIDE
 						].map((strategy) => ({
 							value: strategy,
 							label: prettyStrategy(strategy)
@@ -216,13 +216,13 @@ export class OSEngine {
 		return [...this.programs.keys()];
 	}
 
-	public spawn(program: string, deadline: number): void {
+	public spawn(program: string, deadline: number, nice: number = 0, tickets: number = 0): void {
 		if (!this.programs.has(program)) {
 			console.error('Unknown program', program);
 			return;
 		}
 
-		this.wasmEngine.spawn(program, deadline);
+		this.wasmEngine.spawn(program, deadline, nice, tickets);
 	}
 
 	public dispatch(program: string, period: number, deadline: number, start: number): void {
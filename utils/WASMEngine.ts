@@ -41,7 +41,7 @@ export interface WASMModule {
 
 		loadProgram(instructionList: Ptr<Instruction[]>, size: number, name: Ptr<string>): void;
 		getProgramLocation(name: number): number;
-		spawn(name: Ptr<string>, deadline: number): number;
+		spawn(name: Ptr<string>, deadline: number, nice: number, tickets: number): number;
 		dispatch(name: Ptr<string>, period: number, deadline: number, start: number): number;
 		allocInstructionList(size: number): Ptr<Instruction[]>;
 		allocString(size: number): Ptr<string>;
@@ -89,11 +89,11 @@ export class WASMEngine {
 		this.module.wasmExports.freeString(strPtr);
 	}
 
-	public spawn(name: string, deadline: number): number {
+	public spawn(name: string, deadline: number, nice: number = 0, tickets: number = 0): number {
 		const strPtr = this.module.wasmExports.allocString(name.length);
 		this.memory.writeString(strPtr, name);
 
-		const pid = this.module.wasmExports.spawn(strPtr, deadline);
+		const pid = this.module.wasmExports.spawn(strPtr, deadline, nice, tickets);
 
 		this.module.wasmExports.freeString(strPtr);
 
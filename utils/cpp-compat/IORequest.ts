@@ -1,7 +1,7 @@
 import { Memory } from '../Memory';
 
 export class IORequest {
-	public static readonly SIZE = 8;
+	public static readonly SIZE = 20;
 
 	private _pid: number = -1;
 	private _duration: number = -1;
@@ -17,7 +17,8 @@ export enum StepAction {
 	BEGIN_RUN,
 	CONTINUE_RUN,
 	HANDLE_SYSCALL,
-	SERVICE_REQUEST
+	SERVICE_REQUEST,
+	CONTEXT_SWITCH
 }
 
 export enum SchedulingStrategy {
@@ -27,7 +28,13 @@ export enum SchedulingStrategy {
 	MLF,
 	RT_FIFO,
 	RT_EDF,
-	RT_LST
+	RT_LST,
+	CFS,
+	LOTTERY,
+	STRIDE,
+	SJF_PREDICTED,
+	SRT_PREDICTED,
+	RT_PEDF
 }
 
 export enum Opcode {
@@ -43,6 +43,18 @@ export function prettyStrategy(strategy: SchedulingStrategy): string {
 			return 'Real-Time Earliest Deadline First';
 		case SchedulingStrategy.RT_LST:
 			return 'Real-Time Least Slack Time';
+		case SchedulingStrategy.CFS:
+			return 'Completely Fair Scheduler';
+		case SchedulingStrategy.LOTTERY:
+			return 'Lottery';
+		case SchedulingStrategy.STRIDE:
+			return 'Stride';
+		case SchedulingStrategy.SJF_PREDICTED:
+			return 'Shortest (Predicted) Job First';
+		case SchedulingStrategy.SRT_PREDICTED:
+			return 'Shortest (Predicted) Remaining Time';
+		case SchedulingStrategy.RT_PEDF:
+			return 'Real-Time Partitioned Earliest Deadline First';
 		default:
 			return 'whoops...';
 	}